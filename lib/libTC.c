@@ -24,6 +24,8 @@
 #include <math.h>	// round()
 
 #include "libTC.h"
+#include "tcStats.h"
+#include "tcRational.h"
 
 
 
@@ -53,6 +55,14 @@ static rational_t TC_FPS[] = {
 	{0x00000078, 0x00000001}   // TC_120        120/1
 };
 
+/*
+ *	round( TC_FPS ), the frame count of one timecode second
+ */
+
+static const uint8_t TC_NOMINAL_FPS[] = {
+	0, 24, 24, 25, 30, 30, 30, 48, 48, 50, 60, 60, 60, 72, 96, 100, 120
+};
+
 /*
 static char *TC_FORMAT_STR[] = {
 	"unknown",
@@ -81,10 +91,26 @@ static char *TC_FORMAT_STR[] = {
 static void unitValueToFrames( struct timecode *tc )
 {
 
-	float fps      = rationalToFloat( TC_FPS[tc->format] );
-	float unitRate = rationalToFloat( tc->unitRate       );
+	/*
+	 *	frames = ( unitValue + 1/2 ) * fps / unitRate, truncated : the frame
+	 *	holding the value. Computed with integers only, a float conversion
+	 *	loses about 8 bits of a 4e9 sample count.
+	 *
+	 *	The half unit bias is for frame starts that don't fall on a unit,
+	 *	which recorders store rounded to nearest (see notes) : 172799827 is
+	 *	01:00:00:00 in 29.97DF at 48 kHz, whose exact start is 172799827.2.
+	 */
+
+	if ( tc->unitRate.numerator <= 0 || tc->unitRate.denominator <= 0 )
+	{
+		tc->frameNumber = 0;
+		return;
+	}
 
-	tc->frameNumber = (uint32_t)( tc->unitValue / ( unitRate / fps ) );
+	uint64_t num = (uint64_t)TC_FPS[tc->format].numerator   * (uint64_t)tc->unitRate.denominator;
+	uint64_t den = (uint64_t)TC_FPS[tc->format].denominator * (uint64_t)tc->unitRate.numerator;
+
+	tc->frameNumber = (uint32_t)tc_muldiv( tc->unitValue, num, den, num / 2 );
 
 }
 
@@ -93,6 +119,8 @@ static void unitValueToFrames( struct timecode *tc )
 
 static void hmsfToString( struct timecode *tc )
 {
+	TC_STATS_BEGIN( TC_STATS_HMSF_TO_STRING );
+
 	char string[16];
 
   snprintf( string, 16, "%02u%c%02u%c%02u%c%02u",
@@ -110,6 +138,8 @@ static void hmsfToString( struct timecode *tc )
 	{
 		strcpy( tc->string, string );
 	}
+
+	TC_STATS_END( TC_STATS_HMSF_TO_STRING );
 }
 
 
@@ -132,6 +162,8 @@ static void StringToHmsf( struct timecode *tc )
 static void hmsfToFrames( struct timecode *tc )
 {
 
+	TC_STATS_BEGIN( TC_STATS_HMSF_TO_FRAMES );
+
 	float fps = round(rationalToFloat( TC_FPS[tc->format] ));
 
 	uint32_t dropFrames = 0;
@@ -152,6 +184,8 @@ static void hmsfToFrames( struct timecode *tc )
 					  ( tc->frames )             - \
 					    dropFrames;
 
+	TC_STATS_END( TC_STATS_HMSF_TO_FRAMES );
+
 }
 
 
@@ -160,6 +194,8 @@ static void hmsfToFrames( struct timecode *tc )
 static void framesToHmsf( struct timecode *tc )
 {
 
+	TC_STATS_BEGIN( TC_STATS_FRAMES_TO_HMSF );
+
 	int32_t frameNumber = abs(tc->frameNumber);
 
 	float fps = round(rationalToFloat( TC_FPS[tc->format] ));
@@ -183,7 +219,7 @@ static void framesToHmsf( struct timecode *tc )
 
 		if ( tc->noRollover == 0 )
 		{
-			uint32_t frameNumber24h = (((((fps*60))*10) - (2*9)) * 6 * 24); // 2589408 frames @ 29.97fps
+			uint32_t frameNumber24h = tc_frames_per_day( tc->format );
 
 			frameNumber = frameNumber % frameNumber24h;
 		}
@@ -229,7 +265,7 @@ static void framesToHmsf( struct timecode *tc )
 		 *	Rollover if frameNumber > 23:59:59:29
 		 */
 
-		uint32_t frameNumber24h = (((fps*60)*10) * 6 * 24);
+		uint32_t frameNumber24h = tc_frames_per_day( tc->format );
 
 		frameNumber = frameNumber % frameNumber24h;
 
@@ -241,6 +277,8 @@ static void framesToHmsf( struct timecode *tc )
 	tc->minutes = ((frameNumber / (uint32_t)fps) / 60) % 60;
 	tc->hours   = ((frameNumber / (uint32_t)fps) / 60) / 60;
 
+	TC_STATS_END( TC_STATS_FRAMES_TO_HMSF );
+
 }
 
 
@@ -248,8 +286,11 @@ static void framesToHmsf( struct timecode *tc )
 
 int tc_add( struct timecode *tc_a, struct timecode *tc_b )
 {
+	TC_STATS_BEGIN( TC_STATS_ADD );
+
 	if ( tc_a->format != tc_b->format )
 	{
+		TC_STATS_END( TC_STATS_ADD );
 		return -1;
 	}
 
@@ -259,6 +300,8 @@ int tc_add( struct timecode *tc_a, struct timecode *tc_b )
 
 	hmsfToString( tc_a );
 
+	TC_STATS_END( TC_STATS_ADD );
+
 	return 0;
 }
 
@@ -267,8 +310,11 @@ int tc_add( struct timecode *tc_a, struct timecode *tc_b )
 
 int tc_sub( struct timecode *tc_a, struct timecode *tc_b )
 {
+	TC_STATS_BEGIN( TC_STATS_SUB );
+
 	if ( tc_a->format != tc_b->format )
 	{
+		TC_STATS_END( TC_STATS_SUB );
 		return -1;
 	}
 
@@ -278,6 +324,8 @@ int tc_sub( struct timecode *tc_a, struct timecode *tc_b )
 
 	hmsfToString( tc_a );
 
+	TC_STATS_END( TC_STATS_SUB );
+
 	return 0;
 }
 
@@ -286,10 +334,14 @@ int tc_sub( struct timecode *tc_a, struct timecode *tc_b )
 
 void tc_convert( struct timecode *tc, enum TC_FORMAT format )
 {
+	TC_STATS_BEGIN( TC_STATS_CONVERT );
+
 	tc->format  = format;
 
 	framesToHmsf( tc );
 	hmsfToString( tc );
+
+	TC_STATS_END( TC_STATS_CONVERT );
 }
 
 
@@ -297,6 +349,8 @@ void tc_convert( struct timecode *tc, enum TC_FORMAT format )
 
 void tc_convert_frames( struct timecode *tc, enum TC_FORMAT format )
 {
+	TC_STATS_BEGIN( TC_STATS_CONVERT_FRAMES );
+
 	tc->format  = format;
 
 	if ( tc->frames > round(rationalToFloat(TC_FPS[format])) )
@@ -307,6 +361,8 @@ void tc_convert_frames( struct timecode *tc, enum TC_FORMAT format )
 	hmsfToFrames( tc );
 	framesToHmsf( tc );
 	hmsfToString( tc );
+
+	TC_STATS_END( TC_STATS_CONVERT_FRAMES );
 }
 
 
@@ -344,9 +400,193 @@ enum TC_FORMAT tc_fps2format( float fps, uint8_t isDrop )
 
 
 
+rational_t tc_format_rate( enum TC_FORMAT format )
+{
+	if ( format >= TC_FORMAT_LEN )
+	{
+		format = TC_FORMAT_UNK;
+	}
+
+	return TC_FPS[format];
+}
+
+
+
+
+uint16_t tc_format_fps( enum TC_FORMAT format )
+{
+	rational_t rate = tc_format_rate( format );
+
+	return ( rate.numerator + rate.denominator / 2 ) / rate.denominator;
+}
+
+
+
+
+uint32_t tc_frames_per_day( enum TC_FORMAT format )
+{
+	uint32_t fps = tc_format_fps( format );
+
+	if ( format == TC_29_97_DF || format == TC_59_94_DF )
+	{
+		return ( fps * 60 * 10 - 2 * 9 ) * 6 * 24;  // 2589408 frames @ 29.97fps
+	}
+
+	return fps * 60 * 60 * 24;
+}
+
+
+
+
+static inline int32_t floorDiv( int32_t a, int32_t b )
+{
+	return ( a >= 0 ) ? a / b : -( ( -a + b - 1 ) / b );
+}
+
+
+
+
+static inline void putTwoDigits( char *str, uint16_t value )
+{
+	str[0] = '0' + value / 10;
+	str[1] = '0' + value % 10;
+}
+
+
+
+
+void tc_step( struct timecode *tc, int32_t n )
+{
+
+	/*
+	 *	Carries frames into seconds, minutes and hours without going through
+	 *	framesToHmsf(), and only rewrites the digits that changed.
+	 *
+	 *	Anything off the common path goes through the full decomposition :
+	 *	negative frame numbers, strings not in the hh:mm:ss:ff layout (hours
+	 *	above 99, frames above 99), and minute changes in drop-frame, so the
+	 *	drop rule stays defined in framesToHmsf() only. 59.94DF always takes
+	 *	the full path, since its frame numbering there doesn't drop on
+	 *	minute boundaries only.
+	 */
+
+	int32_t  frameNumber = tc->frameNumber + n;
+
+	int32_t  fps  = ( tc->format < TC_FORMAT_LEN ) ? TC_NOMINAL_FPS[tc->format] : 0;
+
+	uint8_t  drop = ( tc->format == TC_29_97_DF );
+
+	char    *str  = tc->string;
+
+	if ( tc->frameNumber < 0 || frameNumber < 0 || fps == 0 || fps > 100 ||
+	     tc->format == TC_59_94_DF || tc->hours > 99 || tc->frames > 99 ||
+	     str[11] != '\0' || str[2] != TC_SEP || str[8] != ( ( drop ) ? TC_SEP_DROP : TC_SEP ) )
+	{
+		goto full;
+	}
+
+
+	int32_t f = tc->frames + n;
+	int32_t s = tc->seconds;
+	int32_t m = tc->minutes;
+	int32_t h = tc->hours;
+
+	if ( f < 0 || f >= fps )
+	{
+		int32_t carry = floorDiv( f, fps );
+
+		f -= carry * fps;
+		s += carry;
+
+		if ( s < 0 || s >= 60 )
+		{
+			if ( drop )
+			{
+				goto full;
+			}
+
+			carry = floorDiv( s, 60 );
+
+			s -= carry * 60;
+			m += carry;
+
+			if ( m < 0 || m >= 60 )
+			{
+				carry = floorDiv( m, 60 );
+
+				m -= carry * 60;
+				h += carry;
+
+				if ( tc->noRollover == 0 )
+				{
+					h = ( ( h % 24 ) + 24 ) % 24;
+				}
+				else if ( h > 99 )
+				{
+					goto full;
+				}
+
+				tc->hours = h;
+				putTwoDigits( str, h );
+			}
+
+			tc->minutes = m;
+			putTwoDigits( str + 3, m );
+		}
+
+		tc->seconds = s;
+		putTwoDigits( str + 6, s );
+	}
+
+	if ( drop && s == 0 && f < 2 && ( m % 10 ) != 0 )
+	{
+		/* stepped back into the dropped frame numbers */
+
+		goto full;
+	}
+
+	tc->frames = f;
+	putTwoDigits( str + 9, f );
+
+	tc->frameNumber = frameNumber;
+
+	return;
+
+
+full:
+
+	tc->frameNumber = frameNumber;
+
+	framesToHmsf( tc );
+
+	hmsfToString( tc );
+
+}
+
+
+
+
+void tc_next( struct timecode *tc )
+{
+	tc_step( tc, 1 );
+}
+
+
+
+
+void tc_prev( struct timecode *tc )
+{
+	tc_step( tc, -1 );
+}
+
+
+
+
 void tc_set_by_string( struct timecode *tc, const char *str, enum TC_FORMAT format )
 {
 
+	TC_STATS_BEGIN( TC_STATS_SET_BY_STRING );
+
 	tc->format = format;
 
 	// tc->noRollover = 0;
@@ -358,6 +598,8 @@ void tc_set_by_string( struct timecode *tc, const char *str, enum TC_FORMAT form
 
 	hmsfToFrames( tc );
 
+	TC_STATS_END( TC_STATS_SET_BY_STRING );
+
 }
 
 
@@ -366,6 +608,8 @@ void tc_set_by_string( struct timecode *tc, const char *str, enum TC_FORMAT form
 void tc_set_by_frames( struct timecode *tc, uint32_t frameNumber, enum TC_FORMAT format )
 {
 
+	TC_STATS_BEGIN( TC_STATS_SET_BY_FRAMES );
+
 	/* TODO test or set to zero */
 
 	tc->unitValue = frameNumber;
@@ -381,6 +625,8 @@ void tc_set_by_frames( struct timecode *tc, uint32_t frameNumber, enum TC_FORMAT
 
 	hmsfToString( tc );
 
+	TC_STATS_END( TC_STATS_SET_BY_FRAMES );
+
 }
 
 
@@ -389,6 +635,8 @@ void tc_set_by_frames( struct timecode *tc, uint32_t frameNumber, enum TC_FORMAT
 void tc_set_by_hmsf( struct timecode *tc, uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames, enum TC_FORMAT format )
 {
 
+	TC_STATS_BEGIN( TC_STATS_SET_BY_HMSF );
+
 	tc->hours   = hours;
 	tc->minutes = minutes;
 	tc->seconds = seconds;
@@ -403,6 +651,27 @@ void tc_set_by_hmsf( struct timecode *tc, uint16_t hours, uint16_t minutes, uint
 
 	hmsfToString( tc );
 
+	TC_STATS_END( TC_STATS_SET_BY_HMSF );
+
+}
+
+
+
+
+int32_t tc_hmsf_to_frames( uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames, enum TC_FORMAT format )
+{
+	struct timecode tc;
+
+	tc.hours   = hours;
+	tc.minutes = minutes;
+	tc.seconds = seconds;
+	tc.frames  = frames;
+
+	tc.format  = format;
+
+	hmsfToFrames( &tc );
+
+	return tc.frameNumber;
 }
 
 
@@ -411,6 +680,8 @@ void tc_set_by_hmsf( struct timecode *tc, uint16_t hours, uint16_t minutes, uint
 void tc_set_by_unitValue( struct timecode *tc, uint64_t unitValue, rational_t *unitRate, enum TC_FORMAT format )
 {
 
+	TC_STATS_BEGIN( TC_STATS_SET_BY_UNITVALUE );
+
 	tc->unitValue = unitValue;
 	tc->unitRate  = *unitRate;
 
@@ -425,4 +696,104 @@ void tc_set_by_unitValue( struct timecode *tc, uint64_t unitValue, rational_t *u
 
 	hmsfToString( tc );
 
+	TC_STATS_END( TC_STATS_SET_BY_UNITVALUE );
+
+}
+
+
+
+
+/*
+ *	unitValue = frames * unitRate / fps. The ratio is reduced once, so the
+ *	batch loop is a multiply and a division per event, in 64 bits as long as
+ *	the product fits (any 24 hours at any sample rate).
+ */
+
+struct unitRatio
+{
+	uint64_t num;
+	uint64_t den;
+	uint64_t bias;
+	uint64_t limit;
+};
+
+
+static int frameUnitRatio( struct unitRatio *r, const rational_t *unitRate, enum TC_FORMAT format, enum TC_ROUNDING rounding )
+{
+	rational_t fps = tc_format_rate( format );
+
+	if ( unitRate->numerator <= 0 || unitRate->denominator <= 0 || fps.numerator <= 0 )
+	{
+		return -1;
+	}
+
+	r->num = (uint64_t)unitRate->numerator   * (uint64_t)fps.denominator;
+	r->den = (uint64_t)unitRate->denominator * (uint64_t)fps.numerator;
+
+	uint64_t g = tc_gcd( r->num, r->den );
+
+	r->num /= g;
+	r->den /= g;
+
+	switch ( rounding )
+	{
+		case TC_ROUND_FLOOR:  r->bias = 0;              break;
+		case TC_ROUND_CEIL:   r->bias = r->den - 1;     break;
+		default:              r->bias = r->den / 2;     break;
+	}
+
+	r->limit = ( UINT64_MAX - r->bias ) / r->num;
+
+	return 0;
+}
+
+
+static inline uint64_t framesToUnitValue( const struct unitRatio *r, uint64_t frames )
+{
+	if ( frames <= r->limit )
+	{
+		return ( frames * r->num + r->bias ) / r->den;
+	}
+
+	return tc_muldiv( frames, r->num, r->den, r->bias );
+}
+
+
+
+
+uint64_t tc_get_unitValue( const struct timecode *tc, const rational_t *unitRate, enum TC_ROUNDING rounding )
+{
+	struct unitRatio r;
+
+	if ( tc->frameNumber < 0 || frameUnitRatio( &r, unitRate, tc->format, rounding ) < 0 )
+	{
+		return 0;
+	}
+
+	return framesToUnitValue( &r, (uint64_t)tc->frameNumber );
+}
+
+
+
+
+void tc_frames_to_unitValues( const uint32_t *frames, uint64_t *values, size_t count, const rational_t *unitRate, enum TC_FORMAT format, enum TC_ROUNDING rounding )
+{
+	struct unitRatio r;
+
+	size_t i = 0;
+
+	if ( frameUnitRatio( &r, unitRate, format, rounding ) < 0 )
+	{
+		for ( ; i < count; i++ )
+		{
+			values[i] = 0;
+		}
+
+		return;
+	}
+
+	for ( ; i < count; i++ )
+	{
+		values[i] = framesToUnitValue( &r, frames[i] );
+	}
 }
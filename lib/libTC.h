@@ -23,6 +23,10 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 #define TC_SEP          ':'
 #define TC_SEP_DROP     ';'
@@ -78,6 +82,15 @@ enum TC_FORMAT {
 
 
 
+enum TC_ROUNDING {
+
+	TC_ROUND_NEAREST = 0,   // half up
+	TC_ROUND_FLOOR,
+	TC_ROUND_CEIL
+};
+
+
+
 // typedef uint64_t rational_t;
 typedef struct rational_t
 {
@@ -162,6 +175,12 @@ void tc_convert_frames( struct timecode *tc, enum TC_FORMAT format );
 
 enum TC_FORMAT tc_fps2format( float fps, uint8_t isDrop );
 
+rational_t tc_format_rate( enum TC_FORMAT format );  // exact frame rate, eg. 30000/1001
+
+uint16_t tc_format_fps( enum TC_FORMAT format );     // nominal frame rate, eg. 30
+
+uint32_t tc_frames_per_day( enum TC_FORMAT format ); // frame numbers before the 24 hours rollover
+
 
 void tc_set_by_string( struct timecode *tc, const char *str, enum TC_FORMAT format );
 
@@ -172,6 +191,45 @@ void tc_set_by_hmsf( struct timecode *tc, uint16_t hours, uint16_t minutes, uint
 void tc_set_by_unitValue( struct timecode *tc, uint64_t unitValue, rational_t *unitRate, enum TC_FORMAT format );
 
 
+/**
+ *	Frame number of hh:mm:ss:ff, as tc_set_by_hmsf() computes it, without
+ *	filling a struct timecode. For scanners reading long lists of labels.
+ */
+
+int32_t tc_hmsf_to_frames( uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames, enum TC_FORMAT format );
+
+
+/**
+ *	Inverse of tc_set_by_unitValue() : position of the start of the frame in
+ *	unitRate units, exact and rounded as asked. With TC_ROUND_NEAREST and a
+ *	unitRate above the frame rate, tc_set_by_unitValue() gives the same
+ *	frame back. Negative frame numbers give 0.
+ */
+
+uint64_t tc_get_unitValue( const struct timecode *tc, const rational_t *unitRate, enum TC_ROUNDING rounding );
+
+/**
+ *	Batch version for event lists : values[i] is the position of frames[i]
+ *	of format.
+ */
+
+void tc_frames_to_unitValues( const uint32_t *frames, uint64_t *values, size_t count, const rational_t *unitRate, enum TC_FORMAT format, enum TC_ROUNDING rounding );
+
+
+/**
+ *	Incremental stepping : moves an already set timecode by n frames (or one
+ *	frame forward / backward), carrying hh:mm:ss:ff and updating the string
+ *	digits in place. Same result as tc_set_by_frames( frameNumber + n ), in a
+ *	few nanoseconds for the common case.
+ */
+
+void tc_step( struct timecode *tc, int32_t n );
+
+void tc_next( struct timecode *tc );
+
+void tc_prev( struct timecode *tc );
+
+
 
 /*
  *
@@ -210,4 +268,8 @@ void tc_set_by_unitValue( struct timecode *tc, uint64_t unitValue, rational_t *u
  *	@}
  */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // ! __libTC_h__
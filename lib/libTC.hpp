@@ -0,0 +1,457 @@
+#ifndef __libTC_hpp__
+#define __libTC_hpp__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *	Header-only C++17 layer over LibTC.
+ *
+ *	Timecode<Format> carries its format in the type, so the nominal rate, the
+ *	drop-frame rule and the day length are compile-time constants and every
+ *	operation below can be evaluated in a constant expression. The arithmetic
+ *	is the one of lib/libTC.c (framesToHmsf(), hmsfToFrames(), hmsfToString()),
+ *	frame for frame, so a Timecode<F> and a struct timecode set from the same
+ *	value always agree.
+ *
+ *	Mixing formats never happens implicitly : convert<G>() keeps the frame
+ *	number like tc_convert(), convert_frames<G>() keeps hh:mm:ss:ff like
+ *	tc_convert_frames(). Values whose format is only known at runtime go
+ *	through libtc::dispatch().
+ */
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "libTC.h"
+
+
+namespace libtc {
+
+
+
+template <enum TC_FORMAT F>
+struct format_traits;
+
+#define LIBTC_FORMAT_TRAITS( fmt, num, den, nominal, drop ) \
+	template <> struct format_traits<fmt> { \
+		static constexpr int32_t  numerator   = num;     \
+		static constexpr int32_t  denominator = den;     \
+		static constexpr uint32_t fps         = nominal; \
+		static constexpr bool     isDrop      = drop;    \
+	}
+
+LIBTC_FORMAT_TRAITS( TC_23_98,       24000, 1001,  24, false );
+LIBTC_FORMAT_TRAITS( TC_24,             24,    1,  24, false );
+LIBTC_FORMAT_TRAITS( TC_25,             25,    1,  25, false );
+LIBTC_FORMAT_TRAITS( TC_29_97_NDF,   30000, 1001,  30, false );
+LIBTC_FORMAT_TRAITS( TC_29_97_DF,    30000, 1001,  30, true  );
+LIBTC_FORMAT_TRAITS( TC_30,             30,    1,  30, false );
+LIBTC_FORMAT_TRAITS( TC_47_95,       48000, 1001,  48, false );
+LIBTC_FORMAT_TRAITS( TC_48,             48,    1,  48, false );
+LIBTC_FORMAT_TRAITS( TC_50,             50,    1,  50, false );
+LIBTC_FORMAT_TRAITS( TC_59_94_NDF,   60000, 1001,  60, false );
+LIBTC_FORMAT_TRAITS( TC_59_94_DF,    60000, 1001,  60, true  );
+LIBTC_FORMAT_TRAITS( TC_60,             60,    1,  60, false );
+LIBTC_FORMAT_TRAITS( TC_72,             72,    1,  72, false );
+LIBTC_FORMAT_TRAITS( TC_96,             96,    1,  96, false );
+LIBTC_FORMAT_TRAITS( TC_100,           100,    1, 100, false );
+LIBTC_FORMAT_TRAITS( TC_120,           120,    1, 120, false );
+
+#undef LIBTC_FORMAT_TRAITS
+
+
+
+struct hmsf
+{
+	uint16_t hours;
+	uint16_t minutes;
+	uint16_t seconds;
+	uint16_t frames;
+};
+
+
+/*
+ *	hh:mm:ss:ff as written by hmsfToString(), without the null terminator.
+ */
+
+struct tc_string
+{
+	std::array<char, 32> data;
+	std::size_t          length;
+
+	std::string str() const { return std::string( data.data(), length ); }
+};
+
+
+
+namespace detail {
+
+template <enum TC_FORMAT F>
+constexpr uint32_t frames_per_day()
+{
+	using T = format_traits<F>;
+
+	/* rollover modulus used by framesToHmsf() */
+
+	return ( T::isDrop ) ? ( ( T::fps * 60 * 10 ) - ( 2 * 9 ) ) * 6 * 24
+	                     : ( T::fps * 60 * 10 ) * 6 * 24;
+}
+
+
+template <enum TC_FORMAT F>
+constexpr hmsf frames_to_hmsf( int32_t frameNumber, bool noRollover )
+{
+	using T = format_traits<F>;
+
+	uint32_t fn = ( frameNumber < 0 ) ? (uint32_t)0 - (uint32_t)frameNumber : (uint32_t)frameNumber;
+
+	if ( noRollover == false )
+	{
+		fn = fn % frames_per_day<F>();
+	}
+
+	if constexpr ( T::isDrop )
+	{
+		constexpr int32_t framesPerMinute    = ( T::fps * 60 ) - 2;
+		constexpr int32_t framesPer10Minutes = ( framesPerMinute * 10 ) + 2;
+
+		int32_t chunksOf10Minutes = (int32_t)fn / framesPer10Minutes;
+		int32_t chunksOf1Minute   = ( (int32_t)( fn % framesPer10Minutes ) - 2 ) / framesPerMinute;
+
+		uint32_t dropFrames = ( 2 * 9 * chunksOf10Minutes ) + ( ( chunksOf1Minute < 0 ) ? 0 : 2 * chunksOf1Minute );
+
+		if constexpr ( F == TC_59_94_DF )
+		{
+			dropFrames *= 2;
+		}
+
+		fn += dropFrames;
+	}
+
+	return hmsf {
+		(uint16_t)( ( fn / T::fps ) / 60 / 60 ),
+		(uint16_t)( ( ( fn / T::fps ) / 60 ) % 60 ),
+		(uint16_t)( ( fn / T::fps ) % 60 ),
+		(uint16_t)( fn % T::fps )
+	};
+}
+
+
+template <enum TC_FORMAT F>
+constexpr int32_t hmsf_to_frames( const hmsf &t )
+{
+	using T = format_traits<F>;
+
+	int64_t dropFrames = 0;
+
+	if constexpr ( T::isDrop )
+	{
+		dropFrames = ( t.hours * ( 2 * 9 * 6 ) ) + ( ( t.minutes / 10 ) * ( 2 * 9 ) ) + ( ( t.minutes % 10 ) * 2 );
+	}
+
+	return (int32_t)( ( (int64_t)t.hours * 3600 * T::fps ) +
+	                  ( (int64_t)t.minutes * 60 * T::fps ) +
+	                  ( (int64_t)t.seconds * T::fps ) +
+	                  t.frames -
+	                  dropFrames );
+}
+
+
+constexpr void put_number( tc_string &s, uint32_t value )
+{
+	char digits[10] = {};
+	int  n = 0;
+
+	do
+	{
+		digits[n++] = '0' + ( value % 10 );
+		value /= 10;
+	}
+	while ( value > 0 );
+
+	if ( n < 2 )
+	{
+		digits[n++] = '0';
+	}
+
+	while ( n > 0 )
+	{
+		s.data[s.length++] = digits[--n];
+	}
+}
+
+
+template <enum TC_FORMAT F>
+constexpr tc_string hmsf_to_string( const hmsf &t, int32_t frameNumber )
+{
+	tc_string s { {}, 0 };
+
+	if ( frameNumber < 0 )
+	{
+		s.data[s.length++] = '-';
+	}
+
+	put_number( s, ( t.hours   <= 9999 ) ? t.hours   : 0 );  s.data[s.length++] = TC_SEP;
+	put_number( s, ( t.minutes <=   99 ) ? t.minutes : 0 );  s.data[s.length++] = TC_SEP;
+	put_number( s, ( t.seconds <=   99 ) ? t.seconds : 0 );  s.data[s.length++] = format_traits<F>::isDrop ? TC_SEP_DROP : TC_SEP;
+	put_number( s, ( t.frames  <=  999 ) ? t.frames  : 0 );
+
+	return s;
+}
+
+
+/* sscanf( "%hu" ) : optional sign, negative values wrap */
+
+constexpr bool parse_number( const char *&str, uint16_t &value )
+{
+	bool negative = ( *str == '-' );
+
+	if ( *str == '-' || *str == '+' )
+	{
+		str++;
+	}
+
+	if ( *str < '0' || *str > '9' )
+	{
+		return false;
+	}
+
+	uint32_t v = 0;
+
+	while ( *str >= '0' && *str <= '9' )
+	{
+		v = v * 10 + ( *str++ - '0' );
+	}
+
+	value = (uint16_t)( ( negative ) ? 0 - v : v );
+
+	return true;
+}
+
+} // namespace detail
+
+
+
+template <enum TC_FORMAT F>
+class Timecode
+{
+public:
+
+	static constexpr enum TC_FORMAT format      = F;
+	static constexpr int32_t        numerator   = format_traits<F>::numerator;
+	static constexpr int32_t        denominator = format_traits<F>::denominator;
+	static constexpr uint32_t       fps         = format_traits<F>::fps;
+	static constexpr bool           isDrop      = format_traits<F>::isDrop;
+	static constexpr uint32_t       framesPerDay = detail::frames_per_day<F>();
+
+
+	constexpr Timecode() = default;
+
+	constexpr explicit Timecode( int32_t frameNumber, bool noRollover = false )
+		: frameNumber_( frameNumber ), noRollover_( noRollover ) {}
+
+
+	/* tc_set_by_hmsf() */
+
+	static constexpr Timecode from_hmsf( uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames, bool noRollover = false )
+	{
+		return Timecode( detail::hmsf_to_frames<F>( hmsf { hours, minutes, seconds, frames } ), noRollover );
+	}
+
+
+	/* tc_set_by_string() : four numbers split by any single character */
+
+	static constexpr Timecode from_string( const char *str, bool noRollover = false )
+	{
+		hmsf t {};
+
+		if ( detail::parse_number( str, t.hours ) && *str && *++str &&
+		     detail::parse_number( str, t.minutes ) && *str && *++str &&
+		     detail::parse_number( str, t.seconds ) && *str && *++str )
+		{
+			detail::parse_number( str, t.frames );
+		}
+
+		return Timecode( detail::hmsf_to_frames<F>( t ), noRollover );
+	}
+
+
+	/* struct timecode interop */
+
+	static Timecode from_c( const struct timecode &tc )
+	{
+		return Timecode( tc.frameNumber, tc.noRollover != 0 );
+	}
+
+	struct timecode to_c() const
+	{
+		struct timecode tc {};
+		hmsf t = to_hmsf();
+
+		tc.unitValue             = (uint32_t)frameNumber_;
+		tc.unitRate.numerator    = numerator;
+		tc.unitRate.denominator  = denominator;
+		tc.frameNumber           = frameNumber_;
+		tc.hours                 = t.hours;
+		tc.minutes               = t.minutes;
+		tc.seconds               = t.seconds;
+		tc.frames                = t.frames;
+		tc.format                = F;
+		tc.noRollover            = noRollover_;
+
+		tc_string s = to_string();
+
+		for ( std::size_t i = 0; i < s.length; i++ )
+		{
+			tc.string[i] = s.data[i];
+		}
+
+		return tc;
+	}
+
+
+	constexpr int32_t frame_number() const { return frameNumber_; }
+
+	constexpr bool no_rollover() const { return noRollover_; }
+
+	constexpr hmsf to_hmsf() const { return detail::frames_to_hmsf<F>( frameNumber_, noRollover_ ); }
+
+	constexpr tc_string to_string() const { return detail::hmsf_to_string<F>( to_hmsf(), frameNumber_ ); }
+
+	std::string str() const { return to_string().str(); }
+
+
+	/* tc_convert() : same frame number, hh:mm:ss:ff of the new format */
+
+	template <enum TC_FORMAT G>
+	constexpr Timecode<G> convert() const
+	{
+		return Timecode<G>( frameNumber_, noRollover_ );
+	}
+
+
+	/* tc_convert_frames() : same hh:mm:ss:ff, frame number of the new format */
+
+	template <enum TC_FORMAT G>
+	constexpr Timecode<G> convert_frames() const
+	{
+		hmsf t = to_hmsf();
+
+		if ( t.frames > format_traits<G>::fps )
+		{
+			t.frames = format_traits<G>::fps - 1;
+		}
+
+		return Timecode<G>( detail::hmsf_to_frames<G>( t ), noRollover_ );
+	}
+
+
+	/* tc_add() / tc_sub() : operands must share the format */
+
+	constexpr Timecode & operator+=( const Timecode &b ) { frameNumber_ += b.frameNumber_; return *this; }
+	constexpr Timecode & operator-=( const Timecode &b ) { frameNumber_ -= b.frameNumber_; return *this; }
+
+	constexpr Timecode & operator+=( int32_t frames ) { frameNumber_ += frames; return *this; }
+	constexpr Timecode & operator-=( int32_t frames ) { frameNumber_ -= frames; return *this; }
+
+	friend constexpr Timecode operator+( Timecode a, const Timecode &b ) { return a += b; }
+	friend constexpr Timecode operator-( Timecode a, const Timecode &b ) { return a -= b; }
+	friend constexpr Timecode operator+( Timecode a, int32_t frames ) { return a += frames; }
+	friend constexpr Timecode operator-( Timecode a, int32_t frames ) { return a -= frames; }
+
+	template <enum TC_FORMAT G, typename = std::enable_if_t<G != F>>
+	Timecode & operator+=( const Timecode<G> & ) = delete;
+
+	template <enum TC_FORMAT G, typename = std::enable_if_t<G != F>>
+	Timecode & operator-=( const Timecode<G> & ) = delete;
+
+	template <enum TC_FORMAT G, typename = std::enable_if_t<G != F>>
+	Timecode operator+( const Timecode<G> & ) const = delete;
+
+	template <enum TC_FORMAT G, typename = std::enable_if_t<G != F>>
+	Timecode operator-( const Timecode<G> & ) const = delete;
+
+
+	friend constexpr bool operator==( const Timecode &a, const Timecode &b ) { return a.frameNumber_ == b.frameNumber_; }
+	friend constexpr bool operator!=( const Timecode &a, const Timecode &b ) { return a.frameNumber_ != b.frameNumber_; }
+	friend constexpr bool operator< ( const Timecode &a, const Timecode &b ) { return a.frameNumber_ <  b.frameNumber_; }
+	friend constexpr bool operator<=( const Timecode &a, const Timecode &b ) { return a.frameNumber_ <= b.frameNumber_; }
+	friend constexpr bool operator> ( const Timecode &a, const Timecode &b ) { return a.frameNumber_ >  b.frameNumber_; }
+	friend constexpr bool operator>=( const Timecode &a, const Timecode &b ) { return a.frameNumber_ >= b.frameNumber_; }
+
+
+private:
+
+	int32_t frameNumber_ = 0;
+
+	bool    noRollover_  = false;
+
+};
+
+
+
+template <enum TC_FORMAT F>
+using format_constant = std::integral_constant<enum TC_FORMAT, F>;
+
+
+/*
+ *	Runtime to compile-time dispatch : calls fn( format_constant<F>{} ) with the
+ *	F matching format, so fn can instantiate Timecode<decltype(f)::value>.
+ *	Returns false, without calling fn, for TC_FORMAT_UNK or an invalid value.
+ *
+ *	libtc::dispatch( tc.format, [&]( auto f ) {
+ *		auto t = libtc::Timecode<decltype(f)::value>::from_c( tc );
+ *		...
+ *	});
+ */
+
+template <typename Fn>
+bool dispatch( enum TC_FORMAT format, Fn &&fn )
+{
+	switch ( format )
+	{
+		case TC_23_98:      fn( format_constant<TC_23_98>{} );      return true;
+		case TC_24:         fn( format_constant<TC_24>{} );         return true;
+		case TC_25:         fn( format_constant<TC_25>{} );         return true;
+		case TC_29_97_NDF:  fn( format_constant<TC_29_97_NDF>{} );  return true;
+		case TC_29_97_DF:   fn( format_constant<TC_29_97_DF>{} );   return true;
+		case TC_30:         fn( format_constant<TC_30>{} );         return true;
+		case TC_47_95:      fn( format_constant<TC_47_95>{} );      return true;
+		case TC_48:         fn( format_constant<TC_48>{} );         return true;
+		case TC_50:         fn( format_constant<TC_50>{} );         return true;
+		case TC_59_94_NDF:  fn( format_constant<TC_59_94_NDF>{} );  return true;
+		case TC_59_94_DF:   fn( format_constant<TC_59_94_DF>{} );   return true;
+		case TC_60:         fn( format_constant<TC_60>{} );         return true;
+		case TC_72:         fn( format_constant<TC_72>{} );         return true;
+		case TC_96:         fn( format_constant<TC_96>{} );         return true;
+		case TC_100:        fn( format_constant<TC_100>{} );        return true;
+		case TC_120:        fn( format_constant<TC_120>{} );        return true;
+
+		default:                                                    return false;
+	}
+}
+
+
+} // namespace libtc
+
+#endif // ! __libTC_hpp__
@@ -0,0 +1,586 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcArray.h"
+#include "tcRational.h"
+
+
+
+struct tc_arena_block
+{
+	struct tc_arena_block *next;
+
+	size_t      size;
+	size_t      used;
+
+	unsigned char data[];
+};
+
+
+
+
+void tc_arena_init( struct tc_arena *arena, size_t blockSize )
+{
+	arena->head      = NULL;
+	arena->blockSize = ( blockSize > 0 ) ? blockSize : TC_ARENA_BLOCK_SIZE;
+}
+
+
+
+
+void * tc_arena_alloc( struct tc_arena *arena, size_t size )
+{
+	struct tc_arena_block *block = arena->head;
+
+	if ( block != NULL )
+	{
+		uintptr_t at = ( (uintptr_t)( block->data + block->used ) + TC_ARENA_ALIGN - 1 ) & ~(uintptr_t)( TC_ARENA_ALIGN - 1 );
+
+		size_t offset = at - (uintptr_t)block->data;
+
+		if ( offset <= block->size && size <= block->size - offset )
+		{
+			block->used = offset + size;
+			return (void *)at;
+		}
+	}
+
+
+	/*
+	 *	Doesn't fit the current block : start a new one, large enough for
+	 *	this allocation. The rest of the former block is lost.
+	 */
+
+	size_t blockSize = ( size + TC_ARENA_ALIGN > arena->blockSize ) ? size + TC_ARENA_ALIGN : arena->blockSize;
+
+	if ( blockSize < size )
+	{
+		return NULL;
+	}
+
+	block = malloc( sizeof(struct tc_arena_block) + blockSize );
+
+	if ( block == NULL )
+	{
+		return NULL;
+	}
+
+	block->next = arena->head;
+	block->size = blockSize;
+	block->used = 0;
+
+	arena->head = block;
+
+	return tc_arena_alloc( arena, size );
+}
+
+
+
+
+void tc_arena_release( struct tc_arena *arena )
+{
+	struct tc_arena_block *block = arena->head;
+
+	while ( block != NULL )
+	{
+		struct tc_arena_block *next = block->next;
+
+		free( block );
+
+		block = next;
+	}
+
+	arena->head = NULL;
+}
+
+
+
+
+int tc_array_init( struct tc_array *array, struct tc_arena *arena, size_t capacity )
+{
+	memset( array, 0, sizeof(struct tc_array) );
+
+	array->arena = arena;
+
+	return tc_array_reserve( array, capacity );
+}
+
+
+
+
+int tc_array_reserve( struct tc_array *array, size_t capacity )
+{
+	if ( capacity <= array->capacity )
+	{
+		return 0;
+	}
+
+	if ( capacity > SIZE_MAX / sizeof(int32_t) )
+	{
+		return -1;
+	}
+
+	int32_t *frames     = tc_arena_alloc( array->arena, capacity * sizeof(int32_t) );
+	uint8_t *formats    = tc_arena_alloc( array->arena, capacity );
+	int32_t *remainders = NULL;
+
+	if ( array->remainders != NULL )
+	{
+		remainders = tc_arena_alloc( array->arena, capacity * sizeof(int32_t) );
+	}
+
+	if ( frames == NULL || formats == NULL || ( array->remainders != NULL && remainders == NULL ) )
+	{
+		return -1;
+	}
+
+	if ( array->count > 0 )
+	{
+		memcpy( frames,  array->frames,  array->count * sizeof(int32_t) );
+		memcpy( formats, array->formats, array->count );
+
+		if ( remainders != NULL )
+		{
+			memcpy( remainders, array->remainders, array->count * sizeof(int32_t) );
+		}
+	}
+
+	array->frames     = frames;
+	array->formats    = formats;
+	array->remainders = remainders;
+	array->capacity   = capacity;
+
+	return 0;
+}
+
+
+
+
+int tc_array_set_frames( struct tc_array *array, const int32_t *frames, size_t count, enum TC_FORMAT format )
+{
+	array->count      = 0;
+	array->remainders = NULL;
+
+	if ( tc_array_reserve( array, count ) < 0 )
+	{
+		return -1;
+	}
+
+	memcpy( array->frames, frames, count * sizeof(int32_t) );
+	memset( array->formats, format, count );
+
+	array->count = count;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	"hh:mm:ss:ff" with any separators, the form nearly every list has, is read
+ *	by hand. Anything else goes through tc_set_by_string().
+ */
+
+static inline int isDigit( char c )
+{
+	return ( c >= '0' && c <= '9' );
+}
+
+
+static int32_t stringToFrames( const char *str, enum TC_FORMAT format )
+{
+	struct timecode tc;
+
+	memset( &tc, 0, sizeof(struct timecode) );
+
+	if ( isDigit(str[0]) && isDigit(str[1]) &&
+	     isDigit(str[3]) && isDigit(str[4]) &&
+	     isDigit(str[6]) && isDigit(str[7]) &&
+	     isDigit(str[9]) && isDigit(str[10]) && str[11] == '\0' &&
+	     !isDigit(str[2]) && !isDigit(str[5]) && !isDigit(str[8]) )
+	{
+		tc_set_by_hmsf( &tc,
+		                ( str[0] - '0' ) * 10 + ( str[1]  - '0' ),
+		                ( str[3] - '0' ) * 10 + ( str[4]  - '0' ),
+		                ( str[6] - '0' ) * 10 + ( str[7]  - '0' ),
+		                ( str[9] - '0' ) * 10 + ( str[10] - '0' ),
+		                format );
+	}
+	else
+	{
+		tc_set_by_string( &tc, str, format );
+	}
+
+	return tc.frameNumber;
+}
+
+
+int tc_array_set_strings( struct tc_array *array, const char * const *strings, size_t count, enum TC_FORMAT format )
+{
+	array->count      = 0;
+	array->remainders = NULL;
+
+	if ( tc_array_reserve( array, count ) < 0 )
+	{
+		return -1;
+	}
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		array->frames[i] = stringToFrames( strings[i], format );
+	}
+
+	memset( array->formats, format, count );
+
+	array->count = count;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	a / b reduced once per call, with the rounding bias (half up unless
+ *	set otherwise) and the largest value whose product still fits 64 bits,
+ *	as in tc_frames_to_unitValues().
+ */
+
+struct ratio
+{
+	uint64_t num;
+	uint64_t den;
+	uint64_t bias;
+	uint64_t limit;
+};
+
+
+static int makeRatio( struct ratio *r, uint64_t num, uint64_t den )
+{
+	if ( num == 0 || den == 0 )
+	{
+		return -1;
+	}
+
+	uint64_t g = tc_gcd( num, den );
+
+	r->num   = num / g;
+	r->den   = den / g;
+	r->bias  = r->den / 2;
+	r->limit = ( UINT64_MAX - r->bias ) / r->num;
+
+	return 0;
+}
+
+
+static void setBias( struct ratio *r, uint64_t bias )
+{
+	r->bias  = bias;
+	r->limit = ( UINT64_MAX - bias ) / r->num;
+}
+
+
+static inline uint64_t applyRatio( const struct ratio *r, uint64_t v )
+{
+	if ( v <= r->limit )
+	{
+		return ( v * r->num + r->bias ) / r->den;
+	}
+
+	return tc_muldiv( v, r->num, r->den, r->bias );
+}
+
+
+static int unitRatios( struct ratio *toFrames, struct ratio *toUnits, const rational_t *unitRate, enum TC_FORMAT format )
+{
+	rational_t fps = tc_format_rate( format );
+
+	if ( unitRate->numerator <= 0 || unitRate->denominator <= 0 || fps.numerator <= 0 )
+	{
+		return -1;
+	}
+
+	uint64_t num = (uint64_t)fps.numerator   * (uint64_t)unitRate->denominator;
+	uint64_t den = (uint64_t)fps.denominator * (uint64_t)unitRate->numerator;
+
+	if ( toFrames != NULL )
+	{
+		if ( makeRatio( toFrames, num, den ) < 0 )
+		{
+			return -1;
+		}
+
+		/* values are taken half a unit late, as tc_set_by_unitValue() */
+
+		setBias( toFrames, toFrames->num / 2 );
+	}
+
+	return makeRatio( toUnits, den, num );
+}
+
+
+/*
+ *	First unit value toFrames maps on a frame : the smallest v with
+ *	v * num + num / 2 >= frame * den. Remainders count from there, so they
+ *	are in [0, units per frame).
+ */
+
+static void firstUnitRatio( struct ratio *toFirst, const struct ratio *toUnits )
+{
+	*toFirst = *toUnits;
+
+	setBias( toFirst, toFirst->den - 1 - toFirst->den / 2 );
+}
+
+
+
+
+int tc_array_set_unitValues( struct tc_array *array, const uint64_t *values, size_t count, const rational_t *unitRate, enum TC_FORMAT format )
+{
+	struct ratio toFrames, toUnits, toFirst;
+
+	if ( unitRatios( &toFrames, &toUnits, unitRate, format ) < 0 )
+	{
+		return -1;
+	}
+
+	firstUnitRatio( &toFirst, &toUnits );
+
+	array->count = 0;
+
+	/* the columns in place are reused when they are large enough */
+
+	if ( tc_array_reserve( array, count ) < 0 )
+	{
+		return -1;
+	}
+
+	if ( array->remainders == NULL )
+	{
+		array->remainders = tc_arena_alloc( array->arena, array->capacity * sizeof(int32_t) );
+
+		if ( array->remainders == NULL )
+		{
+			return -1;
+		}
+	}
+
+	array->unitRate = *unitRate;
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		uint64_t frame = applyRatio( &toFrames, values[i] );
+
+		array->frames[i]     = (int32_t)frame;
+		array->remainders[i] = (int32_t)( values[i] - applyRatio( &toFirst, frame ) );
+	}
+
+	memset( array->formats, format, count );
+
+	array->count = count;
+
+	return 0;
+}
+
+
+
+
+void tc_array_convert( struct tc_array *array, enum TC_FORMAT format )
+{
+	memset( array->formats, format, array->count );
+
+	array->remainders = NULL;
+}
+
+
+
+
+void tc_array_convert_frames( struct tc_array *array, enum TC_FORMAT format )
+{
+	struct timecode tc;
+
+	memset( &tc, 0, sizeof(struct timecode) );
+
+	tc.noRollover = array->noRollover;
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		tc_set_by_frames( &tc, (uint32_t)array->frames[i], array->formats[i] );
+
+		tc_convert_frames( &tc, format );
+
+		array->frames[i] = tc.frameNumber;
+	}
+
+	memset( array->formats, format, array->count );
+
+	array->remainders = NULL;
+}
+
+
+
+
+void tc_array_add( struct tc_array *array, int32_t n )
+{
+	int32_t *frames = array->frames;
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		frames[i] += n;
+	}
+}
+
+
+
+
+int tc_array_add_array( struct tc_array *array, const struct tc_array *other )
+{
+	if ( array->count != other->count )
+	{
+		return -1;
+	}
+
+	int32_t       *frames = array->frames;
+	const int32_t *add    = other->frames;
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		frames[i] += add[i];
+	}
+
+	return 0;
+}
+
+
+
+
+void tc_array_get_unitValues( const struct tc_array *array, uint64_t *values, const rational_t *unitRate )
+{
+	struct ratio toUnits, toFirst;
+
+	enum TC_FORMAT format = TC_FORMAT_UNK;
+
+	int valid = 0;
+
+	int withRemainders = ( array->remainders != NULL &&
+	                       array->unitRate.numerator   == unitRate->numerator &&
+	                       array->unitRate.denominator == unitRate->denominator );
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		if ( i == 0 || array->formats[i] != format )
+		{
+			format = array->formats[i];
+			valid  = ( unitRatios( NULL, &toUnits, unitRate, format ) == 0 );
+
+			if ( valid )
+			{
+				firstUnitRatio( &toFirst, &toUnits );
+			}
+		}
+
+		if ( !valid || array->frames[i] < 0 )
+		{
+			values[i] = 0;
+			continue;
+		}
+
+		if ( withRemainders )
+		{
+			values[i] = applyRatio( &toFirst, (uint64_t)array->frames[i] ) + array->remainders[i];
+		}
+		else
+		{
+			values[i] = applyRatio( &toUnits, (uint64_t)array->frames[i] );
+		}
+	}
+}
+
+
+
+
+void tc_array_get( const struct tc_array *array, size_t i, struct timecode *tc )
+{
+	tc->noRollover = array->noRollover;
+
+	tc_set_by_frames( tc, (uint32_t)array->frames[i], array->formats[i] );
+}
+
+
+
+
+size_t tc_array_render( const struct tc_array *array, char *out, size_t stride )
+{
+	struct timecode tc;
+
+	memset( &tc, 0, sizeof(struct timecode) );
+
+	tc.noRollover = array->noRollover;
+
+	if ( stride == 0 )
+	{
+		return 0;
+	}
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		int32_t d = array->frames[i] - tc.frameNumber;
+
+		if ( i > 0 && array->formats[i] == tc.format && d >= -(int32_t)tc_format_fps( tc.format ) && d <= (int32_t)tc_format_fps( tc.format ) )
+		{
+			tc_step( &tc, d );
+		}
+		else
+		{
+			tc_set_by_frames( &tc, (uint32_t)array->frames[i], array->formats[i] );
+		}
+
+		size_t len = strlen( tc.string );
+
+		if ( len >= stride )
+		{
+			len = stride - 1;
+		}
+
+		memcpy( out, tc.string, len );
+		out[len] = '\0';
+
+		out += stride;
+	}
+
+	return array->count;
+}
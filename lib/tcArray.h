@@ -0,0 +1,170 @@
+#ifndef __tcArray_h__
+#define __tcArray_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Arena : a chain of large blocks handed out by bumping a pointer. There is
+ *	no per-allocation free, everything goes away with tc_arena_release().
+ */
+
+#define TC_ARENA_ALIGN       64          // cache line, and any SIMD width
+#define TC_ARENA_BLOCK_SIZE  (1 << 20)   // default block size
+
+struct tc_arena_block;
+
+struct tc_arena
+{
+	struct tc_arena_block *head;
+
+	size_t      blockSize;
+
+};
+
+
+void tc_arena_init( struct tc_arena *arena, size_t blockSize );   // 0 for TC_ARENA_BLOCK_SIZE
+
+void * tc_arena_alloc( struct tc_arena *arena, size_t size );     // TC_ARENA_ALIGN aligned, NULL when out of memory
+
+void tc_arena_release( struct tc_arena *arena );
+
+
+
+/*
+ *	Struct-of-arrays timecode list. Where a struct timecode holds one value
+ *	with all its representations, a tc_array holds count values as separate
+ *	contiguous columns :
+ *
+ *	- frames[]     : frame numbers, not wrapped at 24 hours (as frameNumber)
+ *	- formats[]    : enum TC_FORMAT of each frame number
+ *	- remainders[] : optional, position of the value inside its frame, in
+ *	                 unitRate units from the first unit value of the frame
+ *	                 (0 to units per frame), when set from unit values. NULL
+ *	                 until then.
+ *
+ *	hh:mm:ss:ff and strings are only computed by tc_array_get() and
+ *	tc_array_render(). Columns live in the arena given to tc_array_init().
+ */
+
+struct tc_array
+{
+	struct tc_arena *arena;
+
+	size_t      count;
+	size_t      capacity;
+
+	int32_t    *frames;
+	uint8_t    *formats;
+	int32_t    *remainders;
+
+	rational_t  unitRate;     // unit of remainders[]
+
+	uint8_t     noRollover;   // used for hh:mm:ss:ff, as in struct timecode
+
+};
+
+
+/**
+ *	Returns 0 on success, -1 if the arena is out of memory. Growing the array
+ *	leaves the former columns in the arena until it is released.
+ */
+
+int tc_array_init( struct tc_array *array, struct tc_arena *arena, size_t capacity );
+
+int tc_array_reserve( struct tc_array *array, size_t capacity );
+
+
+/**
+ *	Bulk setters : replace the content of the array with count values of
+ *	format. Strings are "hh:mm:ss:ff" (any separator), as tc_set_by_string().
+ *	Unit values give the same frame numbers as tc_set_by_unitValue() and keep
+ *	the rest in remainders[], so tc_array_get_unitValues() gives them back.
+ *	Setting again reuses the columns when they are large enough.
+ *	Return 0 on success, -1 on a wrong rate or when out of memory.
+ */
+
+int tc_array_set_frames( struct tc_array *array, const int32_t *frames, size_t count, enum TC_FORMAT format );
+
+int tc_array_set_strings( struct tc_array *array, const char * const *strings, size_t count, enum TC_FORMAT format );
+
+int tc_array_set_unitValues( struct tc_array *array, const uint64_t *values, size_t count, const rational_t *unitRate, enum TC_FORMAT format );
+
+
+/**
+ *	Same as tc_convert() and tc_convert_frames() on every value. Converting
+ *	drops the remainders.
+ */
+
+void tc_array_convert( struct tc_array *array, enum TC_FORMAT format );
+
+void tc_array_convert_frames( struct tc_array *array, enum TC_FORMAT format );
+
+
+/**
+ *	Adds n frames to every value, or other->frames[i] to each frames[i].
+ *	tc_array_add_array() returns -1, and leaves the array as is, if the
+ *	counts differ.
+ */
+
+void tc_array_add( struct tc_array *array, int32_t n );
+
+int tc_array_add_array( struct tc_array *array, const struct tc_array *other );
+
+
+/**
+ *	Position of every value in unitRate units (see tc_get_unitValue()), plus
+ *	its remainder when the array was set from values of the same unitRate.
+ */
+
+void tc_array_get_unitValues( const struct tc_array *array, uint64_t *values, const rational_t *unitRate );
+
+
+/**
+ *	Fills a struct timecode from value i.
+ */
+
+void tc_array_get( const struct tc_array *array, size_t i, struct timecode *tc );
+
+
+/**
+ *	Writes the string of every value to out, one every stride bytes, null
+ *	terminated and truncated to stride. Runs of close values of one format
+ *	are rendered by stepping, as tc_step(). Returns the number of strings.
+ */
+
+size_t tc_array_render( const struct tc_array *array, char *out, size_t stride );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcArray_h__
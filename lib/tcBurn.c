@@ -0,0 +1,705 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tcBurn.h"
+
+
+
+/*
+ *	5x7 font, one byte per row, bit 4 is the leftmost pixel. A character
+ *	cell is 6x9 font pixels : one blank column on the right, one blank row
+ *	above and below.
+ */
+
+#define FONT_W   5
+#define FONT_H   7
+#define CELL_W   6
+#define CELL_H   9
+
+#define GLYPH_COLON      10
+#define GLYPH_SEMICOLON  11
+#define GLYPH_DASH       12
+#define GLYPH_BLANK      13
+#define GLYPH_LEN        14
+
+static const uint8_t FONT[GLYPH_LEN][FONT_H] = {
+	{ 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },  // 0
+	{ 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 1
+	{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },  // 2
+	{ 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },  // 3
+	{ 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },  // 4
+	{ 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },  // 5
+	{ 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },  // 6
+	{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // 7
+	{ 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },  // 8
+	{ 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },  // 9
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },  // :
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 },  // ;
+	{ 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },  // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }   //
+};
+
+
+/*
+ *	Label colors : white text on a black box, BT.709 limited range for YUV.
+ */
+
+#define BOX_ALPHA   160
+
+#define INK_Y8      235
+#define BOX_Y8       16
+#define CHROMA8     128
+
+#define INK_Y10     940
+#define BOX_Y10      64
+#define CHROMA10    512
+
+
+
+
+static const char *TC_PIXFMT_STR[] = {
+	"unknown",
+	"uyvy",
+	"v210",
+	"yuv420p",
+	"rgba",
+	""
+};
+
+
+
+
+static unsigned int glyphIndex( char c )
+{
+	if ( c >= '0' && c <= '9' )
+		return c - '0';
+
+	switch ( c )
+	{
+		case ':':  return GLYPH_COLON;
+		case ';':  return GLYPH_SEMICOLON;
+		case '-':  return GLYPH_DASH;
+		default:   return GLYPH_BLANK;
+	}
+}
+
+
+
+
+static uint32_t hAlign( enum TC_PIXFMT pixfmt )
+{
+	switch ( pixfmt )
+	{
+		case TC_PIXFMT_V210:     return 6;
+		case TC_PIXFMT_UYVY:
+		case TC_PIXFMT_YUV420P:  return 2;
+		default:                 return 1;
+	}
+}
+
+
+static uint32_t vAlign( enum TC_PIXFMT pixfmt )
+{
+	return ( pixfmt == TC_PIXFMT_YUV420P ) ? 2 : 1;
+}
+
+
+static uint32_t v210Stride( uint32_t width )
+{
+	return ( ( width + 47 ) / 48 ) * 128;
+}
+
+
+
+
+size_t tc_pixfmt_frame_size( enum TC_PIXFMT pixfmt, uint32_t width, uint32_t height )
+{
+	size_t w = width;
+	size_t h = height;
+
+	switch ( pixfmt )
+	{
+		case TC_PIXFMT_UYVY:     return ( ( w + 1 ) & ~(size_t)1 ) * 2 * h;
+		case TC_PIXFMT_V210:     return (size_t)v210Stride( width ) * h;
+		case TC_PIXFMT_YUV420P:  return w * h + ( ( w + 1 ) / 2 ) * ( ( h + 1 ) / 2 ) * 2;
+		case TC_PIXFMT_RGBA:     return w * h * 4;
+		default:                 return 0;
+	}
+}
+
+
+
+
+enum TC_PIXFMT tc_pixfmt_from_string( const char *str )
+{
+	unsigned int i = 1;
+
+	for ( ; TC_PIXFMT_STR[i][0] != '\0'; i++ )
+	{
+		if ( strcmp( str, TC_PIXFMT_STR[i] ) == 0 )
+		{
+			return i;
+		}
+	}
+
+	return TC_PIXFMT_UNK;
+}
+
+
+
+
+/*
+ *	Blending : out = ( dst * ( 255 - a ) + src * a ) / 255, rounded.
+ *	For t = x + 128, ( t + ( t >> 8 ) ) >> 8 is the exact rounded x / 255
+ *	over the whole 16 bit range, which keeps the SIMD and scalar paths equal.
+ */
+
+static inline uint8_t blend8( uint8_t d, uint8_t s, uint8_t a )
+{
+	uint32_t t = d * ( 255 - a ) + s * a + 128;
+
+	return ( t + ( t >> 8 ) ) >> 8;
+}
+
+
+static void blendSpan8( uint8_t *dst, const uint8_t *src, const uint8_t *alpha, uint32_t n )
+{
+	uint32_t i = 0;
+
+#ifdef __SSE2__
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c255 = _mm_set1_epi16( 255 );
+	const __m128i c128 = _mm_set1_epi16( 128 );
+
+	for ( ; i + 16 <= n; i += 16 )
+	{
+		__m128i d = _mm_loadu_si128( (const __m128i*)( dst   + i ) );
+		__m128i s = _mm_loadu_si128( (const __m128i*)( src   + i ) );
+		__m128i a = _mm_loadu_si128( (const __m128i*)( alpha + i ) );
+
+		__m128i aL = _mm_unpacklo_epi8( a, zero );
+		__m128i aH = _mm_unpackhi_epi8( a, zero );
+
+		__m128i tL = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), _mm_sub_epi16( c255, aL ) ),
+		                            _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), aL ) );
+
+		__m128i tH = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), _mm_sub_epi16( c255, aH ) ),
+		                            _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), aH ) );
+
+		tL = _mm_add_epi16( tL, c128 );
+		tH = _mm_add_epi16( tH, c128 );
+
+		tL = _mm_srli_epi16( _mm_add_epi16( tL, _mm_srli_epi16( tL, 8 ) ), 8 );
+		tH = _mm_srli_epi16( _mm_add_epi16( tH, _mm_srli_epi16( tH, 8 ) ), 8 );
+
+		_mm_storeu_si128( (__m128i*)( dst + i ), _mm_packus_epi16( tL, tH ) );
+	}
+
+#endif
+
+	for ( ; i < n; i++ )
+	{
+		dst[i] = blend8( dst[i], src[i], alpha[i] );
+	}
+}
+
+
+
+
+/*
+ *	Tile building. mask[] holds 1 for text pixels and 0 for the box, and the
+ *	planes are regenerated from it for a range of columns.
+ */
+
+static void buildPlanes( struct tc_burn *burn, uint32_t c0, uint32_t c1 )
+{
+	uint32_t x, y;
+
+	for ( y = 0; y < burn->tileH; y++ )
+	{
+		const uint8_t *m = burn->mask + (size_t)y * burn->tileW;
+
+		struct tc_burn_plane *p = &burn->planes[0];
+
+		switch ( burn->pixfmt )
+		{
+			case TC_PIXFMT_RGBA:
+			{
+				uint8_t *d = p->data  + (size_t)y * p->stride;
+				uint8_t *a = p->alpha + (size_t)y * p->stride;
+
+				for ( x = c0; x < c1; x++ )
+				{
+					uint8_t v  = m[x] ? 255 : 0;
+					uint8_t av = m[x] ? 255 : BOX_ALPHA;
+
+					d[x*4+0] = v;   a[x*4+0] = av;
+					d[x*4+1] = v;   a[x*4+1] = av;
+					d[x*4+2] = v;   a[x*4+2] = av;
+					d[x*4+3] = 255; a[x*4+3] = av;
+				}
+
+				break;
+			}
+
+			case TC_PIXFMT_UYVY:
+			case TC_PIXFMT_V210:
+			{
+				/* v210 components come in the same Cb Y Cr Y order as UYVY */
+
+				uint8_t  *a   = p->alpha + (size_t)y * p->stride;
+				uint8_t  *d8  = p->data  + (size_t)y * p->stride;
+				uint16_t *d16 = (uint16_t*)p->data + (size_t)y * p->stride;
+
+				int wide = ( burn->pixfmt == TC_PIXFMT_V210 );
+
+				for ( x = c0; x < c1; x += 2 )
+				{
+					uint8_t a0 = m[x]   ? 255 : BOX_ALPHA;
+					uint8_t a1 = m[x+1] ? 255 : BOX_ALPHA;
+
+					uint32_t i = x * 2;
+
+					a[i+0] = a[i+2] = ( a0 + a1 + 1 ) / 2;
+					a[i+1] = a0;
+					a[i+3] = a1;
+
+					if ( wide )
+					{
+						d16[i+0] = d16[i+2] = CHROMA10;
+						d16[i+1] = m[x]   ? INK_Y10 : BOX_Y10;
+						d16[i+3] = m[x+1] ? INK_Y10 : BOX_Y10;
+					}
+					else
+					{
+						d8[i+0] = d8[i+2] = CHROMA8;
+						d8[i+1] = m[x]   ? INK_Y8 : BOX_Y8;
+						d8[i+3] = m[x+1] ? INK_Y8 : BOX_Y8;
+					}
+				}
+
+				break;
+			}
+
+			case TC_PIXFMT_YUV420P:
+			{
+				uint8_t *d = p->data  + (size_t)y * p->stride;
+				uint8_t *a = p->alpha + (size_t)y * p->stride;
+
+				for ( x = c0; x < c1; x++ )
+				{
+					d[x] = m[x] ? INK_Y8 : BOX_Y8;
+					a[x] = m[x] ? 255    : BOX_ALPHA;
+				}
+
+				if ( y & 1 )
+				{
+					const uint8_t *n = m - burn->tileW;
+
+					uint32_t cy = y / 2;
+
+					for ( x = c0; x < c1; x += 2 )
+					{
+						uint32_t sum = ( n[x] ? 255 : BOX_ALPHA ) + ( n[x+1] ? 255 : BOX_ALPHA ) +
+						               ( m[x] ? 255 : BOX_ALPHA ) + ( m[x+1] ? 255 : BOX_ALPHA );
+
+						size_t o = (size_t)cy * burn->planes[1].stride + x / 2;
+
+						burn->planes[1].data[o]  = burn->planes[2].data[o]  = CHROMA8;
+						burn->planes[1].alpha[o] = burn->planes[2].alpha[o] = ( sum + 2 ) / 4;
+					}
+				}
+
+				break;
+			}
+
+			default:
+				return;
+		}
+	}
+}
+
+
+
+
+static void drawChar( struct tc_burn *burn, unsigned int pos, char c )
+{
+	uint32_t x0 = burn->scale + pos * burn->cellW;
+
+	const uint8_t *g = burn->atlas + (size_t)glyphIndex( c ) * burn->cellW * burn->cellH;
+
+	uint32_t y;
+
+	for ( y = 0; y < burn->cellH; y++ )
+	{
+		memcpy( burn->mask + (size_t)y * burn->tileW + x0, g + (size_t)y * burn->cellW, burn->cellW );
+	}
+}
+
+
+
+
+static void freeTile( struct tc_burn *burn )
+{
+	unsigned int i = 0;
+
+	for ( ; i < 3; i++ )
+	{
+		free( burn->planes[i].data );
+		free( burn->planes[i].alpha );
+	}
+
+	memset( burn->planes, 0x00, sizeof(burn->planes) );
+
+	free( burn->mask );
+
+	burn->mask = NULL;
+}
+
+
+static int allocTile( struct tc_burn *burn, size_t chars )
+{
+	uint32_t ha = hAlign( burn->pixfmt );
+	uint32_t va = vAlign( burn->pixfmt );
+
+	freeTile( burn );
+
+	/* one font pixel of box on the left, the cell spacing gives the right one */
+
+	burn->tileW = ( ( burn->scale + chars * burn->cellW + ha - 1 ) / ha ) * ha;
+	burn->tileH = ( ( burn->cellH + va - 1 ) / va ) * va;
+
+	burn->mask = calloc( (size_t)burn->tileW * burn->tileH, 1 );
+
+	unsigned int planes = 1;
+	size_t       width  = burn->tileW;
+	size_t       size   = 1;
+
+	switch ( burn->pixfmt )
+	{
+		case TC_PIXFMT_RGBA:     width *= 4;                break;
+		case TC_PIXFMT_UYVY:     width *= 2;                break;
+		case TC_PIXFMT_V210:     width *= 2;  size = 2;     break;
+		case TC_PIXFMT_YUV420P:  planes = 3;                break;
+		default:                                            break;
+	}
+
+	unsigned int i = 0;
+
+	for ( ; i < planes; i++ )
+	{
+		struct tc_burn_plane *p = &burn->planes[i];
+
+		p->stride = ( i == 0 ) ? width : width / 2;
+		p->rows   = ( i == 0 ) ? burn->tileH : burn->tileH / 2;
+
+		p->data  = malloc( (size_t)p->stride * p->rows * size );
+		p->alpha = malloc( (size_t)p->stride * p->rows );
+
+		if ( p->data == NULL || p->alpha == NULL )
+		{
+			freeTile( burn );
+			return -1;
+		}
+	}
+
+	if ( burn->mask == NULL )
+	{
+		freeTile( burn );
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+static int updateTile( struct tc_burn *burn, const char *str )
+{
+	size_t len = strlen( str );
+
+	if ( len > TC_BURN_MAX_CHARS )
+	{
+		len = TC_BURN_MAX_CHARS;
+	}
+
+	uint32_t ha = hAlign( burn->pixfmt );
+
+	unsigned int i = 0;
+
+	if ( burn->mask == NULL || len != strlen( burn->drawn ) )
+	{
+		if ( allocTile( burn, len ) < 0 )
+		{
+			burn->drawn[0] = '\0';
+			return -1;
+		}
+
+		for ( i = 0; i < len; i++ )
+		{
+			drawChar( burn, i, str[i] );
+		}
+
+		buildPlanes( burn, 0, burn->tileW );
+	}
+	else
+	{
+		for ( i = 0; i < len; i++ )
+		{
+			if ( str[i] == burn->drawn[i] )
+			{
+				continue;
+			}
+
+			drawChar( burn, i, str[i] );
+
+			uint32_t c0 = burn->scale + i * burn->cellW;
+			uint32_t c1 = c0 + burn->cellW;
+
+			c0 = ( c0 / ha ) * ha;
+			c1 = ( ( c1 + ha - 1 ) / ha ) * ha;
+
+			buildPlanes( burn, c0, ( c1 < burn->tileW ) ? c1 : burn->tileW );
+		}
+	}
+
+	memcpy( burn->drawn, str, len );
+
+	burn->drawn[len] = '\0';
+
+	return 0;
+}
+
+
+
+
+int tc_burn_init( struct tc_burn *burn, enum TC_PIXFMT pixfmt, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint32_t scale )
+{
+	memset( burn, 0x00, sizeof(struct tc_burn) );
+
+	if ( pixfmt <= TC_PIXFMT_UNK || pixfmt >= TC_PIXFMT_LEN ||
+	     width == 0 || height == 0 || scale == 0 || scale > 64 )
+	{
+		return -1;
+	}
+
+	burn->pixfmt = pixfmt;
+	burn->width  = width;
+	burn->height = height;
+	burn->x      = ( x / hAlign( pixfmt ) ) * hAlign( pixfmt );
+	burn->y      = ( y / vAlign( pixfmt ) ) * vAlign( pixfmt );
+	burn->scale  = scale;
+	burn->cellW  = CELL_W * scale;
+	burn->cellH  = CELL_H * scale;
+
+
+	/* glyph atlas, rasterized once at the requested scale */
+
+	burn->atlas = calloc( (size_t)GLYPH_LEN * burn->cellW * burn->cellH, 1 );
+
+	if ( burn->atlas == NULL )
+	{
+		return -1;
+	}
+
+	unsigned int g, gx, gy;
+
+	for ( g = 0; g < GLYPH_LEN; g++ )
+	{
+		uint8_t *cell = burn->atlas + (size_t)g * burn->cellW * burn->cellH;
+
+		for ( gy = 0; gy < burn->cellH; gy++ )
+		{
+			unsigned int fy = gy / scale;
+
+			if ( fy < 1 || fy > FONT_H )
+				continue;
+
+			for ( gx = 0; gx < burn->cellW; gx++ )
+			{
+				unsigned int fx = gx / scale;
+
+				if ( fx < FONT_W && ( FONT[g][fy-1] >> ( FONT_W - 1 - fx ) ) & 1 )
+				{
+					cell[gy * burn->cellW + gx] = 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+
+
+static void blendV210( struct tc_burn *burn, uint8_t *frame, uint32_t visW, uint32_t visH )
+{
+	const struct tc_burn_plane *p = &burn->planes[0];
+
+	uint32_t stride = v210Stride( burn->width );
+	uint32_t groups = visW / 6;
+
+	uint32_t r, g, i;
+
+	for ( r = 0; r < visH; r++ )
+	{
+		uint8_t        *row = frame + (size_t)( burn->y + r ) * stride + ( burn->x / 6 ) * 16;
+		const uint16_t *s   = (const uint16_t*)p->data + (size_t)r * p->stride;
+		const uint8_t  *a   = p->alpha + (size_t)r * p->stride;
+
+		for ( g = 0; g < groups; g++, row += 16, s += 12, a += 12 )
+		{
+			uint32_t c[12];
+
+			for ( i = 0; i < 4; i++ )
+			{
+				uint32_t w = row[i*4] | row[i*4+1] << 8 | row[i*4+2] << 16 | (uint32_t)row[i*4+3] << 24;
+
+				c[i*3+0] =   w         & 0x3ff;
+				c[i*3+1] = ( w >> 10 ) & 0x3ff;
+				c[i*3+2] = ( w >> 20 ) & 0x3ff;
+			}
+
+			for ( i = 0; i < 12; i++ )
+			{
+				c[i] = ( c[i] * ( 255 - a[i] ) + s[i] * a[i] + 127 ) / 255;
+			}
+
+			for ( i = 0; i < 4; i++ )
+			{
+				uint32_t w = c[i*3] | c[i*3+1] << 10 | c[i*3+2] << 20;
+
+				row[i*4+0] = w;
+				row[i*4+1] = w >> 8;
+				row[i*4+2] = w >> 16;
+				row[i*4+3] = w >> 24;
+			}
+		}
+	}
+}
+
+
+
+
+void tc_burn_render( struct tc_burn *burn, uint8_t *frame, const struct timecode *tc )
+{
+	if ( burn->atlas == NULL || burn->x >= burn->width || burn->y >= burn->height )
+	{
+		return;
+	}
+
+	if ( updateTile( burn, tc->string ) < 0 )
+	{
+		return;
+	}
+
+
+	/* clip to the frame, keeping the chroma alignment */
+
+	uint32_t ha = hAlign( burn->pixfmt );
+	uint32_t va = vAlign( burn->pixfmt );
+
+	uint32_t visW = burn->width  - burn->x;
+	uint32_t visH = burn->height - burn->y;
+
+	visW = ( ( ( visW < burn->tileW ) ? visW : burn->tileW ) / ha ) * ha;
+	visH = ( ( ( visH < burn->tileH ) ? visH : burn->tileH ) / va ) * va;
+
+
+	const struct tc_burn_plane *p = burn->planes;
+
+	size_t   w = burn->width;
+	size_t   h = burn->height;
+	uint32_t r = 0;
+
+	switch ( burn->pixfmt )
+	{
+		case TC_PIXFMT_RGBA:
+		case TC_PIXFMT_UYVY:
+		{
+			size_t bpp    = ( burn->pixfmt == TC_PIXFMT_RGBA ) ? 4 : 2;
+			size_t stride = ( burn->pixfmt == TC_PIXFMT_RGBA ) ? w * 4 : ( ( w + 1 ) & ~(size_t)1 ) * 2;
+
+			for ( r = 0; r < visH; r++ )
+			{
+				blendSpan8( frame + ( burn->y + r ) * stride + burn->x * bpp,
+				            p->data  + (size_t)r * p->stride,
+				            p->alpha + (size_t)r * p->stride,
+				            visW * bpp );
+			}
+
+			break;
+		}
+
+		case TC_PIXFMT_YUV420P:
+		{
+			size_t   cw = ( w + 1 ) / 2;
+			size_t   ch = ( h + 1 ) / 2;
+			uint8_t *cb = frame + w * h;
+			uint8_t *cr = cb + cw * ch;
+
+			for ( r = 0; r < visH; r++ )
+			{
+				blendSpan8( frame + ( burn->y + r ) * w + burn->x,
+				            p[0].data  + (size_t)r * p[0].stride,
+				            p[0].alpha + (size_t)r * p[0].stride,
+				            visW );
+			}
+
+			for ( r = 0; r < visH / 2; r++ )
+			{
+				size_t o = ( burn->y / 2 + r ) * cw + burn->x / 2;
+
+				blendSpan8( cb + o, p[1].data + (size_t)r * p[1].stride, p[1].alpha + (size_t)r * p[1].stride, visW / 2 );
+				blendSpan8( cr + o, p[2].data + (size_t)r * p[2].stride, p[2].alpha + (size_t)r * p[2].stride, visW / 2 );
+			}
+
+			break;
+		}
+
+		case TC_PIXFMT_V210:
+			blendV210( burn, frame, visW, visH );
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+
+
+void tc_burn_free( struct tc_burn *burn )
+{
+	freeTile( burn );
+
+	free( burn->atlas );
+
+	burn->atlas = NULL;
+}
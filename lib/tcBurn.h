@@ -0,0 +1,132 @@
+#ifndef __tcBurn_h__
+#define __tcBurn_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Timecode burn-in on raw video frames.
+ *
+ *	The label (white digits on a translucent black box) is kept as a tile
+ *	already converted to the frame pixel format, with one alpha value per
+ *	byte / component. Glyphs come from an atlas rasterized once at the
+ *	requested scale, and only the characters that changed since the previous
+ *	frame are redrawn into the tile. Each frame then only costs the alpha
+ *	blend of the tile, done with SSE2 where available.
+ */
+
+enum TC_PIXFMT {
+
+	TC_PIXFMT_UNK = 0,
+
+	TC_PIXFMT_UYVY,      // 4:2:2 8 bit packed, Cb Y Cr Y
+	TC_PIXFMT_V210,      // 4:2:2 10 bit packed, 6 pixels in 16 bytes, rows aligned on 128 bytes
+	TC_PIXFMT_YUV420P,   // 4:2:0 8 bit planar, Y then Cb then Cr
+	TC_PIXFMT_RGBA,      // 8 bit packed R G B A
+
+	TC_PIXFMT_LEN
+};
+
+
+#define TC_BURN_MAX_CHARS  24
+
+
+struct tc_burn_plane
+{
+	uint8_t   *data;     // tile samples (uint16_t for v210)
+	uint8_t   *alpha;    // one alpha per sample
+
+	uint32_t   stride;   // samples per tile row
+	uint32_t   rows;
+
+};
+
+
+struct tc_burn
+{
+	enum TC_PIXFMT  pixfmt;
+
+	uint32_t        width;      // frame size, in pixels
+	uint32_t        height;
+
+	uint32_t        x;          // label position in the frame
+	uint32_t        y;
+
+	uint32_t        scale;      // one font pixel is scale x scale frame pixels
+
+
+	uint32_t        cellW;      // size of a character, in frame pixels
+	uint32_t        cellH;
+
+	uint8_t        *atlas;      // glyph coverage, cellW x cellH per glyph
+
+	uint8_t        *mask;       // label coverage, tileW x tileH
+
+	uint32_t        tileW;
+	uint32_t        tileH;
+
+	struct tc_burn_plane planes[3];
+
+	char            drawn[TC_BURN_MAX_CHARS+1];  // string currently in the tile
+
+};
+
+
+/**
+ *	Returns the size in bytes of one frame, or 0 for an unknown format.
+ */
+
+size_t tc_pixfmt_frame_size( enum TC_PIXFMT pixfmt, uint32_t width, uint32_t height );
+
+enum TC_PIXFMT tc_pixfmt_from_string( const char *str );
+
+
+/**
+ *	Prepares a burn-in of the given frame format at (x, y), moved down / left
+ *	to the chroma alignment of the format. Returns 0 on success, -1 on bad
+ *	parameters or allocation error.
+ */
+
+int tc_burn_init( struct tc_burn *burn, enum TC_PIXFMT pixfmt, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint32_t scale );
+
+/**
+ *	Composites tc->string onto frame. The label is clipped to the frame.
+ */
+
+void tc_burn_render( struct tc_burn *burn, uint8_t *frame, const struct timecode *tc );
+
+void tc_burn_free( struct tc_burn *burn );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcBurn_h__
@@ -0,0 +1,518 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "tcCue.h"
+
+
+
+enum CUE_STATE {
+
+	CUE_IDLE = 0,
+	CUE_PENDING,    // in the wheel
+	CUE_DUE,        // in sched->due, about to be dispatched
+	CUE_FIRED       // in sched->fired, waiting for the clock to go back
+};
+
+
+enum CUE_REQUEST {
+
+	CUE_REQUEST_NONE = 0,
+	CUE_REQUEST_INSERT,
+	CUE_REQUEST_CANCEL
+};
+
+
+
+
+static void listAppend( struct tc_cue_list *list, struct tc_cue *cue )
+{
+	cue->next = NULL;
+	cue->prev = list->tail;
+
+	if ( list->tail != NULL )
+	{
+		list->tail->next = cue;
+	}
+	else
+	{
+		list->head = cue;
+	}
+
+	list->tail = cue;
+}
+
+
+static void listRemove( struct tc_cue_list *list, struct tc_cue *cue )
+{
+	if ( cue->prev != NULL )  cue->prev->next = cue->next;
+	else                      list->head      = cue->next;
+
+	if ( cue->next != NULL )  cue->next->prev = cue->prev;
+	else                      list->tail      = cue->prev;
+
+	cue->prev = NULL;
+	cue->next = NULL;
+}
+
+
+/* moves all of from to the end of to */
+
+static void listSplice( struct tc_cue_list *to, struct tc_cue_list *from )
+{
+	if ( from->head == NULL )
+	{
+		return;
+	}
+
+	if ( to->tail != NULL )
+	{
+		to->tail->next   = from->head;
+		from->head->prev = to->tail;
+	}
+	else
+	{
+		to->head = from->head;
+	}
+
+	to->tail = from->tail;
+
+	from->head = NULL;
+	from->tail = NULL;
+}
+
+
+
+
+/*
+ *	Level of a position : index of the highest byte where it differs from the
+ *	clock. Cues on the clock position (before the first update only) go to
+ *	level 0.
+ */
+
+static inline unsigned int levelOf( uint32_t position, uint32_t now )
+{
+	uint32_t diff = position ^ now;
+
+	if ( diff >> 24 )  return 3;
+	if ( diff >> 16 )  return 2;
+	if ( diff >>  8 )  return 1;
+
+	return 0;
+}
+
+
+static inline unsigned int slotOf( uint32_t position, unsigned int level )
+{
+	return ( position >> ( 8 * level ) ) & 0xff;
+}
+
+
+static void file( struct tc_cue_sched *sched, struct tc_cue *cue )
+{
+	unsigned int level = levelOf( cue->position, sched->now );
+
+	cue->state = CUE_PENDING;
+
+	listAppend( &sched->slots[level][ slotOf( cue->position, level ) ], cue );
+
+	sched->levelCount[level]++;
+	sched->pending++;
+}
+
+
+static void unfile( struct tc_cue_sched *sched, struct tc_cue *cue )
+{
+	unsigned int level = levelOf( cue->position, sched->now );
+
+	listRemove( &sched->slots[level][ slotOf( cue->position, level ) ], cue );
+
+	sched->levelCount[level]--;
+	sched->pending--;
+
+	cue->state = CUE_IDLE;
+}
+
+
+/* moves every cue of a slot to list */
+
+static void detachSlot( struct tc_cue_sched *sched, unsigned int level, unsigned int slot, struct tc_cue_list *list )
+{
+	struct tc_cue *cue = sched->slots[level][slot].head;
+
+	for ( ; cue != NULL; cue = cue->next )
+	{
+		sched->levelCount[level]--;
+		sched->pending--;
+	}
+
+	listSplice( list, &sched->slots[level][slot] );
+}
+
+
+
+
+int tc_cue_init( struct tc_cue_sched *sched, enum TC_FORMAT format )
+{
+	if ( format <= TC_FORMAT_UNK || format >= TC_FORMAT_LEN )
+	{
+		return -1;
+	}
+
+	memset( sched, 0, sizeof(struct tc_cue_sched) );
+
+	sched->format = format;
+	sched->chase  = TC_CUE_CHASE;
+
+	sched->framesPerDay = tc_frames_per_day( format );
+
+	return 0;
+}
+
+
+
+
+int tc_cue_insert( struct tc_cue_sched *sched, struct tc_cue *cue, uint32_t position )
+{
+	if ( sched->started && position <= sched->now )
+	{
+		return -1;
+	}
+
+	tc_cue_cancel( sched, cue );
+
+	cue->position = position;
+
+	file( sched, cue );
+
+	return 0;
+}
+
+
+int tc_cue_cancel( struct tc_cue_sched *sched, struct tc_cue *cue )
+{
+	if ( cue->state == CUE_PENDING )
+	{
+		unfile( sched, cue );
+		return 0;
+	}
+
+	if ( cue->state == CUE_FIRED || cue->state == CUE_DUE )
+	{
+		listRemove( ( cue->state == CUE_FIRED ) ? &sched->fired : &sched->due, cue );
+		cue->state = CUE_IDLE;
+		return 0;
+	}
+
+	return -1;
+}
+
+
+
+
+/*
+ *	Posted changes go through a lock-free stack : producers push with a
+ *	compare-and-swap, the clock thread takes the whole stack at once. A cue
+ *	is only pushed once until the clock thread takes it, and its last request
+ *	wins.
+ */
+
+static void post( struct tc_cue_sched *sched, struct tc_cue *cue, int request, uint32_t position )
+{
+	__atomic_store_n( &cue->postedPosition, position, __ATOMIC_RELAXED );
+	__atomic_store_n( &cue->request, request, __ATOMIC_RELEASE );
+
+	if ( __atomic_exchange_n( &cue->queued, 1, __ATOMIC_ACQ_REL ) != 0 )
+	{
+		return;
+	}
+
+	struct tc_cue *head = __atomic_load_n( &sched->posted, __ATOMIC_RELAXED );
+
+	do
+	{
+		cue->posted = head;
+	}
+	while ( !__atomic_compare_exchange_n( &sched->posted, &head, cue, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) );
+}
+
+
+void tc_cue_post_insert( struct tc_cue_sched *sched, struct tc_cue *cue, uint32_t position )
+{
+	post( sched, cue, CUE_REQUEST_INSERT, position );
+}
+
+
+void tc_cue_post_cancel( struct tc_cue_sched *sched, struct tc_cue *cue )
+{
+	post( sched, cue, CUE_REQUEST_CANCEL, 0 );
+}
+
+
+static void applyPosted( struct tc_cue_sched *sched )
+{
+	struct tc_cue *cue = __atomic_exchange_n( &sched->posted, NULL, __ATOMIC_ACQUIRE );
+
+	/* back to posting order */
+
+	struct tc_cue *fifo = NULL;
+
+	while ( cue != NULL )
+	{
+		struct tc_cue *next = cue->posted;
+
+		cue->posted = fifo;
+		fifo = cue;
+		cue = next;
+	}
+
+	while ( fifo != NULL )
+	{
+		struct tc_cue *next = fifo->posted;
+
+		__atomic_store_n( &fifo->queued, 0, __ATOMIC_SEQ_CST );
+
+		int      request  = __atomic_exchange_n( &fifo->request, CUE_REQUEST_NONE, __ATOMIC_ACQUIRE );
+		uint32_t position = __atomic_load_n( &fifo->postedPosition, __ATOMIC_RELAXED );
+
+		if ( request == CUE_REQUEST_INSERT )
+		{
+			tc_cue_insert( sched, fifo, position );
+		}
+		else if ( request == CUE_REQUEST_CANCEL )
+		{
+			tc_cue_cancel( sched, fifo );
+		}
+
+		fifo = next;
+	}
+}
+
+
+
+
+static void dispatch( struct tc_cue_sched *sched, struct tc_cue *cue, enum TC_CUE_EVENT event )
+{
+	if ( cue->rearm )
+	{
+		cue->state = CUE_FIRED;
+		listAppend( &sched->fired, cue );
+	}
+	else
+	{
+		cue->state = CUE_IDLE;
+	}
+
+	if ( cue->callback != NULL )
+	{
+		cue->callback( cue, event, sched->now );
+	}
+}
+
+
+/*
+ *	Files again the detached cues, relative to the new clock position, and
+ *	dispatches those it reached or passed. Those wait in sched->due, where
+ *	callbacks can still cancel them.
+ */
+
+static void refile( struct tc_cue_sched *sched, struct tc_cue_list *list )
+{
+	struct tc_cue *cue = list->head;
+
+	list->head = NULL;
+	list->tail = NULL;
+
+	while ( cue != NULL )
+	{
+		struct tc_cue *next = cue->next;
+
+		if ( cue->position > sched->now )
+		{
+			file( sched, cue );
+		}
+		else
+		{
+			cue->state = CUE_DUE;
+			listAppend( &sched->due, cue );
+		}
+
+		cue = next;
+	}
+
+	while ( ( cue = sched->due.head ) != NULL )
+	{
+		listRemove( &sched->due, cue );
+
+		dispatch( sched, cue, ( cue->position == sched->now ) ? TC_CUE_FIRED : TC_CUE_SKIPPED );
+	}
+}
+
+
+
+
+/*
+ *	One frame forward. Only the level of the highest byte that changed needs
+ *	re-filing, and only its slot for the new position : the carry leaves the
+ *	bytes below at 0, so no cue could sit at the levels below.
+ */
+
+static void step( struct tc_cue_sched *sched )
+{
+	uint32_t next = sched->now + 1;
+
+	unsigned int level = levelOf( next, sched->now );
+
+	sched->now = next;
+
+	struct tc_cue_list due = { NULL, NULL };
+
+	if ( level > 0 )
+	{
+		detachSlot( sched, level, slotOf( next, level ), &due );
+	}
+
+	detachSlot( sched, 0, slotOf( next, 0 ), &due );
+
+	refile( sched, &due );
+}
+
+
+/*
+ *	Any other move. The levels above the highest byte that changed keep their
+ *	cues ; below it, every cue moves. At that level, going forward takes the
+ *	slots the clock went through, going back moves nothing (its cues are
+ *	after the former position, so after the new one too).
+ */
+
+static void locate( struct tc_cue_sched *sched, uint32_t position )
+{
+	struct tc_cue_list moved = { NULL, NULL };
+
+	unsigned int top = levelOf( position, sched->now );
+	unsigned int level, slot;
+
+	if ( !sched->started )
+	{
+		top = TC_CUE_LEVELS;
+	}
+
+	for ( level = 0; level < top && level < TC_CUE_LEVELS; level++ )
+	{
+		for ( slot = 0; slot < TC_CUE_SLOTS && sched->levelCount[level] > 0; slot++ )
+		{
+			detachSlot( sched, level, slot, &moved );
+		}
+	}
+
+	if ( top < TC_CUE_LEVELS && position > sched->now )
+	{
+		for ( slot = slotOf( sched->now, top ) + 1; slot <= slotOf( position, top ); slot++ )
+		{
+			detachSlot( sched, top, slot, &moved );
+		}
+	}
+
+	int back = ( sched->started && position < sched->now );
+
+	sched->now     = position;
+	sched->started = 1;
+
+	if ( back )
+	{
+		struct tc_cue *cue = sched->fired.head;
+
+		while ( cue != NULL )
+		{
+			struct tc_cue *next = cue->next;
+
+			if ( cue->position > position )
+			{
+				listRemove( &sched->fired, cue );
+				listAppend( &moved, cue );
+			}
+
+			cue = next;
+		}
+	}
+
+	refile( sched, &moved );
+}
+
+
+
+
+void tc_cue_update( struct tc_cue_sched *sched, uint32_t position )
+{
+	applyPosted( sched );
+
+	if ( sched->started && position > sched->now && position - sched->now <= sched->chase )
+	{
+		while ( sched->now < position )
+		{
+			step( sched );
+		}
+	}
+	else if ( !sched->started || position != sched->now )
+	{
+		locate( sched, position );
+	}
+}
+
+
+
+
+uint32_t tc_cue_position( const struct tc_cue_sched *sched, const struct timecode *tc )
+{
+	struct timecode value = *tc;
+
+	if ( value.format != sched->format )
+	{
+		tc_convert_frames( &value, sched->format );
+	}
+
+	int64_t day   = sched->framesPerDay;
+	int64_t now   = __atomic_load_n( &sched->now, __ATOMIC_ACQUIRE );
+	int64_t frame = value.frameNumber % day;
+
+	if ( frame < 0 )
+	{
+		frame += day;
+	}
+
+	int64_t position = now - now % day + frame;
+
+	if ( position < now - day / 2 )
+	{
+		position += day;
+	}
+	else if ( position > now + day / 2 && position >= day )
+	{
+		position -= day;
+	}
+
+	return ( position > UINT32_MAX ) ? UINT32_MAX : (uint32_t)position;
+}
+
+
+void tc_cue_update_tc( struct tc_cue_sched *sched, const struct timecode *tc )
+{
+	tc_cue_update( sched, tc_cue_position( sched, tc ) );
+}
@@ -0,0 +1,190 @@
+#ifndef __tcCue_h__
+#define __tcCue_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Cue scheduler for show control : cues are fired when an external clock
+ *	(LTC, MTC...) reaches their frame.
+ *
+ *	Cues are kept in a hierarchical timer wheel of four levels of 256 slots,
+ *	indexed on the bytes of their position : a cue sits at the level of the
+ *	highest byte where its position differs from the clock, so inserting and
+ *	cancelling are a list link / unlink, and a clock move only re-files the
+ *	cues of the levels below the highest byte that changed.
+ *
+ *	Positions are frame numbers counted from the first midnight, so a clock
+ *	crossing midnight keeps counting up. The scheduler is owned by the clock
+ *	thread, which calls tc_cue_update() : nothing there locks. Other threads
+ *	post their changes with tc_cue_post_insert() / tc_cue_post_cancel(), which
+ *	the next update applies. Since updates take the clock value as argument,
+ *	a simulated clock is just a loop.
+ */
+
+#define TC_CUE_LEVELS      4
+#define TC_CUE_SLOTS       256
+
+#define TC_CUE_CHASE       10   // default largest forward move played, in frames
+
+
+enum TC_CUE_EVENT {
+
+	TC_CUE_FIRED = 0,       // the clock played onto the cue, or located on it
+	TC_CUE_SKIPPED          // the clock located past the cue
+};
+
+
+struct tc_cue;
+
+typedef void (*tc_cue_callback)( struct tc_cue *cue, enum TC_CUE_EVENT event, uint32_t now );
+
+
+struct tc_cue
+{
+	uint32_t         position;    // frame number from the first midnight
+
+	tc_cue_callback  callback;
+	void            *user;
+
+	uint8_t          rearm;       // pending again when the clock goes back before it
+
+
+	/* owned by the scheduler */
+
+	struct tc_cue   *prev;
+	struct tc_cue   *next;
+
+	uint8_t          state;
+
+	/* posted changes */
+
+	struct tc_cue   *posted;
+	uint32_t         postedPosition;
+	int              request;
+	int              queued;
+
+};
+
+
+struct tc_cue_list
+{
+	struct tc_cue   *head;
+	struct tc_cue   *tail;
+};
+
+
+struct tc_cue_sched
+{
+	enum TC_FORMAT      format;
+
+	uint32_t            framesPerDay;
+
+	uint32_t            chase;        // forward moves up to chase frames are played, larger ones locate
+
+	uint32_t            now;          // clock position
+
+	uint8_t             started;
+
+
+	struct tc_cue_list  slots[TC_CUE_LEVELS][TC_CUE_SLOTS];
+
+	uint32_t            levelCount[TC_CUE_LEVELS];
+
+	struct tc_cue_list  due;          // cues being dispatched
+
+	struct tc_cue_list  fired;        // rearm cues behind the clock
+
+	struct tc_cue      *posted;       // changes posted by other threads
+
+	size_t              pending;
+
+};
+
+
+/**
+ *	Returns 0 on success, -1 on an unknown format.
+ */
+
+int tc_cue_init( struct tc_cue_sched *sched, enum TC_FORMAT format );
+
+
+/**
+ *	Clock thread only. Insert returns -1 if the position isn't after the
+ *	clock (once started) ; inserting a pending cue moves it. Cancel returns
+ *	-1 if the cue wasn't pending or fired with rearm.
+ */
+
+int tc_cue_insert( struct tc_cue_sched *sched, struct tc_cue *cue, uint32_t position );
+
+int tc_cue_cancel( struct tc_cue_sched *sched, struct tc_cue *cue );
+
+
+/**
+ *	Any thread : the change is applied by the next tc_cue_update(). The cue
+ *	must stay allocated until then.
+ */
+
+void tc_cue_post_insert( struct tc_cue_sched *sched, struct tc_cue *cue, uint32_t position );
+
+void tc_cue_post_cancel( struct tc_cue_sched *sched, struct tc_cue *cue );
+
+
+/**
+ *	Moves the clock to position, after applying the posted changes.
+ *
+ *	- forward by 1 to chase frames (play, or a chasing clock catching up) :
+ *	  every cue on the way fires, in frame order.
+ *	- any other move (locate) : cues before position are skipped, those on
+ *	  it fire. Going back re-arms the rearm cues after position.
+ *
+ *	The first update is a locate. Callbacks run in this thread, and can
+ *	insert or cancel cues.
+ */
+
+void tc_cue_update( struct tc_cue_sched *sched, uint32_t position );
+
+
+/**
+ *	Position of a timecode for the scheduler : tc is converted to its format
+ *	keeping hh:mm:ss:ff (as tc_convert_frames()), and placed on the day that
+ *	puts it within half a day of the clock. Safe from any thread.
+ */
+
+uint32_t tc_cue_position( const struct tc_cue_sched *sched, const struct timecode *tc );
+
+void tc_cue_update_tc( struct tc_cue_sched *sched, const struct timecode *tc );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcCue_h__
@@ -0,0 +1,216 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string.h>
+#include <math.h>
+
+#include "tcDrift.h"
+
+
+
+
+int tc_drift_init( struct tc_drift *drift, enum TC_FORMAT format, const rational_t *unitRate, double thresholdPpm )
+{
+	memset( drift, 0x00, sizeof(struct tc_drift) );
+
+	rational_t fps = tc_format_rate( format );
+
+	if ( fps.numerator <= 0 || unitRate == NULL || unitRate->numerator <= 0 || unitRate->denominator <= 0 )
+	{
+		return -1;
+	}
+
+	drift->framesPerDay = tc_frames_per_day( format );
+
+	drift->format       = format;
+	drift->unitRate     = *unitRate;
+	drift->thresholdPpm = thresholdPpm;
+
+	/* units per frame = ( unitRate.num / unitRate.den ) / ( fps.num / fps.den ) */
+
+	drift->nominal = ( (double)unitRate->numerator * fps.denominator ) / ( (double)unitRate->denominator * fps.numerator );
+
+	return 0;
+}
+
+
+
+
+int tc_drift_add( struct tc_drift *drift, uint64_t unitValue, int32_t frameNumber )
+{
+	/* a frame more than half a day before the previous one is on the next day */
+
+	int64_t day = drift->day;
+
+	if ( drift->count > 0 )
+	{
+		int64_t d = (int64_t)frameNumber - drift->lastFrame;
+
+		if ( d < -drift->framesPerDay / 2 )
+		{
+			day++;
+		}
+		else if ( d > drift->framesPerDay / 2 )
+		{
+			day--;
+		}
+	}
+	else
+	{
+		drift->x0 = frameNumber;
+		drift->y0 = unitValue;
+	}
+
+	double x = (double)( day * drift->framesPerDay + frameNumber - drift->x0 );
+	double y = ( unitValue >= drift->y0 ) ? (double)( unitValue - drift->y0 ) : -(double)( drift->y0 - unitValue );
+
+	/* fitting what's left of the nominal rate keeps the sums small */
+
+	y -= drift->nominal * x;
+
+
+	/* residual to the fit so far */
+
+	if ( drift->count >= TC_DRIFT_WARMUP && drift->m2x > 0 )
+	{
+		double expected = drift->meanY + drift->cxy / drift->m2x * ( x - drift->meanX );
+
+		if ( fabs( y - expected ) > drift->nominal / 2 )
+		{
+			drift->rejected++;
+			return 1;
+		}
+	}
+
+	drift->day       = day;
+	drift->lastFrame = frameNumber;
+
+	drift->count++;
+
+	double dx = x - drift->meanX;
+	double dy = y - drift->meanY;
+
+	drift->meanX += dx / drift->count;
+	drift->meanY += dy / drift->count;
+
+	drift->m2x += dx * ( x - drift->meanX );
+	drift->m2y += dy * ( y - drift->meanY );
+	drift->cxy += dx * ( y - drift->meanY );
+
+	return 0;
+}
+
+
+
+
+int tc_drift_add_tc( struct tc_drift *drift, uint64_t unitValue, const struct timecode *tc )
+{
+	return tc_drift_add( drift, unitValue, tc->frameNumber );
+}
+
+
+
+
+/*
+ *	Best rational approximation of v with 32 bits terms, by continued
+ *	fractions.
+ */
+
+static rational_t approximate( double v )
+{
+	int64_t p0 = 0, q0 = 1;   // previous convergent
+	int64_t p1 = 1, q1 = 0;   // current
+
+	double x = v;
+
+	int i = 0;
+
+	for ( ; i < 64; i++ )
+	{
+		double  a  = floor( x );
+		int64_t ai = (int64_t)a;
+
+		int64_t p2 = ai * p1 + p0;
+		int64_t q2 = ai * q1 + q0;
+
+		if ( p2 > INT32_MAX || q2 > INT32_MAX )
+		{
+			break;
+		}
+
+		p0 = p1;  q0 = q1;
+		p1 = p2;  q1 = q2;
+
+		if ( x - a < 1e-12 || fabs( (double)p1 / q1 - v ) <= v * 1e-15 )
+		{
+			break;
+		}
+
+		x = 1 / ( x - a );
+	}
+
+	rational_t r = { (int32_t)p1, (int32_t)q1 };
+
+	return r;
+}
+
+
+
+
+int tc_drift_get( const struct tc_drift *drift, struct tc_drift_result *result )
+{
+	memset( result, 0x00, sizeof(struct tc_drift_result) );
+
+	result->count    = drift->count;
+	result->rejected = drift->rejected;
+
+	if ( drift->count < 2 || drift->m2x <= 0 )
+	{
+		return -1;
+	}
+
+	double delta = drift->cxy / drift->m2x;   // slope of the detrended values
+	double slope = drift->nominal + delta;
+
+	result->unitsPerFrame = slope;
+	result->ppm           = delta / drift->nominal * 1e6;
+	result->framesPerDay  = result->ppm * 1e-6 * drift->framesPerDay;
+	result->drifting      = ( fabs( result->ppm ) > drift->thresholdPpm );
+
+
+	/* fit line back to absolute values : y = y0 + meanY + nominal x + delta ( x - meanX ) */
+
+	result->offset = (double)drift->y0 + drift->meanY + delta * ( -(double)drift->x0 - drift->meanX ) - drift->nominal * (double)drift->x0;
+
+
+	/* residual sum of squares : m2y - cxy^2 / m2x */
+
+	double rss = drift->m2y - drift->cxy * delta;
+
+	result->residual = ( rss > 0 ) ? sqrt( rss / drift->count ) : 0;
+
+
+	/* unitRate whose units per frame is the fitted slope */
+
+	rational_t fps = tc_format_rate( drift->format );
+
+	result->unitRate = approximate( slope * fps.numerator / fps.denominator );
+
+	return 0;
+}
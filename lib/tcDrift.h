@@ -0,0 +1,139 @@
+#ifndef __tcDrift_h__
+#define __tcDrift_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Sample clock vs timecode drift estimator.
+ *
+ *	Fed with (unit value, timecode) pairs, eg. the sample position of each
+ *	LTC frame decoded from a recording, it keeps a least squares fit of unit
+ *	value = offset + frame * unitsPerFrame. The sums are of the distance to
+ *	the nominal rate, centered on their running means (Welford), so memory
+ *	is constant and precision doesn't degrade over long recordings.
+ *	Timecode crossing midnight is unwrapped.
+ *
+ *	Once the fit is established, a pair more than half a frame from it is
+ *	rejected as a decoding glitch. A re-jammed clock gets rejected entirely :
+ *	tc_drift_init() again to fit the new segment.
+ */
+
+#define TC_DRIFT_WARMUP   64    // pairs before outliers are rejected
+
+
+struct tc_drift
+{
+	enum TC_FORMAT  format;
+
+	rational_t      unitRate;       // nominal, eg. 48000/1
+
+	double          thresholdPpm;
+
+	int64_t         framesPerDay;
+
+	double          nominal;        // units per frame at unitRate
+
+
+	/* unwrapped frame numbers */
+
+	int32_t         lastFrame;
+	int64_t         day;
+
+
+	/* fit, relative to the first pair */
+
+	int64_t         x0;
+	uint64_t        y0;
+
+	uint64_t        count;
+	uint64_t        rejected;
+
+	double          meanX;
+	double          meanY;
+	double          m2x;            // sum of ( x - meanX )^2
+	double          m2y;
+	double          cxy;            // sum of ( x - meanX ) ( y - meanY )
+
+};
+
+
+struct tc_drift_result
+{
+	uint64_t        count;          // pairs fitted
+	uint64_t        rejected;
+
+	double          unitsPerFrame;  // fitted
+	double          ppm;            // ( fitted / nominal - 1 ) * 1e6 : > 0 if the unit clock runs fast
+	double          framesPerDay;   // drift over a day of timecode, in frames
+	double          offset;         // unit value of frame 0 on the fit
+	double          residual;       // rms distance of the pairs to the fit, in units
+
+	uint8_t         drifting;       // | ppm | above the threshold
+
+	rational_t      unitRate;       // corrected, for tc_set_by_unitValue()
+
+};
+
+
+/**
+ *	thresholdPpm is the drift above which tc_drift_get() flags drifting.
+ *	Returns 0 on success, -1 on an unknown format or a bad rate.
+ */
+
+int tc_drift_init( struct tc_drift *drift, enum TC_FORMAT format, const rational_t *unitRate, double thresholdPpm );
+
+
+/**
+ *	Adds a pair. Returns 0 if it was fitted, 1 if rejected as an outlier.
+ *	Pairs are expected in recording order (unit values going up).
+ */
+
+int tc_drift_add( struct tc_drift *drift, uint64_t unitValue, int32_t frameNumber );
+
+int tc_drift_add_tc( struct tc_drift *drift, uint64_t unitValue, const struct timecode *tc );
+
+
+/**
+ *	Current estimate. Returns 0, or -1 before two distinct frames.
+ *
+ *	result->unitRate is the best rational approximation (32 bits terms) of
+ *	the fitted rate, so that tc_set_by_unitValue( tc, unitValue - offset,
+ *	&result->unitRate, format ) maps the unit values of the recording on
+ *	its timecode, drift included.
+ */
+
+int tc_drift_get( const struct tc_drift *drift, struct tc_drift_result *result );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcDrift_h__
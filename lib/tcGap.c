@@ -0,0 +1,320 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tcGap.h"
+
+
+
+static const char *TC_GAP_KIND_STR[] = {
+	"run",
+	"repeat",
+	"jump",
+	"backward",
+	"rollover",
+	"drop-violation"
+};
+
+
+
+
+int tc_gap_init( struct tc_gap *gap, enum TC_FORMAT format, int32_t increment, tc_gap_callback callback, void *user )
+{
+	if ( format <= TC_FORMAT_UNK || format >= TC_FORMAT_LEN || increment == 0 )
+	{
+		return -1;
+	}
+
+	memset( gap, 0, sizeof(struct tc_gap) );
+
+	gap->format    = format;
+	gap->increment = increment;
+	gap->callback  = callback;
+	gap->user      = user;
+
+	gap->frames24h = tc_frames_per_day( format );
+
+	return 0;
+}
+
+
+
+
+const char * tc_gap_kind_string( enum TC_GAP_KIND kind )
+{
+	return ( kind < TC_GAP_KIND_LEN ) ? TC_GAP_KIND_STR[kind] : "";
+}
+
+
+
+
+/*
+ *	Index of the first frame, from i, which isn't the previous one plus inc
+ *	(or equal to it). This is the whole cost of a clean sequence : SSE2
+ *	compares the deltas of eight frames at a time against the increment.
+ *	Deltas are taken modulo 2^32, so no frame number overflows.
+ */
+
+static size_t scanDeltas( const int32_t *frames, size_t i, size_t count, int32_t inc )
+{
+#ifdef __SSE2__
+
+	__m128i vinc = _mm_set1_epi32( inc );
+
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		__m128i a = _mm_sub_epi32( _mm_loadu_si128( (const __m128i *)( frames + i     ) ),
+		                           _mm_loadu_si128( (const __m128i *)( frames + i - 1 ) ) );
+		__m128i b = _mm_sub_epi32( _mm_loadu_si128( (const __m128i *)( frames + i + 4 ) ),
+		                           _mm_loadu_si128( (const __m128i *)( frames + i + 3 ) ) );
+
+		__m128i eq = _mm_and_si128( _mm_cmpeq_epi32( a, vinc ), _mm_cmpeq_epi32( b, vinc ) );
+
+		if ( _mm_movemask_epi8( eq ) != 0xffff )
+		{
+			break;
+		}
+	}
+
+#endif
+
+	for ( ; i < count; i++ )
+	{
+		if ( (uint32_t)frames[i] - (uint32_t)frames[i-1] != (uint32_t)inc )
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+
+
+
+static void emit( struct tc_gap *gap, const struct tc_gap_event *event )
+{
+	gap->counts[event->kind]++;
+
+	if ( gap->callback != NULL )
+	{
+		gap->callback( gap->user, event );
+	}
+}
+
+
+static void closeCurrent( struct tc_gap *gap )
+{
+	if ( gap->current.count > 0 )
+	{
+		emit( gap, &gap->current );
+	}
+
+	gap->current.count = 0;
+}
+
+
+static void openCurrent( struct tc_gap *gap, enum TC_GAP_KIND kind, uint64_t index, int32_t from, int32_t to )
+{
+	gap->current.kind  = kind;
+	gap->current.index = index;
+	gap->current.count = 1;
+	gap->current.from  = from;
+	gap->current.to    = to;
+}
+
+
+
+
+static enum TC_GAP_KIND classify( const struct tc_gap *gap, int32_t from, int32_t to )
+{
+	int64_t next = (int64_t)from + gap->increment;
+
+	if ( next >= gap->frames24h && next - gap->frames24h == to )
+	{
+		return TC_GAP_ROLLOVER;
+	}
+
+	if ( to > from )
+	{
+		return TC_GAP_JUMP;
+	}
+
+	return TC_GAP_BACKWARD;
+}
+
+
+
+
+/*
+ *	frames[i] breaks the range being extended. Runs and repeats cover the
+ *	indexes, the other events sit between two of them (count is 0).
+ */
+
+static void breakAt( struct tc_gap *gap, uint64_t index, int32_t from, int32_t to )
+{
+	if ( to == from )
+	{
+		closeCurrent( gap );
+		openCurrent( gap, TC_GAP_REPEAT, index, from, to );
+		return;
+	}
+
+	closeCurrent( gap );
+
+	if ( (uint32_t)to - (uint32_t)from != (uint32_t)gap->increment )
+	{
+		struct tc_gap_event event;
+
+		event.kind  = classify( gap, from, to );
+		event.index = index;
+		event.count = 0;
+		event.from  = from;
+		event.to    = to;
+
+		emit( gap, &event );
+	}
+
+	openCurrent( gap, TC_GAP_RUN, index, to, to );
+}
+
+
+
+
+void tc_gap_feed( struct tc_gap *gap, const int32_t *frames, size_t count )
+{
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	uint64_t base = gap->index;
+
+	size_t i = 0;
+
+	if ( !gap->started )
+	{
+		closeCurrent( gap );  // skipped labels before any frame
+
+		openCurrent( gap, TC_GAP_RUN, base, frames[0], frames[0] );
+		gap->last    = frames[0];
+		gap->started = 1;
+		i = 1;
+	}
+	else if ( !( gap->current.kind == TC_GAP_RUN    && (uint32_t)frames[0] - (uint32_t)gap->last == (uint32_t)gap->increment ) &&
+	          !( gap->current.kind == TC_GAP_REPEAT && frames[0] == gap->last ) )
+	{
+		breakAt( gap, base, gap->last, frames[0] );
+		gap->last = frames[0];
+		i = 1;
+	}
+
+
+	while ( i < count )
+	{
+		size_t j = i;
+
+		if ( gap->current.kind == TC_GAP_RUN )
+		{
+			if ( j == 0 )
+			{
+				j++;
+			}
+
+			j = scanDeltas( frames, j, count, gap->increment );
+
+			gap->current.to = frames[j-1];
+		}
+		else
+		{
+			while ( j < count && frames[j] == gap->last )
+			{
+				j++;
+			}
+		}
+
+		gap->current.count += j - i;
+		gap->last = frames[j-1];
+
+		if ( j == count )
+		{
+			break;
+		}
+
+		breakAt( gap, base + j, gap->last, frames[j] );
+		gap->last = frames[j];
+
+		i = j + 1;
+	}
+
+	gap->index = base + count;
+}
+
+
+
+
+void tc_gap_finish( struct tc_gap *gap )
+{
+	closeCurrent( gap );
+}
+
+
+
+
+int tc_gap_is_dropped( enum TC_FORMAT format, uint16_t minutes, uint16_t seconds, uint16_t frames )
+{
+	if ( format != TC_29_97_DF && format != TC_59_94_DF )
+	{
+		return 0;
+	}
+
+	uint16_t drops = ( format == TC_59_94_DF ) ? 4 : 2;
+
+	return ( minutes % 10 != 0 && seconds == 0 && frames < drops );
+}
+
+
+
+
+void tc_gap_feed_dropped( struct tc_gap *gap, uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames )
+{
+	if ( gap->current.kind == TC_GAP_DROP_VIOLATION && gap->current.count > 0 )
+	{
+		gap->current.count++;
+	}
+	else
+	{
+		/* gap->last stays the frame before, for the frame after */
+
+		closeCurrent( gap );
+		openCurrent( gap, TC_GAP_DROP_VIOLATION, gap->index, gap->last, gap->last );
+
+		gap->current.label[0] = hours;
+		gap->current.label[1] = minutes;
+		gap->current.label[2] = seconds;
+		gap->current.label[3] = frames;
+	}
+
+	gap->index++;
+}
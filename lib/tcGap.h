@@ -0,0 +1,146 @@
+#ifndef __tcGap_h__
+#define __tcGap_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Streaming discontinuity detector for per-frame timecode (decoded LTC,
+ *	camera metadata...), given as frame numbers of one format, in chunks of
+ *	any size.
+ *
+ *	The sequence is reported as ranges covering every index once : runs of
+ *	frame numbers advancing by the expected increment, and what broke them.
+ *	Memory doesn't depend on the length of the sequence.
+ *
+ *	Drop frame labels that should have been skipped (mm:00;00 and mm:00;01
+ *	of the minutes not multiple of ten) have no frame number of their own :
+ *	tc_hmsf_to_frames() aliases them to the frames before. A scanner reading
+ *	labels checks them with tc_gap_is_dropped() and feeds those with
+ *	tc_gap_feed_dropped() instead, in sequence with the frames.
+ */
+
+enum TC_GAP_KIND {
+
+	TC_GAP_RUN = 0,          // frames advance by the increment, first to last
+	TC_GAP_REPEAT,           // count copies of the previous frame
+	TC_GAP_JUMP,             // forward jump, from -> to
+	TC_GAP_BACKWARD,         // backward jump, from -> to
+	TC_GAP_ROLLOVER,         // 23:59:59:ff -> 00:00:00:00
+	TC_GAP_DROP_VIOLATION,   // count labels that should have been skipped, from the first
+
+	TC_GAP_KIND_LEN
+};
+
+
+struct tc_gap_event
+{
+	enum TC_GAP_KIND kind;
+
+	uint64_t    index;      // first index of the range, or index after the break
+	uint64_t    count;      // number of indexes in the range, 0 for breaks
+
+	int32_t     from;       // run : first frame, break : frame before it
+	int32_t     to;         // run : last frame,  break : frame at index
+
+	uint16_t    label[4];   // drop violation : first label, hh mm ss ff
+
+};
+
+
+typedef void (*tc_gap_callback)( void *user, const struct tc_gap_event *event );
+
+
+struct tc_gap
+{
+	enum TC_FORMAT   format;
+
+	int32_t          increment;   // expected delta between frames, usually 1
+
+	int32_t          frames24h;   // frame numbers in a day, for rollovers
+
+	tc_gap_callback  callback;
+	void            *user;
+
+
+	uint64_t         index;       // index of the next frame
+	int32_t          last;        // last frame seen
+	uint8_t          started;     // a frame was fed
+
+	struct tc_gap_event current;  // run or repeat being extended
+
+
+	uint64_t         counts[TC_GAP_KIND_LEN];  // events reported, by kind
+
+};
+
+
+/**
+ *	Returns 0 on success, -1 on an unknown format or a null increment.
+ */
+
+int tc_gap_init( struct tc_gap *gap, enum TC_FORMAT format, int32_t increment, tc_gap_callback callback, void *user );
+
+
+/**
+ *	Scans count more frames. Events are reported once their range is closed,
+ *	so the last run or repeat only comes with tc_gap_finish().
+ */
+
+void tc_gap_feed( struct tc_gap *gap, const int32_t *frames, size_t count );
+
+void tc_gap_finish( struct tc_gap *gap );
+
+
+/**
+ *	1 if hh:mm:ss:ff is a label format skips (mm:00;00 to mm:00;03 at
+ *	59.94 DF), 0 otherwise and for non drop frame formats.
+ */
+
+int tc_gap_is_dropped( enum TC_FORMAT format, uint16_t minutes, uint16_t seconds, uint16_t frames );
+
+
+/**
+ *	Takes a skipped label at the next index. Consecutive ones make one
+ *	TC_GAP_DROP_VIOLATION range (from and to are the frame before them), and
+ *	the frame after them is compared with the frame before them.
+ */
+
+void tc_gap_feed_dropped( struct tc_gap *gap, uint16_t hours, uint16_t minutes, uint16_t seconds, uint16_t frames );
+
+
+const char * tc_gap_kind_string( enum TC_GAP_KIND kind );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcGap_h__
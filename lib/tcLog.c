@@ -0,0 +1,871 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tcLog.h"
+
+
+
+#define LOG_MAGIC          0x474c4354  // "TCLG"
+#define LOG_INDEX_MAGIC    0x494c4354  // "TCLI"
+#define LOG_VERSION        1
+
+#define LOG_HEADER_SIZE    32
+#define LOG_BLOCK_SIZE     32
+#define LOG_ENTRY_SIZE     40
+#define LOG_TRAILER_SIZE   32
+
+#define LOG_RUN_MAX        15          // varint delta + varint length
+
+
+
+
+static inline uint32_t rd32( const uint8_t *p ) { return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t)p[3] << 24 ); }
+static inline uint64_t rd64( const uint8_t *p ) { return rd32( p ) | ( (uint64_t)rd32( p + 4 ) << 32 ); }
+
+static inline void wr32( uint8_t *p, uint32_t v ) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static inline void wr64( uint8_t *p, uint64_t v ) { wr32( p, (uint32_t)v ); wr32( p + 4, (uint32_t)( v >> 32 ) ); }
+
+
+static inline size_t putVarint( uint8_t *p, uint64_t v )
+{
+	size_t n = 0;
+
+	while ( v >= 0x80 )
+	{
+		p[n++] = (uint8_t)v | 0x80;
+		v >>= 7;
+	}
+
+	p[n++] = (uint8_t)v;
+
+	return n;
+}
+
+
+/* returns NULL past end or on an overlong varint */
+
+static inline const uint8_t * getVarint( const uint8_t *p, const uint8_t *end, uint64_t *v )
+{
+	uint64_t     value = 0;
+	unsigned int shift = 0;
+
+	while ( p < end && shift < 64 )
+	{
+		uint8_t byte = *p++;
+
+		value |= (uint64_t)( byte & 0x7f ) << shift;
+
+		if ( !( byte & 0x80 ) )
+		{
+			*v = value;
+			return p;
+		}
+
+		shift += 7;
+	}
+
+	return NULL;
+}
+
+
+static inline uint64_t zigzag( int64_t v )    { return ( (uint64_t)v << 1 ) ^ (uint64_t)( v >> 63 ); }
+static inline int64_t  unzigzag( uint64_t v ) { return (int64_t)( v >> 1 ) ^ -(int64_t)( v & 1 ); }
+
+
+
+
+/*
+ *	Block headers and index entries, to and from their file layout.
+ */
+
+static void putBlockHeader( uint8_t *p, const struct tc_log_block *b, uint32_t size )
+{
+	memset( p, 0x00, LOG_BLOCK_SIZE );
+
+	wr32( p,      b->count );
+	wr32( p + 4,  size );
+	wr32( p + 8,  b->flags );
+	wr32( p + 12, (uint32_t)b->first );
+	wr32( p + 16, (uint32_t)b->last );
+	wr32( p + 20, (uint32_t)b->min );
+	wr32( p + 24, (uint32_t)b->max );
+}
+
+
+static void getBlockHeader( const uint8_t *p, struct tc_log_block *b, uint32_t *size )
+{
+	b->count = rd32( p );
+	*size    = rd32( p + 4 );
+	b->flags = rd32( p + 8 );
+	b->first = (int32_t)rd32( p + 12 );
+	b->last  = (int32_t)rd32( p + 16 );
+	b->min   = (int32_t)rd32( p + 20 );
+	b->max   = (int32_t)rd32( p + 24 );
+}
+
+
+static void putEntry( uint8_t *p, const struct tc_log_block *b )
+{
+	wr64( p,      b->offset );
+	wr64( p + 8,  b->firstIndex );
+	wr32( p + 16, b->count );
+	wr32( p + 20, b->flags );
+	wr32( p + 24, (uint32_t)b->first );
+	wr32( p + 28, (uint32_t)b->last );
+	wr32( p + 32, (uint32_t)b->min );
+	wr32( p + 36, (uint32_t)b->max );
+}
+
+
+static void getEntry( const uint8_t *p, struct tc_log_block *b )
+{
+	b->offset     = rd64( p );
+	b->firstIndex = rd64( p + 8 );
+	b->count      = rd32( p + 16 );
+	b->flags      = rd32( p + 20 );
+	b->first      = (int32_t)rd32( p + 24 );
+	b->last       = (int32_t)rd32( p + 28 );
+	b->min        = (int32_t)rd32( p + 32 );
+	b->max        = (int32_t)rd32( p + 36 );
+}
+
+
+static int pushBlock( struct tc_log_block **blocks, size_t *count, size_t *capacity, const struct tc_log_block *b )
+{
+	if ( *count == *capacity )
+	{
+		size_t grown = ( *capacity > 0 ) ? *capacity * 2 : 256;
+
+		struct tc_log_block *tmp = realloc( *blocks, grown * sizeof(struct tc_log_block) );
+
+		if ( tmp == NULL )
+		{
+			return -1;
+		}
+
+		*blocks   = tmp;
+		*capacity = grown;
+	}
+
+	(*blocks)[(*count)++] = *b;
+
+	return 0;
+}
+
+
+
+
+static int writeData( struct tc_log_writer *w, const void *data, size_t size )
+{
+	if ( fwrite( data, 1, size, w->fp ) != size )
+	{
+		return -1;
+	}
+
+	w->offset += size;
+
+	return 0;
+}
+
+
+static void putRun( struct tc_log_writer *w )
+{
+	w->runsSize += putVarint( w->runs + w->runsSize, zigzag( w->runDelta ) );
+	w->runsSize += putVarint( w->runs + w->runsSize, w->runLength );
+
+	w->runLength = 0;
+}
+
+
+static int flushBlock( struct tc_log_writer *w )
+{
+	if ( w->current.count == 0 )
+	{
+		return 0;
+	}
+
+	if ( w->runLength > 0 )
+	{
+		putRun( w );
+	}
+
+	uint8_t header[LOG_BLOCK_SIZE];
+
+	putBlockHeader( header, &w->current, w->runsSize );
+
+	w->current.offset = w->offset;
+
+	if ( writeData( w, header, LOG_BLOCK_SIZE ) < 0 || writeData( w, w->runs, w->runsSize ) < 0 ||
+	     pushBlock( &w->blocks, &w->blockCount, &w->blockCapacity, &w->current ) < 0 )
+	{
+		return -1;
+	}
+
+	w->current.count = 0;
+	w->runsSize      = 0;
+
+	return 0;
+}
+
+
+
+
+static int writerInit( struct tc_log_writer *w, FILE *fp, enum TC_FORMAT format, uint32_t blockSize )
+{
+	memset( w, 0x00, sizeof(struct tc_log_writer) );
+
+	w->fp        = fp;
+	w->format    = format;
+	w->blockSize = ( blockSize > 0 ) ? blockSize : TC_LOG_BLOCK;
+	w->runs      = malloc( (size_t)w->blockSize * LOG_RUN_MAX );
+
+	if ( w->runs == NULL )
+	{
+		if ( fp != stdout )
+		{
+			fclose( fp );
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+int tc_log_writer_create( struct tc_log_writer *w, const char *path, enum TC_FORMAT format, uint32_t blockSize )
+{
+	FILE *fp = ( strcmp( path, "-" ) == 0 ) ? stdout : fopen( path, "wb" );
+
+	if ( fp == NULL || writerInit( w, fp, format, blockSize ) < 0 )
+	{
+		return -1;
+	}
+
+	uint8_t header[LOG_HEADER_SIZE];
+
+	memset( header, 0x00, LOG_HEADER_SIZE );
+
+	wr32( header,      LOG_MAGIC );
+	wr32( header + 4,  LOG_VERSION );
+	wr32( header + 8,  format );
+	wr32( header + 12, w->blockSize );
+
+	if ( writeData( w, header, LOG_HEADER_SIZE ) < 0 )
+	{
+		tc_log_writer_close( w );
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+int tc_log_writer_append( struct tc_log_writer *w, const char *path, enum TC_FORMAT format, uint32_t blockSize )
+{
+	struct stat st;
+
+	if ( strcmp( path, "-" ) == 0 || stat( path, &st ) < 0 || st.st_size == 0 )
+	{
+		return tc_log_writer_create( w, path, format, blockSize );
+	}
+
+	struct tc_log log;
+
+	if ( tc_log_open( &log, path ) < 0 )
+	{
+		return -1;
+	}
+
+	blockSize = rd32( log.map.data + 12 );
+
+	if ( log.format != format )
+	{
+		tc_log_close( &log );
+		errno = EINVAL;
+		return -1;
+	}
+
+	FILE *fp = fopen( path, "r+b" );
+
+	/* the values go after the last whole block, over the old index */
+
+	if ( fp == NULL || writerInit( w, fp, format, blockSize ) < 0 )
+	{
+		tc_log_close( &log );
+		return -1;
+	}
+
+	w->blocks        = log.blocks;
+	w->blockCount    = log.blockCount;
+	w->blockCapacity = log.blockCount;
+	w->count         = log.count;
+	w->offset        = log.end;
+
+	log.blocks = NULL;
+
+	tc_log_close( &log );
+
+	if ( fflush( fp ) != 0 || ftruncate( fileno( fp ), w->offset ) < 0 || fseek( fp, 0, SEEK_END ) != 0 )
+	{
+		tc_log_writer_close( w );
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+int tc_log_write( struct tc_log_writer *w, const int32_t *frames, size_t count )
+{
+	struct tc_log_block *b = &w->current;
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		int32_t v = frames[i];
+
+		if ( b->count == 0 )
+		{
+			b->firstIndex = w->count;
+			b->flags      = TC_LOG_MONOTONIC;
+			b->first      = v;
+			b->min        = v;
+			b->max        = v;
+		}
+		else
+		{
+			int64_t delta = (int64_t)v - b->last;
+
+			if ( w->runLength > 0 && delta == w->runDelta )
+			{
+				w->runLength++;
+			}
+			else
+			{
+				if ( w->runLength > 0 )
+				{
+					putRun( w );
+				}
+
+				w->runDelta  = delta;
+				w->runLength = 1;
+			}
+
+			if ( delta < 0 )
+			{
+				b->flags &= ~TC_LOG_MONOTONIC;
+			}
+
+			if ( v < b->min )  b->min = v;
+			if ( v > b->max )  b->max = v;
+		}
+
+		b->last = v;
+		b->count++;
+
+		w->count++;
+
+		if ( b->count == w->blockSize && flushBlock( w ) < 0 )
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+
+int tc_log_writer_close( struct tc_log_writer *w )
+{
+	int rc = flushBlock( w );
+
+	uint64_t indexOffset = w->offset;
+
+	size_t i = 0;
+
+	for ( ; rc == 0 && i < w->blockCount; i++ )
+	{
+		uint8_t entry[LOG_ENTRY_SIZE];
+
+		putEntry( entry, &w->blocks[i] );
+
+		rc = writeData( w, entry, LOG_ENTRY_SIZE );
+	}
+
+	if ( rc == 0 )
+	{
+		uint8_t trailer[LOG_TRAILER_SIZE];
+
+		memset( trailer, 0x00, LOG_TRAILER_SIZE );
+
+		wr64( trailer,      indexOffset );
+		wr64( trailer + 8,  w->blockCount );
+		wr64( trailer + 16, w->count );
+		wr32( trailer + 28, LOG_INDEX_MAGIC );
+
+		rc = writeData( w, trailer, LOG_TRAILER_SIZE );
+	}
+
+	if ( w->fp == stdout )
+	{
+		rc |= fflush( w->fp );
+	}
+	else if ( w->fp != NULL )
+	{
+		rc |= fclose( w->fp );
+	}
+
+	free( w->runs );
+	free( w->blocks );
+
+	memset( w, 0x00, sizeof(struct tc_log_writer) );
+
+	return ( rc != 0 ) ? -1 : 0;
+}
+
+
+
+
+/*
+ *	The index at the end of the file, if the writer closed it.
+ */
+
+static int loadIndex( struct tc_log *log )
+{
+	const uint8_t *data = log->map.data;
+
+	size_t size = log->map.size;
+
+	if ( size < LOG_HEADER_SIZE + LOG_TRAILER_SIZE || rd32( data + size - 4 ) != LOG_INDEX_MAGIC )
+	{
+		return -1;
+	}
+
+	const uint8_t *trailer = data + size - LOG_TRAILER_SIZE;
+
+	uint64_t indexOffset = rd64( trailer );
+	uint64_t blocks      = rd64( trailer + 8 );
+
+	if ( indexOffset < LOG_HEADER_SIZE || indexOffset > size || blocks != ( size - LOG_TRAILER_SIZE - indexOffset ) / LOG_ENTRY_SIZE ||
+	     indexOffset + blocks * LOG_ENTRY_SIZE + LOG_TRAILER_SIZE != size )
+	{
+		return -1;
+	}
+
+	log->blocks = malloc( ( blocks + 1 ) * sizeof(struct tc_log_block) );
+
+	if ( log->blocks == NULL )
+	{
+		return -1;
+	}
+
+	uint64_t i = 0;
+
+	for ( ; i < blocks; i++ )
+	{
+		struct tc_log_block *b = &log->blocks[i];
+
+		getEntry( data + indexOffset + i * LOG_ENTRY_SIZE, b );
+
+		if ( b->offset < LOG_HEADER_SIZE || b->offset + LOG_BLOCK_SIZE > indexOffset || b->firstIndex != log->count || b->count == 0 )
+		{
+			free( log->blocks );
+			log->blocks = NULL;
+			log->count  = 0;
+			return -1;
+		}
+
+		log->count += b->count;
+	}
+
+	log->blockCount = blocks;
+	log->end        = indexOffset;
+	log->indexed    = 1;
+
+	return 0;
+}
+
+
+/*
+ *	No index (the writer didn't close the log) : walk the block headers,
+ *	up to the first incomplete one.
+ */
+
+static int rebuildIndex( struct tc_log *log )
+{
+	size_t capacity = 0;
+
+	uint64_t offset = LOG_HEADER_SIZE;
+
+	while ( offset + LOG_BLOCK_SIZE <= log->map.size )
+	{
+		struct tc_log_block b;
+
+		uint32_t size;
+
+		getBlockHeader( log->map.data + offset, &b, &size );
+
+		if ( b.count == 0 || offset + LOG_BLOCK_SIZE + size > log->map.size )
+		{
+			break;
+		}
+
+		b.offset     = offset;
+		b.firstIndex = log->count;
+
+		if ( pushBlock( &log->blocks, &log->blockCount, &capacity, &b ) < 0 )
+		{
+			return -1;
+		}
+
+		log->count += b.count;
+
+		offset += LOG_BLOCK_SIZE + size;
+	}
+
+	log->end = offset;
+
+	return 0;
+}
+
+
+
+
+int tc_log_open( struct tc_log *log, const char *path )
+{
+	memset( log, 0x00, sizeof(struct tc_log) );
+
+	if ( tc_map_open( &log->map, path ) < 0 )
+	{
+		return -1;
+	}
+
+	const uint8_t *data = log->map.data;
+
+	if ( log->map.size < LOG_HEADER_SIZE || rd32( data ) != LOG_MAGIC || rd32( data + 4 ) != LOG_VERSION || rd32( data + 8 ) >= TC_FORMAT_LEN )
+	{
+		tc_log_close( log );
+		errno = EINVAL;
+		return -1;
+	}
+
+	log->format = rd32( data + 8 );
+
+	if ( loadIndex( log ) < 0 && rebuildIndex( log ) < 0 )
+	{
+		tc_log_close( log );
+		return -1;
+	}
+
+
+	/* sorted : every block goes up, and starts where the previous one ended */
+
+	log->sorted = 1;
+
+	size_t i = 0;
+
+	for ( ; i < log->blockCount; i++ )
+	{
+		const struct tc_log_block *b = &log->blocks[i];
+
+		if ( !( b->flags & TC_LOG_MONOTONIC ) || ( i > 0 && b->first < log->blocks[i-1].last ) )
+		{
+			log->sorted = 0;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+
+
+
+void tc_log_close( struct tc_log *log )
+{
+	tc_map_close( &log->map );
+
+	free( log->blocks );
+
+	memset( log, 0x00, sizeof(struct tc_log) );
+}
+
+
+
+
+/*
+ *	Runs of a block, as [p, end).
+ */
+
+static const uint8_t * blockRuns( const struct tc_log *log, const struct tc_log_block *b, const uint8_t **end )
+{
+	uint32_t size = rd32( log->map.data + b->offset + 4 );
+
+	if ( b->offset + LOG_BLOCK_SIZE + size > log->end )
+	{
+		*end = NULL;
+		return NULL;
+	}
+
+	const uint8_t *p = log->map.data + b->offset + LOG_BLOCK_SIZE;
+
+	*end = p + size;
+
+	return p;
+}
+
+
+/* block holding index, or blockCount */
+
+static size_t blockOf( const struct tc_log *log, uint64_t index )
+{
+	size_t lo = 0, hi = log->blockCount;
+
+	while ( lo < hi )
+	{
+		size_t mid = lo + ( hi - lo ) / 2;
+
+		if ( log->blocks[mid].firstIndex + log->blocks[mid].count <= index )
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+
+
+/*
+ *	In a run of length values going by delta from v (excluded), target is
+ *	the k-th value when target - v is k deltas : no need to decode the run.
+ */
+
+static int64_t findInBlock( const struct tc_log *log, const struct tc_log_block *b, int32_t target, uint64_t from )
+{
+	const uint8_t *end;
+	const uint8_t *p = blockRuns( log, b, &end );
+
+	uint64_t index = b->firstIndex;
+	int64_t  v     = b->first;
+
+	if ( index >= from && v == target )
+	{
+		return index;
+	}
+
+	uint64_t last = b->firstIndex + b->count - 1;
+
+	while ( p != NULL && p < end && index < last )
+	{
+		uint64_t zz, length;
+
+		if ( ( p = getVarint( p, end, &zz ) ) == NULL || ( p = getVarint( p, end, &length ) ) == NULL || length > last - index )
+		{
+			break;
+		}
+
+		int64_t delta = unzigzag( zz );
+
+		if ( delta == 0 )
+		{
+			if ( v == target )
+			{
+				uint64_t k = ( from > index + 1 ) ? from - index : 1;
+
+				if ( k <= length )
+				{
+					return index + k;
+				}
+			}
+		}
+		else if ( ( target - v ) % delta == 0 )
+		{
+			int64_t k = ( target - v ) / delta;
+
+			if ( k >= 1 && (uint64_t)k <= length && index + k >= from )
+			{
+				return index + k;
+			}
+		}
+
+		v     += delta * (int64_t)length;
+		index += length;
+	}
+
+	return -1;
+}
+
+
+
+
+int64_t tc_log_find( const struct tc_log *log, int32_t frameNumber, uint64_t from )
+{
+	size_t i = blockOf( log, from );
+
+	if ( log->sorted )
+	{
+		/* the first block reaching frameNumber, max being sorted too */
+
+		size_t lo = i, hi = log->blockCount;
+
+		while ( lo < hi )
+		{
+			size_t mid = lo + ( hi - lo ) / 2;
+
+			if ( log->blocks[mid].max < frameNumber )
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+
+		for ( i = lo; i < log->blockCount && log->blocks[i].min <= frameNumber; i++ )
+		{
+			int64_t index = findInBlock( log, &log->blocks[i], frameNumber, from );
+
+			if ( index >= 0 )
+			{
+				return index;
+			}
+		}
+
+		return -1;
+	}
+
+	for ( ; i < log->blockCount; i++ )
+	{
+		const struct tc_log_block *b = &log->blocks[i];
+
+		if ( frameNumber >= b->min && frameNumber <= b->max )
+		{
+			int64_t index = findInBlock( log, b, frameNumber, from );
+
+			if ( index >= 0 )
+			{
+				return index;
+			}
+		}
+	}
+
+	return -1;
+}
+
+
+
+
+int64_t tc_log_find_tc( const struct tc_log *log, const struct timecode *tc, uint64_t from )
+{
+	return tc_log_find( log, tc_hmsf_to_frames( tc->hours, tc->minutes, tc->seconds, tc->frames, log->format ), from );
+}
+
+
+
+
+size_t tc_log_read( const struct tc_log *log, uint64_t index, int32_t *frames, size_t count )
+{
+	size_t n = 0;
+
+	size_t i = blockOf( log, index );
+
+	for ( ; i < log->blockCount && n < count; i++ )
+	{
+		const struct tc_log_block *b = &log->blocks[i];
+
+		const uint8_t *end;
+		const uint8_t *p = blockRuns( log, b, &end );
+
+		uint64_t at   = b->firstIndex;
+		uint64_t last = b->firstIndex + b->count - 1;
+		int64_t  v    = b->first;
+
+		if ( at >= index )
+		{
+			frames[n++] = (int32_t)v;
+		}
+
+		while ( p != NULL && p < end && at < last && n < count )
+		{
+			uint64_t zz, length;
+
+			if ( ( p = getVarint( p, end, &zz ) ) == NULL || ( p = getVarint( p, end, &length ) ) == NULL || length > last - at )
+			{
+				return n;
+			}
+
+			int64_t delta = unzigzag( zz );
+
+			/* runs wholly before index are skipped in one step */
+
+			if ( at + length < index )
+			{
+				v  += delta * (int64_t)length;
+				at += length;
+				continue;
+			}
+
+			uint64_t k = 1;
+
+			if ( index > at + 1 )
+			{
+				k  = index - at;
+			}
+
+			for ( ; k <= length && n < count; k++ )
+			{
+				frames[n++] = (int32_t)( v + delta * (int64_t)k );
+			}
+
+			v  += delta * (int64_t)length;
+			at += length;
+		}
+
+		if ( at < last && n < count )
+		{
+			return n;  // damaged block
+		}
+	}
+
+	return n;
+}
@@ -0,0 +1,200 @@
+#ifndef __tcLog_h__
+#define __tcLog_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+#include "tcMap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Binary log of per-frame timecode : the frame number of each recorded
+ *	frame, in one format, indexed by the position of the frame (its index).
+ *
+ *	Values are stored in blocks of consecutive indexes. A block header keeps
+ *	its first, last, min and max frame numbers, and the values are coded as
+ *	runs of equal deltas (zigzag varint delta, varint length) : a continuous
+ *	recording is one run of +1 per block, a few bytes for thousands of
+ *	frames. A sparse index of the blocks is written at the end of the file,
+ *	so a reader maps the file, loads the index, and only decodes the runs of
+ *	the blocks that can hold what it looks for.
+ *
+ *	All integers are little-endian.
+ *
+ *	    header   "TCLG", version, format, block size          32 bytes
+ *	    block    count, size, flags, first, last, min, max    32 bytes
+ *	             runs                                          size bytes
+ *	    ...
+ *	    index    offset, first index, count, flags,
+ *	             first, last, min, max per block               40 bytes each
+ *	    trailer  index offset, blocks, count, "TCLI"           32 bytes
+ *
+ *	A log whose writer didn't close it has no index : readers rebuild it from
+ *	the block headers, and appending continues after the last whole block.
+ */
+
+#define TC_LOG_BLOCK     4096    // default values per block
+
+
+struct tc_log_block
+{
+	uint64_t    offset;        // of the block header in the file
+	uint64_t    firstIndex;
+
+	uint32_t    count;
+	uint32_t    flags;         // TC_LOG_MONOTONIC
+
+	int32_t     first;
+	int32_t     last;
+	int32_t     min;
+	int32_t     max;
+
+};
+
+#define TC_LOG_MONOTONIC  0x01   // no delta of the block is negative
+
+
+struct tc_log_writer
+{
+	FILE               *fp;
+
+	enum TC_FORMAT      format;
+
+	uint32_t            blockSize;   // values per block
+
+	uint64_t            count;       // values written
+	uint64_t            offset;      // file size
+
+
+	/* block being coded */
+
+	struct tc_log_block current;
+
+	uint8_t            *runs;
+	size_t              runsSize;
+
+	int64_t             runDelta;
+	uint32_t            runLength;
+
+
+	struct tc_log_block *blocks;
+	size_t               blockCount;
+	size_t               blockCapacity;
+
+};
+
+
+/**
+ *	Creates path (truncated if it exists) with blockSize values per block,
+ *	TC_LOG_BLOCK if 0. The writer never seeks : path "-" writes to stdout.
+ *
+ *	tc_log_writer_append() opens an existing log to add values after its
+ *	own, or creates it. Its format must be format.
+ *
+ *	Return 0 on success, -1 on error.
+ */
+
+int tc_log_writer_create( struct tc_log_writer *w, const char *path, enum TC_FORMAT format, uint32_t blockSize );
+
+int tc_log_writer_append( struct tc_log_writer *w, const char *path, enum TC_FORMAT format, uint32_t blockSize );
+
+
+/**
+ *	Adds count frame numbers. Returns 0 on success, -1 on write error.
+ */
+
+int tc_log_write( struct tc_log_writer *w, const int32_t *frames, size_t count );
+
+
+/**
+ *	Writes the last block and the index, and closes the file. Returns 0 on
+ *	success, -1 on write error.
+ */
+
+int tc_log_writer_close( struct tc_log_writer *w );
+
+
+
+
+struct tc_log
+{
+	struct tc_map        map;
+
+	enum TC_FORMAT       format;
+
+	uint64_t             count;
+
+	struct tc_log_block *blocks;
+	size_t               blockCount;
+
+	uint64_t             end;      // end of the last whole block
+
+	uint8_t              sorted;   // frame numbers never go down, across blocks
+
+	uint8_t              indexed;  // 0 if the index was rebuilt
+
+};
+
+
+/**
+ *	Maps a log. Returns 0 on success, -1 if it can't be read or isn't a log.
+ */
+
+int tc_log_open( struct tc_log *log, const char *path );
+
+void tc_log_close( struct tc_log *log );
+
+
+/**
+ *	First index at or after from whose frame number is frameNumber, or -1.
+ *	Only the blocks whose [min, max] hold it are decoded, found by binary
+ *	search when the log is sorted. Repeated frames are found by searching
+ *	again from the index after.
+ *
+ *	tc_log_find_tc() looks for the hh:mm:ss:ff of tc in the format of the
+ *	log, eg. from tc_set_by_string( &tc, "14:22:05;12", TC_29_97_DF ).
+ */
+
+int64_t tc_log_find( const struct tc_log *log, int32_t frameNumber, uint64_t from );
+
+int64_t tc_log_find_tc( const struct tc_log *log, const struct timecode *tc, uint64_t from );
+
+
+/**
+ *	Decodes up to count frame numbers from index. Returns the number read.
+ */
+
+size_t tc_log_read( const struct tc_log *log, uint64_t index, int32_t *frames, size_t count );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcLog_h__
@@ -0,0 +1,145 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "tcMap.h"
+
+
+
+
+int tc_map_open( struct tc_map *map, const char *path )
+{
+	memset( map, 0x00, sizeof(struct tc_map) );
+
+#ifndef _WIN32
+
+	int fd = open( path, O_RDONLY );
+
+	if ( fd < 0 )
+	{
+		return -1;
+	}
+
+	struct stat st;
+
+	if ( fstat( fd, &st ) < 0 )
+	{
+		close( fd );
+		return -1;
+	}
+
+	if ( st.st_size == 0 )
+	{
+		close( fd );
+		return 0;
+	}
+
+	void *data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+	close( fd );
+
+	if ( data == MAP_FAILED )
+	{
+		return -1;
+	}
+
+	/* containers are mostly walked front to back */
+
+	madvise( data, st.st_size, MADV_SEQUENTIAL );
+
+	map->data   = data;
+	map->size   = st.st_size;
+	map->mapped = 1;
+
+	return 0;
+
+#else
+
+	FILE *fp = fopen( path, "rb" );
+
+	if ( fp == NULL )
+	{
+		return -1;
+	}
+
+	fseek( fp, 0, SEEK_END );
+
+	long size = ftell( fp );
+
+	fseek( fp, 0, SEEK_SET );
+
+	if ( size <= 0 )
+	{
+		fclose( fp );
+		return ( size < 0 ) ? -1 : 0;
+	}
+
+	uint8_t *data = malloc( size );
+
+	if ( data == NULL || fread( data, 1, size, fp ) != (size_t)size )
+	{
+		free( data );
+		fclose( fp );
+		return -1;
+	}
+
+	fclose( fp );
+
+	map->data = data;
+	map->size = size;
+
+	return 0;
+
+#endif
+}
+
+
+
+
+void tc_map_close( struct tc_map *map )
+{
+	if ( map->data == NULL )
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	if ( map->mapped )
+	{
+		munmap( (void*)map->data, map->size );
+	}
+	else
+#endif
+	{
+		free( (void*)map->data );
+	}
+
+	memset( map, 0x00, sizeof(struct tc_map) );
+}
@@ -0,0 +1,56 @@
+#ifndef __tcMap_h__
+#define __tcMap_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+/*
+ *	Read-only file mapping, used by the modules that parse large containers
+ *	in place. Files are memory-mapped where the platform allows it, and
+ *	read into memory otherwise.
+ */
+
+struct tc_map
+{
+	const uint8_t *data;
+
+	size_t         size;
+
+
+	uint8_t        mapped;  // 1 if data must be munmap()ed, 0 if free()d
+
+};
+
+
+/**
+ *	Maps path into map. Returns 0 on success, -1 on error (errno is set).
+ *	An empty file is a success with map->data == NULL.
+ */
+
+int tc_map_open( struct tc_map *map, const char *path );
+
+void tc_map_close( struct tc_map *map );
+
+
+#endif // ! __tcMap_h__
@@ -0,0 +1,1006 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "tcMedia.h"
+#include "tcMap.h"
+
+
+
+#ifdef _WIN32
+#define lstat stat
+#endif
+
+
+static inline uint16_t rd16be( const uint8_t *p ) { return ( p[0] << 8 ) | p[1]; }
+static inline uint32_t rd32be( const uint8_t *p ) { return ( (uint32_t)p[0] << 24 ) | ( p[1] << 16 ) | ( p[2] << 8 ) | p[3]; }
+static inline uint64_t rd64be( const uint8_t *p ) { return ( (uint64_t)rd32be( p ) << 32 ) | rd32be( p + 4 ); }
+
+static inline uint32_t rd32le( const uint8_t *p ) { return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t)p[3] << 24 ); }
+static inline uint64_t rd64le( const uint8_t *p ) { return rd32le( p ) | ( (uint64_t)rd32le( p + 4 ) << 32 ); }
+
+
+
+
+enum TC_FORMAT tc_media_format( rational_t rate, uint16_t base, uint8_t dropFrame )
+{
+	int known = ( rate.numerator > 0 && rate.denominator > 0 );
+
+	unsigned int f = TC_FORMAT_UNK + 1;
+
+	for ( ; f < TC_FORMAT_LEN; f++ )
+	{
+		rational_t r = tc_format_rate( f );
+
+		uint8_t isDrop = ( f == TC_29_97_DF || f == TC_59_94_DF );
+
+		if ( isDrop != ( dropFrame != 0 ) )
+		{
+			continue;
+		}
+
+		if ( known )
+		{
+			if ( (int64_t)r.numerator * rate.denominator == (int64_t)rate.numerator * r.denominator )
+			{
+				return f;
+			}
+		}
+		else if ( tc_format_fps( f ) == base && ( isDrop || r.denominator == 1 ) )
+		{
+			/* without a rate, a non drop base is taken as an integer rate */
+
+			return f;
+		}
+	}
+
+	return TC_FORMAT_UNK;
+}
+
+
+
+
+/*
+ *	MXF
+ *
+ *	KLV : 16 bytes key, BER length, value. Header metadata sets are local
+ *	sets (2 bytes tag, 2 bytes length) referring to each other by their
+ *	InstanceUID : Material Package -> Tracks -> Sequence -> Structural
+ *	Components, one of which is the Timecode Component.
+ */
+
+#define MXF_RUN_IN_MAX     65536
+
+#define MXF_MATERIAL_PACKAGE   0x36
+#define MXF_TIMELINE_TRACK     0x3b
+#define MXF_SEQUENCE           0x0f
+#define MXF_TIMECODE           0x14
+
+#define MXF_TAG_INSTANCE_UID   0x3c0a
+#define MXF_TAG_TRACKS         0x4403
+#define MXF_TAG_EDIT_RATE      0x4b01
+#define MXF_TAG_SEQUENCE       0x4803
+#define MXF_TAG_COMPONENTS     0x1001
+#define MXF_TAG_START          0x1501
+#define MXF_TAG_BASE           0x1502
+#define MXF_TAG_DROP           0x1503
+
+
+static const uint8_t MXF_PARTITION_KEY[] = { 0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01, 0x0d, 0x01, 0x02, 0x01, 0x01 };
+static const uint8_t MXF_SET_KEY[]       = { 0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01, 0x0d, 0x01, 0x01, 0x01, 0x01 };
+
+
+struct mxf_set
+{
+	uint8_t         type;          // byte 14 of the key
+	const uint8_t  *uid;
+
+	const uint8_t  *value;
+	size_t          len;
+
+};
+
+
+struct mxf_sets
+{
+	struct mxf_set *sets;
+	size_t          count;
+	size_t          capacity;
+
+};
+
+
+/* keys match but for byte 7, the registry version */
+
+static int mxfKey( const uint8_t *key, const uint8_t *ref )
+{
+	return memcmp( key, ref, 7 ) == 0 && memcmp( key + 8, ref + 8, 5 ) == 0;
+}
+
+
+/* returns the value of the KLV at p, NULL if it goes past end */
+
+static const uint8_t * mxfKLV( const uint8_t *p, const uint8_t *end, uint64_t *len )
+{
+	if ( end - p < 17 )
+	{
+		return NULL;
+	}
+
+	p += 16;
+
+	uint8_t first = *p++;
+
+	if ( first < 0x80 )
+	{
+		*len = first;
+	}
+	else
+	{
+		unsigned int n = first & 0x7f;
+
+		if ( n > 8 || end - p < n )
+		{
+			return NULL;
+		}
+
+		for ( *len = 0; n > 0; n-- )
+		{
+			*len = ( *len << 8 ) | *p++;
+		}
+	}
+
+	return ( *len <= (uint64_t)( end - p ) ) ? p : NULL;
+}
+
+
+static const uint8_t * mxfTag( const struct mxf_set *set, uint16_t tag, size_t *len )
+{
+	const uint8_t *p   = set->value;
+	const uint8_t *end = set->value + set->len;
+
+	while ( end - p >= 4 )
+	{
+		uint16_t t = rd16be( p );
+		uint16_t l = rd16be( p + 2 );
+
+		if ( l > end - p - 4 )
+		{
+			break;
+		}
+
+		if ( t == tag )
+		{
+			*len = l;
+			return p + 4;
+		}
+
+		p += 4 + l;
+	}
+
+	return NULL;
+}
+
+
+static const struct mxf_set * mxfFind( const struct mxf_sets *sets, const uint8_t *uid )
+{
+	size_t i = 0;
+
+	for ( ; i < sets->count; i++ )
+	{
+		if ( sets->sets[i].uid != NULL && memcmp( sets->sets[i].uid, uid, 16 ) == 0 )
+		{
+			return &sets->sets[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ *	Collects the structural sets of the header metadata following the
+ *	partition pack at p. Returns 0, or -1 if p isn't a partition pack.
+ */
+
+static int mxfCollect( const uint8_t *p, const uint8_t *end, struct mxf_sets *sets, uint64_t *footer )
+{
+	uint64_t len;
+
+	const uint8_t *value = mxfKLV( p, end, &len );
+
+	if ( value == NULL || !mxfKey( p, MXF_PARTITION_KEY ) || len < 40 )
+	{
+		return -1;
+	}
+
+	*footer = rd64be( value + 24 );
+
+	uint64_t headerBytes = rd64be( value + 32 );
+
+	p = value + len;
+
+	/* fill before the primer isn't always counted */
+
+	if ( end - p > 16 && p[4] == 0x01 && memcmp( p + 8, "\x03\x01\x02\x10\x01", 5 ) == 0 && mxfKLV( p, end, &len ) != NULL )
+	{
+		p = mxfKLV( p, end, &len ) + len;
+	}
+
+	if ( headerBytes < (uint64_t)( end - p ) )
+	{
+		end = p + headerBytes;
+	}
+
+	while ( ( value = mxfKLV( p, end, &len ) ) != NULL )
+	{
+		if ( mxfKey( p, MXF_SET_KEY ) && p[13] == 0x01 )
+		{
+			if ( sets->count == sets->capacity )
+			{
+				size_t grown = ( sets->capacity > 0 ) ? sets->capacity * 2 : 64;
+
+				struct mxf_set *tmp = realloc( sets->sets, grown * sizeof(struct mxf_set) );
+
+				if ( tmp == NULL )
+				{
+					break;
+				}
+
+				sets->sets     = tmp;
+				sets->capacity = grown;
+			}
+
+			struct mxf_set *set = &sets->sets[sets->count++];
+
+			size_t uidLen = 0;
+
+			set->type  = p[14];
+			set->value = value;
+			set->len   = len;
+			set->uid   = mxfTag( set, MXF_TAG_INSTANCE_UID, &uidLen );
+
+			if ( uidLen != 16 )
+			{
+				set->uid = NULL;
+			}
+		}
+
+		p = value + len;
+	}
+
+	return 0;
+}
+
+
+static int mxfTimecode( const struct mxf_set *set, rational_t rate, struct tc_media_info *info )
+{
+	size_t len = 0;
+
+	const uint8_t *start = mxfTag( set, MXF_TAG_START, &len );
+
+	if ( start == NULL || len != 8 )
+	{
+		return -1;
+	}
+
+	const uint8_t *base = mxfTag( set, MXF_TAG_BASE, &len );
+
+	if ( base == NULL || len != 2 )
+	{
+		return -1;
+	}
+
+	const uint8_t *drop = mxfTag( set, MXF_TAG_DROP, &len );
+
+	info->type       = TC_MEDIA_MXF;
+	info->startFrame = (int64_t)rd64be( start );
+	info->base       = rd16be( base );
+	info->dropFrame  = ( drop != NULL && len == 1 && *drop != 0 );
+	info->rate       = rate;
+	info->format     = tc_media_format( rate, info->base, info->dropFrame );
+
+	return 0;
+}
+
+
+/* first Timecode Component of the tracks of the Material Package */
+
+static int mxfResolve( const struct mxf_sets *sets, struct tc_media_info *info )
+{
+	size_t i = 0, len = 0;
+
+	for ( ; i < sets->count; i++ )
+	{
+		if ( sets->sets[i].type != MXF_MATERIAL_PACKAGE )
+		{
+			continue;
+		}
+
+		const uint8_t *tracks = mxfTag( &sets->sets[i], MXF_TAG_TRACKS, &len );
+
+		if ( tracks == NULL || len < 8 || rd32be( tracks + 4 ) != 16 || rd32be( tracks ) > ( len - 8 ) / 16 )
+		{
+			continue;
+		}
+
+		uint32_t t = 0, trackCount = rd32be( tracks );
+
+		for ( ; t < trackCount; t++ )
+		{
+			const struct mxf_set *track = mxfFind( sets, tracks + 8 + t * 16 );
+
+			if ( track == NULL || track->type != MXF_TIMELINE_TRACK )
+			{
+				continue;
+			}
+
+			rational_t rate = { 0, 0 };
+
+			const uint8_t *editRate = mxfTag( track, MXF_TAG_EDIT_RATE, &len );
+
+			if ( editRate != NULL && len == 8 )
+			{
+				rate.numerator   = (int32_t)rd32be( editRate );
+				rate.denominator = (int32_t)rd32be( editRate + 4 );
+			}
+
+			const uint8_t *ref = mxfTag( track, MXF_TAG_SEQUENCE, &len );
+
+			const struct mxf_set *seq = ( ref != NULL && len == 16 ) ? mxfFind( sets, ref ) : NULL;
+
+			if ( seq == NULL )
+			{
+				continue;
+			}
+
+			if ( seq->type == MXF_TIMECODE )
+			{
+				if ( mxfTimecode( seq, rate, info ) == 0 )
+				{
+					return 0;
+				}
+
+				continue;
+			}
+
+			const uint8_t *components = mxfTag( seq, MXF_TAG_COMPONENTS, &len );
+
+			if ( seq->type != MXF_SEQUENCE || components == NULL || len < 8 || rd32be( components + 4 ) != 16 || rd32be( components ) > ( len - 8 ) / 16 )
+			{
+				continue;
+			}
+
+			uint32_t c = 0, componentCount = rd32be( components );
+
+			for ( ; c < componentCount; c++ )
+			{
+				const struct mxf_set *component = mxfFind( sets, components + 8 + c * 16 );
+
+				if ( component != NULL && component->type == MXF_TIMECODE && mxfTimecode( component, rate, info ) == 0 )
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	return -1;
+}
+
+
+static int parseMXF( const uint8_t *data, size_t size, struct tc_media_info *info )
+{
+	/* the header partition follows an optional run-in */
+
+	size_t runIn = 0;
+
+	while ( runIn + 16 <= size && runIn <= MXF_RUN_IN_MAX && !mxfKey( data + runIn, MXF_PARTITION_KEY ) )
+	{
+		runIn++;
+	}
+
+	if ( runIn + 16 > size || runIn > MXF_RUN_IN_MAX )
+	{
+		return -1;
+	}
+
+	const uint8_t *base = data + runIn;
+	const uint8_t *end  = data + size;
+
+	struct mxf_sets sets;
+
+	memset( &sets, 0x00, sizeof(struct mxf_sets) );
+
+	uint64_t footer = 0, unused = 0;
+
+	int rc = mxfCollect( base, end, &sets, &footer );
+
+	if ( rc == 0 )
+	{
+		rc = mxfResolve( &sets, info );
+	}
+
+	/* open header : the footer has the final metadata */
+
+	if ( rc < 0 && footer > 0 && footer < (uint64_t)( end - base ) )
+	{
+		sets.count = 0;
+
+		if ( mxfCollect( base + footer, end, &sets, &unused ) == 0 )
+		{
+			rc = mxfResolve( &sets, info );
+		}
+	}
+
+	free( sets.sets );
+
+	return rc;
+}
+
+
+
+
+/*
+ *	QuickTime / MP4
+ *
+ *	Atoms : 32 bits size (1 : 64 bits size follows the type, 0 : up to the
+ *	end), 4 chars type. The tmcd sample description of a timecode track
+ *	gives the rate, and its first sample, a 32 bits frame number, the start.
+ */
+
+#define MOV_DROP_FRAME  0x0001
+
+
+/* payload of the first atom of type in [p, end), NULL if there is none */
+
+static const uint8_t * movAtom( const uint8_t *p, const uint8_t *end, const char *type, const uint8_t **atomEnd )
+{
+	while ( end - p >= 8 )
+	{
+		uint64_t size   = rd32be( p );
+		size_t   header = 8;
+
+		if ( size == 1 )
+		{
+			if ( end - p < 16 )
+			{
+				return NULL;
+			}
+
+			size   = rd64be( p + 8 );
+			header = 16;
+		}
+		else if ( size == 0 )
+		{
+			size = end - p;
+		}
+
+		if ( size < header || size > (uint64_t)( end - p ) )
+		{
+			return NULL;
+		}
+
+		if ( memcmp( p + 4, type, 4 ) == 0 )
+		{
+			*atomEnd = p + size;
+			return p + header;
+		}
+
+		p += size;
+	}
+
+	return NULL;
+}
+
+
+static int movTrack( const uint8_t *data, size_t size, const uint8_t *trak, const uint8_t *trakEnd, struct tc_media_info *info )
+{
+	const uint8_t *end = trakEnd;
+
+	const uint8_t *p = movAtom( trak, end, "mdia", &end );
+
+	p = ( p != NULL ) ? movAtom( p, end, "minf", &end ) : NULL;
+	p = ( p != NULL ) ? movAtom( p, end, "stbl", &end ) : NULL;
+
+	if ( p == NULL )
+	{
+		return -1;
+	}
+
+	const uint8_t *stbl = p, *stblEnd = end;
+
+	const uint8_t *stsd = movAtom( stbl, stblEnd, "stsd", &end );
+
+	/* version / flags, entry count, then the entry : size, format, 8 reserved bytes, tmcd fields */
+
+	if ( stsd == NULL || end - stsd < 8 + 34 || memcmp( stsd + 12, "tmcd", 4 ) != 0 )
+	{
+		return -1;
+	}
+
+	const uint8_t *entry = stsd + 8;
+
+	uint32_t flags         = rd32be( entry + 20 );
+	uint32_t timeScale     = rd32be( entry + 24 );
+	uint32_t frameDuration = rd32be( entry + 28 );
+	uint8_t  frames        = entry[32];
+
+	/* first chunk offset */
+
+	uint64_t offset = 0;
+
+	const uint8_t *co = movAtom( stbl, stblEnd, "stco", &end );
+
+	if ( co != NULL && end - co >= 12 && rd32be( co + 4 ) > 0 )
+	{
+		offset = rd32be( co + 8 );
+	}
+	else if ( ( co = movAtom( stbl, stblEnd, "co64", &end ) ) != NULL && end - co >= 16 && rd32be( co + 4 ) > 0 )
+	{
+		offset = rd64be( co + 8 );
+	}
+	else
+	{
+		return -1;
+	}
+
+	if ( offset + 4 > size )
+	{
+		return -1;
+	}
+
+	info->type       = TC_MEDIA_MOV;
+	info->startFrame = rd32be( data + offset );
+	info->base       = frames;
+	info->dropFrame  = ( flags & MOV_DROP_FRAME ) != 0;
+
+	info->rate.numerator   = ( timeScale <= INT32_MAX ) ? (int32_t)timeScale : 0;
+	info->rate.denominator = ( frameDuration <= INT32_MAX ) ? (int32_t)frameDuration : 0;
+
+	info->format = tc_media_format( info->rate, info->base, info->dropFrame );
+
+	return 0;
+}
+
+
+static int parseMOV( const uint8_t *data, size_t size, struct tc_media_info *info )
+{
+	const uint8_t *end = data + size;
+	const uint8_t *moovEnd;
+
+	const uint8_t *moov = movAtom( data, end, "moov", &moovEnd );
+
+	if ( moov == NULL )
+	{
+		return -1;
+	}
+
+	const uint8_t *p = moov;
+	const uint8_t *trakEnd;
+	const uint8_t *trak;
+
+	while ( ( trak = movAtom( p, moovEnd, "trak", &trakEnd ) ) != NULL )
+	{
+		if ( movTrack( data, size, trak, trakEnd, info ) == 0 )
+		{
+			return 0;
+		}
+
+		p = trakEnd;
+	}
+
+	return -1;
+}
+
+
+
+
+/*
+ *	BWF
+ *
+ *	RIFF / RF64 / BW64 chunks : 4 chars id, 32 bits size, data padded to an
+ *	even size. In RF64, sizes of 0xffffffff are in the ds64 chunk.
+ */
+
+#define BEXT_TIME_REFERENCE  338
+
+
+static int parseWAV( const uint8_t *data, size_t size, struct tc_media_info *info )
+{
+	if ( size < 12 || memcmp( data + 8, "WAVE", 4 ) != 0 )
+	{
+		return -1;
+	}
+
+	uint64_t dataSize = 0;   // from ds64
+
+	uint32_t sampleRate = 0;
+
+	int hasBext = 0;
+
+	size_t p = 12;
+
+	while ( p + 8 <= size )
+	{
+		const uint8_t *chunk = data + p;
+
+		uint64_t len = rd32le( chunk + 4 );
+
+		if ( memcmp( chunk, "ds64", 4 ) == 0 && len >= 16 && p + 8 + 16 <= size )
+		{
+			dataSize = rd64le( chunk + 8 + 8 );
+		}
+		else if ( memcmp( chunk, "fmt ", 4 ) == 0 && len >= 8 && p + 16 <= size )
+		{
+			sampleRate = rd32le( chunk + 8 + 4 );
+		}
+		else if ( memcmp( chunk, "bext", 4 ) == 0 && len >= BEXT_TIME_REFERENCE + 8 && p + 8 + BEXT_TIME_REFERENCE + 8 <= size )
+		{
+			info->unitValue = rd64le( chunk + 8 + BEXT_TIME_REFERENCE );
+			hasBext = 1;
+		}
+		else if ( memcmp( chunk, "data", 4 ) == 0 && len == 0xffffffff )
+		{
+			len = dataSize;
+		}
+
+		if ( hasBext && sampleRate > 0 )
+		{
+			break;
+		}
+
+		/* a chunk past the end (a bogus ds64 size) ends the walk */
+
+		if ( len > size - p - 8 )
+		{
+			break;
+		}
+
+		p += 8 + len;
+		p += ( len & 1 );
+	}
+
+	if ( !hasBext || sampleRate == 0 || sampleRate > INT32_MAX )
+	{
+		return -1;
+	}
+
+	info->type               = TC_MEDIA_WAV;
+	info->format             = TC_FORMAT_UNK;
+	info->unitRate.numerator   = sampleRate;
+	info->unitRate.denominator = 1;
+
+	return 0;
+}
+
+
+
+
+int tc_media_parse( const uint8_t *data, size_t size, struct tc_media_info *info )
+{
+	memset( info, 0x00, sizeof(struct tc_media_info) );
+
+	if ( data == NULL || size < 16 )
+	{
+		return -1;
+	}
+
+	if ( memcmp( data, "RIFF", 4 ) == 0 || memcmp( data, "RF64", 4 ) == 0 || memcmp( data, "BW64", 4 ) == 0 )
+	{
+		return parseWAV( data, size, info );
+	}
+
+	static const char *movAtoms[] = { "ftyp", "moov", "mdat", "wide", "free", "skip", "pnot", NULL };
+
+	unsigned int i = 0;
+
+	for ( ; movAtoms[i] != NULL; i++ )
+	{
+		if ( memcmp( data + 4, movAtoms[i], 4 ) == 0 )
+		{
+			return parseMOV( data, size, info );
+		}
+	}
+
+	return parseMXF( data, size, info );
+}
+
+
+
+
+int tc_media_read( const char *path, struct tc_media_info *info )
+{
+	struct tc_map map;
+
+	memset( info, 0x00, sizeof(struct tc_media_info) );
+
+	if ( tc_map_open( &map, path ) < 0 )
+	{
+		return -1;
+	}
+
+	int rc = tc_media_parse( map.data, map.size, info );
+
+	tc_map_close( &map );
+
+	return rc;
+}
+
+
+
+
+int tc_media_get( const struct tc_media_info *info, enum TC_FORMAT format, struct timecode *tc )
+{
+	if ( info->format != TC_FORMAT_UNK )
+	{
+		tc_set_by_frames( tc, (uint32_t)info->startFrame, info->format );
+		return 0;
+	}
+
+	if ( format == TC_FORMAT_UNK )
+	{
+		return -1;
+	}
+
+	rational_t rate  = ( info->type == TC_MEDIA_WAV ) ? info->unitRate : info->rate;
+	uint64_t   value = ( info->type == TC_MEDIA_WAV ) ? info->unitValue : (uint64_t)info->startFrame;
+
+	if ( rate.numerator <= 0 || rate.denominator <= 0 )
+	{
+		return -1;
+	}
+
+	tc_set_by_unitValue( tc, value, &rate, format );
+
+	return 0;
+}
+
+
+
+
+/*
+ *	Directory scan : this thread walks the tree and queues the paths, the
+ *	workers read them.
+ */
+
+#define SCAN_QUEUE  1024
+
+
+struct media_scan
+{
+	pthread_mutex_t     lock;
+	pthread_cond_t      ready;
+	pthread_cond_t      space;
+
+	char               *queue[SCAN_QUEUE];
+	size_t              head;
+	size_t              count;
+	int                 done;
+
+	pthread_mutex_t     output;
+
+	tc_media_callback   callback;
+	void               *user;
+
+};
+
+
+static void * scanWorker( void *arg )
+{
+	struct media_scan *scan = arg;
+
+	for ( ;; )
+	{
+		pthread_mutex_lock( &scan->lock );
+
+		while ( scan->count == 0 && !scan->done )
+		{
+			pthread_cond_wait( &scan->ready, &scan->lock );
+		}
+
+		if ( scan->count == 0 )
+		{
+			pthread_mutex_unlock( &scan->lock );
+			break;
+		}
+
+		char *path = scan->queue[scan->head];
+
+		scan->head = ( scan->head + 1 ) % SCAN_QUEUE;
+		scan->count--;
+
+		pthread_cond_signal( &scan->space );
+		pthread_mutex_unlock( &scan->lock );
+
+		struct tc_media_info info;
+
+		int rc = tc_media_read( path, &info );
+
+		pthread_mutex_lock( &scan->output );
+		scan->callback( scan->user, path, rc, &info );
+		pthread_mutex_unlock( &scan->output );
+
+		free( path );
+	}
+
+	return NULL;
+}
+
+
+static void scanPush( struct media_scan *scan, const char *path )
+{
+	char *copy = strdup( path );
+
+	if ( copy == NULL )
+	{
+		return;
+	}
+
+	pthread_mutex_lock( &scan->lock );
+
+	while ( scan->count == SCAN_QUEUE )
+	{
+		pthread_cond_wait( &scan->space, &scan->lock );
+	}
+
+	scan->queue[ ( scan->head + scan->count ) % SCAN_QUEUE ] = copy;
+	scan->count++;
+
+	pthread_cond_signal( &scan->ready );
+	pthread_mutex_unlock( &scan->lock );
+}
+
+
+/* symbolic links to directories aren't followed, so there is no loop */
+
+static void scanWalk( struct media_scan *scan, const char *dir )
+{
+	DIR *d = opendir( dir );
+
+	if ( d == NULL )
+	{
+		return;
+	}
+
+	size_t dirLen = strlen( dir );
+
+	struct dirent *entry;
+
+	while ( ( entry = readdir( d ) ) != NULL )
+	{
+		if ( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 )
+		{
+			continue;
+		}
+
+		size_t len = dirLen + 1 + strlen( entry->d_name ) + 1;
+
+		char *path = malloc( len );
+
+		if ( path == NULL )
+		{
+			break;
+		}
+
+		snprintf( path, len, "%s%s%s", dir, ( dirLen > 0 && dir[dirLen-1] == '/' ) ? "" : "/", entry->d_name );
+
+		struct stat st;
+
+		if ( lstat( path, &st ) == 0 )
+		{
+			if ( S_ISDIR( st.st_mode ) )
+			{
+				scanWalk( scan, path );
+			}
+			else if ( S_ISREG( st.st_mode ) || ( stat( path, &st ) == 0 && S_ISREG( st.st_mode ) ) )
+			{
+				scanPush( scan, path );
+			}
+		}
+
+		free( path );
+	}
+
+	closedir( d );
+}
+
+
+
+
+int tc_media_scan( const char *path, unsigned int threads, tc_media_callback callback, void *user )
+{
+	struct stat st;
+
+	if ( stat( path, &st ) < 0 )
+	{
+		return -1;
+	}
+
+	struct media_scan scan;
+
+	memset( &scan, 0x00, sizeof(struct media_scan) );
+
+	scan.callback = callback;
+	scan.user     = user;
+
+	pthread_mutex_init( &scan.lock, NULL );
+	pthread_mutex_init( &scan.output, NULL );
+	pthread_cond_init( &scan.ready, NULL );
+	pthread_cond_init( &scan.space, NULL );
+
+	if ( threads < 1 )
+	{
+		threads = 1;
+	}
+
+	pthread_t *workers = calloc( threads, sizeof(pthread_t) );
+
+	unsigned int started = 0;
+
+	while ( workers != NULL && started < threads && pthread_create( &workers[started], NULL, scanWorker, &scan ) == 0 )
+	{
+		started++;
+	}
+
+	if ( started == 0 )
+	{
+		free( workers );
+		pthread_mutex_destroy( &scan.lock );
+		pthread_mutex_destroy( &scan.output );
+		pthread_cond_destroy( &scan.ready );
+		pthread_cond_destroy( &scan.space );
+		return -1;
+	}
+
+	if ( S_ISDIR( st.st_mode ) )
+	{
+		scanWalk( &scan, path );
+	}
+	else
+	{
+		scanPush( &scan, path );
+	}
+
+	pthread_mutex_lock( &scan.lock );
+	scan.done = 1;
+	pthread_cond_broadcast( &scan.ready );
+	pthread_mutex_unlock( &scan.lock );
+
+	unsigned int i = 0;
+
+	for ( ; i < started; i++ )
+	{
+		pthread_join( workers[i], NULL );
+	}
+
+	free( workers );
+
+	pthread_mutex_destroy( &scan.lock );
+	pthread_mutex_destroy( &scan.output );
+	pthread_cond_destroy( &scan.ready );
+	pthread_cond_destroy( &scan.space );
+
+	return 0;
+}
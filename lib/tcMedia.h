@@ -0,0 +1,121 @@
+#ifndef __tcMedia_h__
+#define __tcMedia_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Start timecode of media files, read from their metadata only :
+ *
+ *	- MXF : StartTimecode, RoundedTimecodeBase and DropFrame of the
+ *	  TimecodeComponent of the Material Package, with the edit rate of its
+ *	  track. Only the header metadata is parsed (the footer's if the header
+ *	  partition has none).
+ *	- QuickTime / MP4 : the first sample of the tmcd track, with the flags,
+ *	  time scale, frame duration and number of frames of its sample
+ *	  description. Atoms are walked by size, so mdat is skipped whole.
+ *	- BWF : TimeReference of the bext chunk, in samples since midnight at
+ *	  the sample rate of the fmt chunk. The file doesn't tell the frame rate.
+ *
+ *	Files are mapped, so only the pages holding the metadata are read.
+ */
+
+enum TC_MEDIA_TYPE {
+
+	TC_MEDIA_UNK = 0,
+	TC_MEDIA_MXF,
+	TC_MEDIA_MOV,
+	TC_MEDIA_WAV
+};
+
+
+struct tc_media_info
+{
+	enum TC_MEDIA_TYPE  type;
+
+	enum TC_FORMAT      format;      // TC_FORMAT_UNK for BWF, or a rate libTC doesn't have
+
+	rational_t          rate;        // timecode rate as stored (MXF track edit rate, MOV timescale / duration)
+	uint16_t            base;        // rounded rate : RoundedTimecodeBase, MOV number of frames
+	uint8_t             dropFrame;
+
+	int64_t             startFrame;  // MXF / MOV start, in frames since midnight
+
+	uint64_t            unitValue;   // BWF start, in samples since midnight
+	rational_t          unitRate;    // BWF sample rate
+
+};
+
+
+/**
+ *	Reads the start timecode of path, of data in memory for
+ *	tc_media_parse(). Return 0 on success, -1 if the file can't be read, or
+ *	isn't a MXF, QuickTime or BWF file with a start timecode.
+ */
+
+int tc_media_read( const char *path, struct tc_media_info *info );
+
+int tc_media_parse( const uint8_t *data, size_t size, struct tc_media_info *info );
+
+
+/**
+ *	Sets tc to the start of info : tc_set_by_frames() in the format of the
+ *	file, or tc_set_by_unitValue() in format for a BWF file (or a MXF / MOV
+ *	rate libTC doesn't have). Returns -1 if there is no format to use.
+ */
+
+int tc_media_get( const struct tc_media_info *info, enum TC_FORMAT format, struct timecode *tc );
+
+
+/**
+ *	Format of a timecode rate, rounded base and drop frame flag, as files
+ *	store them. rate can be 0/0 when only the base is known.
+ */
+
+enum TC_FORMAT tc_media_format( rational_t rate, uint16_t base, uint8_t dropFrame );
+
+
+/**
+ *	Reads every file under path (a file or a directory, walked recursively)
+ *	on threads threads. callback is called once per file, with rc the
+ *	result of tc_media_read(), from one thread at a time, in no particular
+ *	order. Returns 0, or -1 if path can't be opened.
+ */
+
+typedef void (*tc_media_callback)( void *user, const char *path, int rc, const struct tc_media_info *info );
+
+int tc_media_scan( const char *path, unsigned int threads, tc_media_callback callback, void *user );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcMedia_h__
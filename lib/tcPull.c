@@ -0,0 +1,171 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "tcPull.h"
+#include "tcRational.h"
+
+
+
+static const rational_t TC_SPEED_RATIO[] = {
+	{    1,    1 },  // NONE
+	{ 1001, 1000 },  // PULL_UP
+	{ 1000, 1001 },  // PULL_DOWN
+	{   25,   24 },  // 24_TO_25
+	{   24,   25 }   // 25_TO_24
+};
+
+
+
+
+/*
+ *	( v * num + bias ) / den. Products that fit 64 bits (every sample count
+ *	below a few days at any sane ratio) skip the 128 bit division.
+ */
+
+static inline uint64_t scaleValue( uint64_t v, uint64_t num, uint64_t den, uint64_t bias, uint64_t limit )
+{
+	return ( v <= limit ) ? ( v * num + bias ) / den : tc_muldiv( v, num, den, bias );
+}
+
+
+static void reduce( uint64_t *num, uint64_t *den )
+{
+	uint64_t g = tc_gcd( *num, *den );
+
+	*num /= g;
+	*den /= g;
+}
+
+
+/*
+ *	Positions are rounded to the nearest position of the other clock.
+ */
+
+static void scale( const uint64_t *in, uint64_t *out, size_t count, uint64_t num, uint64_t den )
+{
+	reduce( &num, &den );
+
+	uint64_t bias  = den / 2;
+	uint64_t limit = ( UINT64_MAX - bias ) / num;
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		out[i] = scaleValue( in[i], num, den, bias, limit );
+	}
+}
+
+
+
+
+rational_t tc_speed_ratio( enum TC_SPEED speed )
+{
+	if ( speed >= TC_SPEED_LEN )
+	{
+		speed = TC_SPEED_NONE;
+	}
+
+	return TC_SPEED_RATIO[speed];
+}
+
+
+
+
+int tc_pull_init( struct tc_pull *pull, rational_t nominal, rational_t speed )
+{
+	memset( pull, 0x00, sizeof(struct tc_pull) );
+
+	if ( nominal.numerator <= 0 || nominal.denominator <= 0 ||
+	     speed.numerator   <= 0 || speed.denominator   <= 0 )
+	{
+		return -1;
+	}
+
+	uint64_t sg = tc_gcd( speed.numerator, speed.denominator );
+
+	uint64_t num = (uint64_t)nominal.numerator   * ( speed.numerator   / sg );
+	uint64_t den = (uint64_t)nominal.denominator * ( speed.denominator / sg );
+
+	uint64_t g = tc_gcd( num, den );
+
+	num /= g;
+	den /= g;
+
+	if ( num > INT32_MAX || den > INT32_MAX )
+	{
+		return -1;
+	}
+
+	pull->nominal           = nominal;
+	pull->pulled.numerator   = num;
+	pull->pulled.denominator = den;
+	pull->speed.numerator    = speed.numerator   / sg;
+	pull->speed.denominator  = speed.denominator / sg;
+
+	return 0;
+}
+
+
+
+
+void tc_pull_to_pulled( const struct tc_pull *pull, const uint64_t *in, uint64_t *out, size_t count )
+{
+	scale( in, out, count, pull->speed.numerator, pull->speed.denominator );
+}
+
+
+void tc_pull_to_nominal( const struct tc_pull *pull, const uint64_t *in, uint64_t *out, size_t count )
+{
+	scale( in, out, count, pull->speed.denominator, pull->speed.numerator );
+}
+
+
+
+
+void tc_pull_to_frames( const struct tc_pull *pull, enum TC_PULL_DOMAIN domain, const uint64_t *in, uint32_t *frames, size_t count, enum TC_FORMAT format )
+{
+	rational_t fps  = tc_format_rate( format );
+	rational_t rate = ( domain == TC_PULL_PULLED ) ? pull->pulled : pull->nominal;
+
+	if ( fps.numerator <= 0 || rate.numerator <= 0 )
+	{
+		memset( frames, 0x00, count * sizeof(uint32_t) );
+		return;
+	}
+
+	uint64_t num = (uint64_t)fps.numerator   * (uint64_t)rate.denominator;
+	uint64_t den = (uint64_t)fps.denominator * (uint64_t)rate.numerator;
+
+	reduce( &num, &den );
+
+	/* truncated, half a position late, as unitValueToFrames() does */
+
+	uint64_t bias  = num / 2;
+	uint64_t limit = ( UINT64_MAX - bias ) / num;
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		frames[i] = (uint32_t)scaleValue( in[i], num, den, bias, limit );
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef __tcPull_h__
+#define __tcPull_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Speed changes between a nominal and a pulled clock.
+ *
+ *	A speed change is modelled as two clocks counting the same real time :
+ *	the nominal one (eg. 48000 Hz) and the pulled one, nominal * speed (eg.
+ *	47952 Hz for a 0.1% pull-down, 48048 Hz for a pull-up, 50000 Hz for a
+ *	24 -> 25 transfer). Position p of one clock is p * pulled / nominal of
+ *	the other.
+ *
+ *	All mappings are exact rational products, rounded once, and work on whole
+ *	arrays of positions. Positions of one clock are rounded to the nearest
+ *	position of the other (half up) ; frame numbers are the frame holding
+ *	the position, taken half a position late like tc_set_by_unitValue().
+ */
+
+enum TC_SPEED {
+
+	TC_SPEED_NONE = 0,
+
+	TC_SPEED_PULL_UP,       // 1001/1000 : 48000 Hz -> 48048 Hz, 23.976 -> 24
+	TC_SPEED_PULL_DOWN,     // 1000/1001 : 48000 Hz -> 47952 Hz, 24 -> 23.976
+	TC_SPEED_24_TO_25,      // 25/24     : film to PAL speed-up
+	TC_SPEED_25_TO_24,      // 24/25     : PAL to film slow-down
+
+	TC_SPEED_LEN
+};
+
+
+enum TC_PULL_DOMAIN {
+
+	TC_PULL_NOMINAL = 0,    // positions counted with the nominal clock
+	TC_PULL_PULLED          // positions counted with the pulled clock
+};
+
+
+struct tc_pull
+{
+	rational_t  nominal;    // clock of the recording, eg. 48000/1
+	rational_t  pulled;     // clock it is played at, eg. 47952/1
+	rational_t  speed;      // pulled / nominal, reduced
+
+};
+
+
+rational_t tc_speed_ratio( enum TC_SPEED speed );
+
+
+/**
+ *	Sets the model from a nominal clock and a speed ratio (see
+ *	tc_speed_ratio()). Returns 0 on success, -1 if a rate isn't positive or
+ *	the pulled clock doesn't fit a rational_t.
+ */
+
+int tc_pull_init( struct tc_pull *pull, rational_t nominal, rational_t speed );
+
+
+/**
+ *	Maps count positions from the nominal clock domain to the pulled one, and
+ *	back. in and out can be the same array.
+ */
+
+void tc_pull_to_pulled( const struct tc_pull *pull, const uint64_t *in, uint64_t *out, size_t count );
+
+void tc_pull_to_nominal( const struct tc_pull *pull, const uint64_t *in, uint64_t *out, size_t count );
+
+
+/**
+ *	Maps count positions of the domain clock to frame numbers of format, the
+ *	same tc_set_by_unitValue() gives with that clock as unit rate : the
+ *	frame holding the position, half a position late (truncated). Frame
+ *	numbers are not wrapped at 24 hours : use tc_set_by_frames() for hmsf.
+ */
+
+void tc_pull_to_frames( const struct tc_pull *pull, enum TC_PULL_DOMAIN domain, const uint64_t *in, uint32_t *frames, size_t count, enum TC_FORMAT format );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcPull_h__
@@ -0,0 +1,409 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "tcRadix.h"
+
+
+
+/*
+ *	Below this many keys per thread, a pass isn't worth starting threads.
+ */
+
+#define RADIX_MIN_PER_THREAD  (256 * 1024)
+#define RADIX_MAX_THREADS     64
+
+
+
+
+uint64_t tc_radix_frame_ticks( enum TC_FORMAT format )
+{
+	rational_t fps = tc_format_rate( format );
+
+	if ( fps.numerator <= 0 )
+	{
+		return 0;
+	}
+
+	return (uint64_t)TC_RADIX_TICKS * fps.denominator / fps.numerator;
+}
+
+
+
+
+void tc_radix_keys( const struct tc_array *array, uint64_t *keys, uint8_t unwrapDays )
+{
+	enum TC_FORMAT format = TC_FORMAT_UNK;
+
+	int64_t frameTicks = 0;
+	int64_t dayTicks   = 0;
+
+	int64_t day  = 0;
+	int64_t prev = 0;
+	int64_t min  = 0;
+
+	size_t i = 0;
+
+	for ( ; i < array->count; i++ )
+	{
+		if ( i == 0 || array->formats[i] != format )
+		{
+			format     = array->formats[i];
+			frameTicks = tc_radix_frame_ticks( format );
+			dayTicks   = (int64_t)tc_frames_per_day( format ) * frameTicks;
+		}
+
+		int64_t ticks = ( array->frames[i] > 0 ) ? array->frames[i] * frameTicks : 0;
+
+		if ( unwrapDays && i > 0 )
+		{
+			if ( ticks + dayTicks / 2 < prev )
+			{
+				day++;
+			}
+			else if ( ticks > prev + dayTicks / 2 )
+			{
+				day--;
+			}
+		}
+
+		prev = ticks;
+
+		int64_t key = day * dayTicks + ticks;
+
+		if ( i == 0 || key < min )
+		{
+			min = key;
+		}
+
+		keys[i] = key;
+	}
+
+
+	/* a list going back across midnight starts the day before its first value */
+
+	if ( min < 0 )
+	{
+		for ( i = 0; i < array->count; i++ )
+		{
+			keys[i] -= min;
+		}
+	}
+}
+
+
+
+
+/*
+ *	One pass sorts on byte shift / 8 of the keys. The keys are cut into one
+ *	slice per thread : each thread counts its slice, then scatters it to the
+ *	offsets of its own buckets, which follow those of the slices before it.
+ *	Slices keep their order inside each bucket, so the sort is stable.
+ */
+
+struct radix_job
+{
+	const uint64_t *keys;
+	const uint32_t *rows;
+
+	uint64_t       *keysOut;
+	uint32_t       *rowsOut;
+
+	size_t          begin;
+	size_t          end;
+
+	unsigned int    shift;
+
+	size_t          counts[256];  // bucket sizes, then offsets
+
+};
+
+
+static void * radixCount( void *arg )
+{
+	struct radix_job *job = arg;
+
+	memset( job->counts, 0, sizeof(job->counts) );
+
+	size_t i = job->begin;
+
+	for ( ; i < job->end; i++ )
+	{
+		job->counts[ ( job->keys[i] >> job->shift ) & 0xff ]++;
+	}
+
+	return NULL;
+}
+
+
+static void * radixScatter( void *arg )
+{
+	struct radix_job *job = arg;
+
+	size_t i = job->begin;
+
+	if ( job->rows != NULL )
+	{
+		for ( ; i < job->end; i++ )
+		{
+			size_t at = job->counts[ ( job->keys[i] >> job->shift ) & 0xff ]++;
+
+			job->keysOut[at] = job->keys[i];
+			job->rowsOut[at] = job->rows[i];
+		}
+	}
+	else
+	{
+		for ( ; i < job->end; i++ )
+		{
+			job->keysOut[ job->counts[ ( job->keys[i] >> job->shift ) & 0xff ]++ ] = job->keys[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+static void runJobs( struct radix_job *jobs, unsigned int n, void *(*fn)( void * ) )
+{
+	pthread_t threads[RADIX_MAX_THREADS];
+
+	unsigned int started = 0;
+
+	unsigned int i = 1;
+
+	for ( ; i < n; i++ )
+	{
+		if ( pthread_create( &threads[i], NULL, fn, &jobs[i] ) != 0 )
+		{
+			break;
+		}
+
+		started = i;
+	}
+
+	/* jobs the pool couldn't start run here */
+
+	fn( &jobs[0] );
+
+	for ( ; i < n; i++ )
+	{
+		fn( &jobs[i] );
+	}
+
+	for ( i = 1; i <= started; i++ )
+	{
+		pthread_join( threads[i], NULL );
+	}
+}
+
+
+
+
+int tc_radix_sort( uint64_t *keys, uint32_t *rows, size_t count, unsigned int threads )
+{
+	if ( count < 2 )
+	{
+		return 0;
+	}
+
+
+	/*
+	 *	A byte every key shares doesn't need a pass : keys are time in ticks,
+	 *	so the top three bytes are nearly always zero.
+	 */
+
+	uint64_t orBits = 0, andBits = ~(uint64_t)0;
+
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		orBits  |= keys[i];
+		andBits &= keys[i];
+	}
+
+	uint64_t varying = orBits ^ andBits;
+
+	if ( varying == 0 )
+	{
+		return 0;
+	}
+
+
+	uint64_t *keysTmp = malloc( count * sizeof(uint64_t) );
+	uint32_t *rowsTmp = ( rows != NULL ) ? malloc( count * sizeof(uint32_t) ) : NULL;
+
+	struct radix_job *jobs = calloc( RADIX_MAX_THREADS, sizeof(struct radix_job) );
+
+	if ( keysTmp == NULL || ( rows != NULL && rowsTmp == NULL ) || jobs == NULL )
+	{
+		free( keysTmp );
+		free( rowsTmp );
+		free( jobs );
+		return -1;
+	}
+
+	if ( threads > RADIX_MAX_THREADS )
+	{
+		threads = RADIX_MAX_THREADS;
+	}
+
+	if ( threads > count / RADIX_MIN_PER_THREAD )
+	{
+		threads = count / RADIX_MIN_PER_THREAD;
+	}
+
+	if ( threads < 1 )
+	{
+		threads = 1;
+	}
+
+
+	uint64_t *srcKeys = keys,    *dstKeys = keysTmp;
+	uint32_t *srcRows = rows,    *dstRows = rowsTmp;
+
+	unsigned int shift = 0;
+
+	for ( ; shift < 64; shift += 8 )
+	{
+		if ( ( ( varying >> shift ) & 0xff ) == 0 )
+		{
+			continue;
+		}
+
+		unsigned int t = 0;
+
+		for ( ; t < threads; t++ )
+		{
+			jobs[t].keys    = srcKeys;
+			jobs[t].rows    = srcRows;
+			jobs[t].keysOut = dstKeys;
+			jobs[t].rowsOut = dstRows;
+			jobs[t].begin   = count *  t      / threads;
+			jobs[t].end     = count * (t + 1) / threads;
+			jobs[t].shift   = shift;
+		}
+
+		runJobs( jobs, threads, radixCount );
+
+		size_t offset = 0;
+
+		unsigned int b = 0;
+
+		for ( ; b < 256; b++ )
+		{
+			for ( t = 0; t < threads; t++ )
+			{
+				size_t n = jobs[t].counts[b];
+
+				jobs[t].counts[b] = offset;
+
+				offset += n;
+			}
+		}
+
+		runJobs( jobs, threads, radixScatter );
+
+		uint64_t *k = srcKeys; srcKeys = dstKeys; dstKeys = k;
+		uint32_t *r = srcRows; srcRows = dstRows; dstRows = r;
+	}
+
+	if ( srcKeys != keys )
+	{
+		memcpy( keys, srcKeys, count * sizeof(uint64_t) );
+
+		if ( rows != NULL )
+		{
+			memcpy( rows, srcRows, count * sizeof(uint32_t) );
+		}
+	}
+
+	free( keysTmp );
+	free( rowsTmp );
+	free( jobs );
+
+	return 0;
+}
+
+
+
+
+size_t tc_radix_unique( uint64_t *keys, uint32_t *rows, size_t count )
+{
+	if ( count == 0 )
+	{
+		return 0;
+	}
+
+	size_t n = 1;
+	size_t i = 1;
+
+	for ( ; i < count; i++ )
+	{
+		if ( keys[i] != keys[n-1] )
+		{
+			keys[n] = keys[i];
+
+			if ( rows != NULL )
+			{
+				rows[n] = rows[i];
+			}
+
+			n++;
+		}
+	}
+
+	return n;
+}
+
+
+
+
+size_t tc_radix_ranges( const uint64_t *keys, const uint32_t *rows, size_t count, uint64_t step, struct tc_radix_range *ranges )
+{
+	size_t n = 0;
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		uint32_t row = ( rows != NULL ) ? rows[i] : 0;
+
+		if ( n > 0 && step > 0 && keys[i] == ranges[n-1].last + step )
+		{
+			ranges[n-1].last    = keys[i];
+			ranges[n-1].lastRow = row;
+			ranges[n-1].count++;
+			continue;
+		}
+
+		ranges[n].first    = keys[i];
+		ranges[n].last     = keys[i];
+		ranges[n].firstRow = row;
+		ranges[n].lastRow  = row;
+		ranges[n].count    = 1;
+
+		n++;
+	}
+
+	return n;
+}
@@ -0,0 +1,110 @@
+#ifndef __tcRadix_h__
+#define __tcRadix_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+#include "tcArray.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Sorting timecode lists.
+ *
+ *	Values are sorted on an integer key : the elapsed time since the first
+ *	midnight of the list, in ticks of 1/720000 s, a rate every supported
+ *	frame duration is a whole number of (30030 ticks at 23.976, 24024 at
+ *	29.97, 28800 at 25...). Keys of any format compare in real time, and a
+ *	drop frame list sorts in frame order, which its labels don't as strings.
+ */
+
+#define TC_RADIX_TICKS   720000   // key ticks per second
+
+
+/**
+ *	Duration of one frame of format, in key ticks. 0 for TC_FORMAT_UNK.
+ */
+
+uint64_t tc_radix_frame_ticks( enum TC_FORMAT format );
+
+
+/**
+ *	keys[i] is the key of value i of array. With unwrapDays, the array is
+ *	taken in recording order : a value more than half a day before the
+ *	previous one is on the next day (a list running across midnight), and
+ *	one more than half a day after it on the day before (keys are shifted
+ *	up when that goes before the first day). Negative frame numbers count
+ *	as 0.
+ */
+
+void tc_radix_keys( const struct tc_array *array, uint64_t *keys, uint8_t unwrapDays );
+
+
+/**
+ *	Stable LSD radix sort of count keys, moving rows[] along (rows can be
+ *	NULL). Byte passes every key agrees on are skipped, and each pass runs
+ *	on up to threads threads. Returns 0 on success, -1 when out of memory.
+ */
+
+int tc_radix_sort( uint64_t *keys, uint32_t *rows, size_t count, unsigned int threads );
+
+
+/**
+ *	Removes the repeated keys of a sorted list in place, keeping the first
+ *	row of each (its first occurrence, since the sort is stable). Returns the
+ *	number of keys left.
+ */
+
+size_t tc_radix_unique( uint64_t *keys, uint32_t *rows, size_t count );
+
+
+/**
+ *	Groups unique sorted keys into ranges of keys step apart (one frame,
+ *	tc_radix_frame_ticks()), eg. 01:00:00:00 - 01:00:09:24. ranges must hold
+ *	count entries. Returns the number of ranges.
+ */
+
+struct tc_radix_range
+{
+	uint64_t    first;       // first and last key
+	uint64_t    last;
+
+	uint32_t    firstRow;    // rows of first and last
+	uint32_t    lastRow;
+
+	size_t      count;       // number of keys
+
+};
+
+size_t tc_radix_ranges( const uint64_t *keys, const uint32_t *rows, size_t count, uint64_t step, struct tc_radix_range *ranges );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcRadix_h__
@@ -0,0 +1,97 @@
+#ifndef __tcRational_h__
+#define __tcRational_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+
+
+/*
+ *	Exact integer helpers shared by the LibTC modules that convert between
+ *	rates. Intermediate products need up to 128 bits (a 64 bit sample count
+ *	times a 32 bit rational), so this relies on __int128 where the compiler
+ *	has it, and on a shift-subtract division everywhere else (32 bit targets).
+ */
+
+static inline uint64_t tc_muldiv( uint64_t a, uint64_t b, uint64_t c, uint64_t bias )
+{
+	/* ( a * b + bias ) / c, with bias < c */
+
+#ifdef __SIZEOF_INT128__
+
+	return (uint64_t)( ( (unsigned __int128)a * b + bias ) / c );
+
+#else
+
+	uint64_t aH = a >> 32, aL = a & 0xffffffff;
+	uint64_t bH = b >> 32, bL = b & 0xffffffff;
+
+	uint64_t ll  = aL * bL;
+	uint64_t mid = ( ll >> 32 ) + ( aH * bL & 0xffffffff ) + ( aL * bH & 0xffffffff );
+
+	uint64_t lo  = ( ll & 0xffffffff ) | ( mid << 32 );
+	uint64_t hi  = aH * bH + ( aH * bL >> 32 ) + ( aL * bH >> 32 ) + ( mid >> 32 );
+
+	lo += bias;
+	hi += ( lo < bias );
+
+	uint64_t q = 0;
+	uint64_t r = hi % c;
+
+	int i = 63;
+
+	for ( ; i >= 0; i-- )
+	{
+		uint64_t carry = r >> 63;
+
+		r = ( r << 1 ) | ( ( lo >> i ) & 1 );
+
+		q <<= 1;
+
+		if ( carry || r >= c )
+		{
+			r -= c;
+			q |= 1;
+		}
+	}
+
+	return q;
+
+#endif
+}
+
+
+static inline uint64_t tc_gcd( uint64_t a, uint64_t b )
+{
+	while ( b != 0 )
+	{
+		uint64_t t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+
+
+#endif // ! __tcRational_h__
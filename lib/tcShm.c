@@ -0,0 +1,412 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "tcShm.h"
+#include "tcRational.h"
+
+
+
+#define SHM_MAGIC     0x4d534354  // "TCSM"
+#define SHM_VERSION   1
+
+/*
+ *	A read seeing an odd sequence this many times in a row gives up : the
+ *	publisher was descheduled, or died, in the middle of a publish.
+ */
+
+#define SHM_SPINS     (64 * 1024)
+
+
+/*
+ *	The whole segment is one cache line. Fields are accessed with atomic
+ *	loads and stores, so that the seqlock copy isn't a data race.
+ */
+
+struct tc_shm_segment
+{
+	uint32_t    magic;
+	uint32_t    version;
+
+	uint32_t    sequence;      // odd while the publisher writes
+
+	int32_t     frameNumber;
+	uint32_t    format;
+	uint32_t    phase;
+	uint64_t    timestamp;
+	uint64_t    count;
+
+} __attribute__(( aligned(64) ));
+
+
+
+
+#ifndef _WIN32
+
+/* shm_open() wants "/name" */
+
+static int segmentName( char *out, size_t size, const char *name )
+{
+	if ( name == NULL )
+	{
+		name = TC_SHM_NAME;
+	}
+
+	int len = snprintf( out, size, "%s%s", ( name[0] == '/' ) ? "" : "/", name );
+
+	if ( len <= 1 || (size_t)len >= size || strchr( out + 1, '/' ) != NULL )
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+#endif
+
+
+
+
+int tc_shm_publisher_open( struct tc_shm *shm, const char *name )
+{
+	memset( shm, 0x00, sizeof(struct tc_shm) );
+
+#ifndef _WIN32
+
+	char path[256];
+
+	if ( segmentName( path, sizeof(path), name ) < 0 )
+	{
+		return -1;
+	}
+
+	int fd = shm_open( path, O_RDWR | O_CREAT, 0644 );
+
+	if ( fd < 0 )
+	{
+		return -1;
+	}
+
+	if ( ftruncate( fd, sizeof(struct tc_shm_segment) ) < 0 )
+	{
+		close( fd );
+		return -1;
+	}
+
+	void *data = mmap( NULL, sizeof(struct tc_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+	close( fd );
+
+	if ( data == MAP_FAILED )
+	{
+		return -1;
+	}
+
+	struct tc_shm_segment *segment = data;
+
+	/* a previous publisher may have died in the middle of a publish */
+
+	uint32_t sequence = __atomic_load_n( &segment->sequence, __ATOMIC_RELAXED );
+
+	if ( sequence & 1 )
+	{
+		__atomic_store_n( &segment->sequence, sequence + 1, __ATOMIC_RELEASE );
+	}
+
+	__atomic_store_n( &segment->version, SHM_VERSION, __ATOMIC_RELAXED );
+	__atomic_store_n( &segment->magic,   SHM_MAGIC,   __ATOMIC_RELEASE );
+
+	shm->segment   = segment;
+	shm->publisher = 1;
+
+	return 0;
+
+#else
+
+	(void)name;
+
+	errno = ENOSYS;
+	return -1;
+
+#endif
+}
+
+
+
+
+int tc_shm_subscriber_open( struct tc_shm *shm, const char *name )
+{
+	memset( shm, 0x00, sizeof(struct tc_shm) );
+
+#ifndef _WIN32
+
+	char path[256];
+
+	if ( segmentName( path, sizeof(path), name ) < 0 )
+	{
+		return -1;
+	}
+
+	int fd = shm_open( path, O_RDONLY, 0 );
+
+	if ( fd < 0 )
+	{
+		return -1;
+	}
+
+	struct stat st;
+
+	if ( fstat( fd, &st ) < 0 )
+	{
+		close( fd );
+		return -1;
+	}
+
+	/* the publisher is creating it */
+
+	if ( (size_t)st.st_size < sizeof(struct tc_shm_segment) )
+	{
+		close( fd );
+		errno = EAGAIN;
+		return -1;
+	}
+
+	void *data = mmap( NULL, sizeof(struct tc_shm_segment), PROT_READ, MAP_SHARED, fd, 0 );
+
+	close( fd );
+
+	if ( data == MAP_FAILED )
+	{
+		return -1;
+	}
+
+	shm->segment = data;
+
+	return 0;
+
+#else
+
+	(void)name;
+
+	errno = ENOSYS;
+	return -1;
+
+#endif
+}
+
+
+
+
+void tc_shm_close( struct tc_shm *shm )
+{
+#ifndef _WIN32
+	if ( shm->segment != NULL )
+	{
+		munmap( shm->segment, sizeof(struct tc_shm_segment) );
+	}
+#endif
+
+	memset( shm, 0x00, sizeof(struct tc_shm) );
+}
+
+
+
+
+int tc_shm_unlink( const char *name )
+{
+#ifndef _WIN32
+
+	char path[256];
+
+	if ( segmentName( path, sizeof(path), name ) < 0 )
+	{
+		return -1;
+	}
+
+	return shm_unlink( path );
+
+#else
+
+	(void)name;
+
+	errno = ENOSYS;
+	return -1;
+
+#endif
+}
+
+
+
+
+void tc_shm_publish( struct tc_shm *shm, int32_t frameNumber, enum TC_FORMAT format, uint32_t phase, uint64_t timestamp )
+{
+	struct tc_shm_segment *segment = shm->segment;
+
+	if ( segment == NULL || !shm->publisher )
+	{
+		return;
+	}
+
+	uint32_t sequence = __atomic_load_n( &segment->sequence, __ATOMIC_RELAXED );
+	uint64_t count    = __atomic_load_n( &segment->count,    __ATOMIC_RELAXED );
+
+	/* odd sequence before any field changes ... */
+
+	__atomic_store_n( &segment->sequence, sequence + 1, __ATOMIC_RELAXED );
+	__atomic_thread_fence( __ATOMIC_RELEASE );
+
+	__atomic_store_n( &segment->frameNumber, frameNumber, __ATOMIC_RELAXED );
+	__atomic_store_n( &segment->format,      format,      __ATOMIC_RELAXED );
+	__atomic_store_n( &segment->phase,       phase,       __ATOMIC_RELAXED );
+	__atomic_store_n( &segment->timestamp,   timestamp,   __ATOMIC_RELAXED );
+	__atomic_store_n( &segment->count,       count + 1,   __ATOMIC_RELAXED );
+
+	/* ... and even again after they all did */
+
+	__atomic_store_n( &segment->sequence, sequence + 2, __ATOMIC_RELEASE );
+}
+
+
+
+
+void tc_shm_publish_tc( struct tc_shm *shm, const struct timecode *tc, uint32_t phase )
+{
+	tc_shm_publish( shm, tc->frameNumber, tc->format, phase, tc_shm_now() );
+}
+
+
+
+
+int tc_shm_read( const struct tc_shm *shm, struct tc_shm_snapshot *snap )
+{
+	const struct tc_shm_segment *segment = shm->segment;
+
+	if ( segment == NULL || __atomic_load_n( &segment->magic, __ATOMIC_ACQUIRE ) != SHM_MAGIC )
+	{
+		return -1;
+	}
+
+	unsigned int spins = 0;
+
+	while ( spins < SHM_SPINS )
+	{
+		uint32_t before = __atomic_load_n( &segment->sequence, __ATOMIC_ACQUIRE );
+
+		if ( before & 1 )
+		{
+			spins++;
+			continue;
+		}
+
+		snap->frameNumber = __atomic_load_n( &segment->frameNumber, __ATOMIC_RELAXED );
+		snap->format      = __atomic_load_n( &segment->format,      __ATOMIC_RELAXED );
+		snap->phase       = __atomic_load_n( &segment->phase,       __ATOMIC_RELAXED );
+		snap->timestamp   = __atomic_load_n( &segment->timestamp,   __ATOMIC_RELAXED );
+		snap->count       = __atomic_load_n( &segment->count,       __ATOMIC_RELAXED );
+
+		__atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+		if ( __atomic_load_n( &segment->sequence, __ATOMIC_RELAXED ) == before )
+		{
+			/* the format indexes the rate tables : the segment is anyone's to write */
+
+			if ( snap->format <= TC_FORMAT_UNK || snap->format >= TC_FORMAT_LEN )
+			{
+				return -1;
+			}
+
+			return ( snap->count > 0 ) ? 0 : -1;
+		}
+	}
+
+	return -1;
+}
+
+
+
+
+void tc_shm_get( const struct tc_shm_snapshot *snap, struct timecode *tc )
+{
+	tc_set_by_frames( tc, snap->frameNumber, snap->format );
+}
+
+
+
+
+int32_t tc_shm_extrapolate( const struct tc_shm_snapshot *snap, uint64_t now, uint32_t *phase )
+{
+	rational_t rate = tc_format_rate( snap->format );
+
+	uint64_t elapsed = ( now > snap->timestamp ) ? now - snap->timestamp : 0;
+
+	uint64_t ticks = snap->phase;
+
+	if ( rate.numerator > 0 && rate.denominator > 0 )
+	{
+		ticks += tc_muldiv( elapsed, (uint64_t)rate.numerator * TC_SHM_PHASE, (uint64_t)rate.denominator * 1000000000, 0 );
+	}
+
+	if ( phase != NULL )
+	{
+		*phase = ticks % TC_SHM_PHASE;
+	}
+
+	return snap->frameNumber + (int32_t)( ticks / TC_SHM_PHASE );
+}
+
+
+
+
+int tc_shm_stale( const struct tc_shm_snapshot *snap, uint64_t now, uint32_t frames )
+{
+	rational_t rate = tc_format_rate( snap->format );
+
+	if ( rate.numerator <= 0 || rate.denominator <= 0 )
+	{
+		return 1;
+	}
+
+	uint64_t elapsed = ( now > snap->timestamp ) ? now - snap->timestamp : 0;
+
+	return ( elapsed > tc_muldiv( frames, (uint64_t)rate.denominator * 1000000000, rate.numerator, 0 ) );
+}
+
+
+
+
+uint64_t tc_shm_now( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
@@ -0,0 +1,154 @@
+#ifndef __tcShm_h__
+#define __tcShm_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libTC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*
+ *	Shared-memory broadcast of the house timecode to the processes of one
+ *	machine : a publisher (the process decoding LTC, or the playout clock)
+ *	writes the current frame into a small POSIX shared-memory segment, any
+ *	number of subscribers read it.
+ *
+ *	The segment is a seqlock : the publisher makes the sequence odd, writes,
+ *	then makes it even again, and a reader retries if the sequence was odd or
+ *	changed while it copied. Readers never write to the segment, so they
+ *	don't slow down the publisher nor each other, and a read is a copy of one
+ *	cache line. It only retries when it overlaps a publish, which lasts a few
+ *	nanoseconds once per frame.
+ */
+
+#define TC_SHM_NAME      "/libtc"    // default segment name
+
+#define TC_SHM_PHASE     65536       // sub-frame phase unit, 1/65536 of a frame
+
+#define TC_SHM_STALE     5           // frames without a publish before a clock is considered stopped
+
+
+struct tc_shm_snapshot
+{
+	int32_t         frameNumber;
+
+	enum TC_FORMAT  format;
+
+	uint32_t        phase;         // time into the frame, in 1/TC_SHM_PHASE of a frame
+
+	uint64_t        timestamp;     // CLOCK_MONOTONIC ns when frameNumber + phase was current
+
+	uint64_t        count;         // number of publishes, 1 for the first
+
+};
+
+
+struct tc_shm_segment;
+
+struct tc_shm
+{
+	struct tc_shm_segment *segment;
+
+	uint8_t                publisher;
+
+};
+
+
+/**
+ *	Opens the segment name (TC_SHM_NAME if NULL), creating it for the
+ *	publisher. There should be one publisher per segment. Subscribers map it
+ *	read-only, and can open it before anything was published. Return 0 on
+ *	success, -1 on error (errno is set).
+ */
+
+int tc_shm_publisher_open( struct tc_shm *shm, const char *name );
+
+int tc_shm_subscriber_open( struct tc_shm *shm, const char *name );
+
+void tc_shm_close( struct tc_shm *shm );
+
+
+/**
+ *	Removes the segment name. Opened mappings stay valid.
+ */
+
+int tc_shm_unlink( const char *name );
+
+
+/**
+ *	Publishes a frame. timestamp is a CLOCK_MONOTONIC time in nanoseconds,
+ *	tc_shm_now() when the frame is being decoded live.
+ */
+
+void tc_shm_publish( struct tc_shm *shm, int32_t frameNumber, enum TC_FORMAT format, uint32_t phase, uint64_t timestamp );
+
+void tc_shm_publish_tc( struct tc_shm *shm, const struct timecode *tc, uint32_t phase );
+
+
+/**
+ *	Copies the last published frame into snap. Wait-free as long as the
+ *	publisher lives : returns -1 if nothing was published yet, if the
+ *	publisher stopped in the middle of a publish, or if the format isn't a
+ *	known one.
+ */
+
+int tc_shm_read( const struct tc_shm *shm, struct tc_shm_snapshot *snap );
+
+
+/**
+ *	Sets tc to the frame of snap, as tc_set_by_frames().
+ */
+
+void tc_shm_get( const struct tc_shm_snapshot *snap, struct timecode *tc );
+
+
+/**
+ *	Frame number at the CLOCK_MONOTONIC time now, assuming the clock kept
+ *	running at the rate of its format since snap was published. phase (can
+ *	be NULL) is set to the time into that frame.
+ */
+
+int32_t tc_shm_extrapolate( const struct tc_shm_snapshot *snap, uint64_t now, uint32_t *phase );
+
+
+/**
+ *	1 if nothing was published during the last frames frames (at the rate
+ *	of snap) before now : the publisher stopped or died, and extrapolating
+ *	would make a timecode up. 0 otherwise.
+ */
+
+int tc_shm_stale( const struct tc_shm_snapshot *snap, uint64_t now, uint32_t frames );
+
+
+uint64_t tc_shm_now( void );  // CLOCK_MONOTONIC, in ns
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __tcShm_h__
@@ -0,0 +1,191 @@
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tcStats.h"
+
+#ifdef TC_STATS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+
+
+static const char *TC_STATS_PROBE_STR[] = {
+	"tc_set_by_string",
+	"tc_set_by_frames",
+	"tc_set_by_hmsf",
+	"tc_set_by_unitValue",
+	"tc_convert",
+	"tc_convert_frames",
+	"tc_add",
+	"tc_sub",
+	"framesToHmsf",
+	"hmsfToFrames",
+	"hmsfToString"
+};
+
+
+
+
+#ifdef TC_STATS
+
+__thread struct tc_stats tc_stats_tls;
+
+
+
+
+uint64_t tc_stats_ticks( void )
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#elif defined(__aarch64__)
+	uint64_t ticks;
+	__asm__ volatile( "mrs %0, cntvct_el0" : "=r"(ticks) );
+	return ticks;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#endif // TC_STATS
+
+
+
+
+const struct tc_stats * tc_stats_get( void )
+{
+#ifdef TC_STATS
+	return &tc_stats_tls;
+#else
+	return NULL;
+#endif
+}
+
+
+
+
+void tc_stats_reset( void )
+{
+#ifdef TC_STATS
+	memset( &tc_stats_tls, 0x00, sizeof(struct tc_stats) );
+#endif
+}
+
+
+
+
+void tc_stats_merge( struct tc_stats *dst, const struct tc_stats *src )
+{
+	if ( dst == NULL || src == NULL )
+	{
+		return;
+	}
+
+	unsigned int i = 0;
+
+	for ( ; i < TC_STATS_PROBE_LEN; i++ )
+	{
+		dst->probe[i].calls += src->probe[i].calls;
+		dst->probe[i].ticks += src->probe[i].ticks;
+
+		unsigned int b = 0;
+
+		for ( ; b < TC_STATS_BUCKETS; b++ )
+		{
+			dst->probe[i].histogram[b] += src->probe[i].histogram[b];
+		}
+	}
+}
+
+
+
+
+const char * tc_stats_probe_name( enum TC_STATS_PROBE probe )
+{
+	if ( probe >= TC_STATS_PROBE_LEN )
+	{
+		return "unknown";
+	}
+
+	return TC_STATS_PROBE_STR[probe];
+}
+
+
+
+
+void tc_stats_dump( FILE *fp, const struct tc_stats *stats )
+{
+	if ( stats == NULL )
+	{
+		fprintf( fp, "libTC stats not available (build with make STATS=1).\n" );
+		return;
+	}
+
+	fprintf( fp, "%-20s %12s %14s %10s   %s\n", "entry point", "calls", "ticks", "avg", "p50 / p99 (ticks, upper bound)" );
+
+	unsigned int i = 0;
+
+	for ( ; i < TC_STATS_PROBE_LEN; i++ )
+	{
+		const struct tc_stats_probe *p = &stats->probe[i];
+
+		if ( p->calls == 0 )
+		{
+			continue;
+		}
+
+		uint64_t p50 = 0;
+		uint64_t p99 = 0;
+		uint64_t sum = 0;
+
+		unsigned int b = 0;
+
+		for ( ; b < TC_STATS_BUCKETS; b++ )
+		{
+			sum += p->histogram[b];
+
+			if ( p50 == 0 && sum * 2 >= p->calls )
+			{
+				p50 = 1ULL << b;
+			}
+
+			if ( p99 == 0 && sum * 100 >= p->calls * 99 )
+			{
+				p99 = 1ULL << b;
+			}
+		}
+
+		fprintf( fp, "%-20s %12llu %14llu %10.1f   %llu / %llu\n",
+		         TC_STATS_PROBE_STR[i],
+		         (unsigned long long)p->calls,
+		         (unsigned long long)p->ticks,
+		         (double)p->ticks / p->calls,
+		         (unsigned long long)p50,
+		         (unsigned long long)p99 );
+	}
+}
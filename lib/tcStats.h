@@ -0,0 +1,162 @@
+#ifndef __tcStats_h__
+#define __tcStats_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+
+/*
+ *	Hot-path instrumentation.
+ *
+ *	Only built when LibTC is compiled with -DTC_STATS (make STATS=1). Each
+ *	instrumented entry point then counts its calls and records its latency,
+ *	in cpu ticks, into a log2 histogram. Counters live in thread-local
+ *	storage, so recording never takes a lock : a thread only ever reads its
+ *	own figures through tc_stats_get().
+ *
+ *	When <sys/sdt.h> is available, every instrumented call also fires the
+ *	USDT probes libtc:entry( probe ) and libtc:return( probe, ticks ).
+ *
+ *	Without TC_STATS, the macros below expand to nothing.
+ */
+
+enum TC_STATS_PROBE {
+
+	TC_STATS_SET_BY_STRING = 0,
+	TC_STATS_SET_BY_FRAMES,
+	TC_STATS_SET_BY_HMSF,
+	TC_STATS_SET_BY_UNITVALUE,
+	TC_STATS_CONVERT,
+	TC_STATS_CONVERT_FRAMES,
+	TC_STATS_ADD,
+	TC_STATS_SUB,
+	TC_STATS_FRAMES_TO_HMSF,
+	TC_STATS_HMSF_TO_FRAMES,
+	TC_STATS_HMSF_TO_STRING,
+
+	TC_STATS_PROBE_LEN
+};
+
+
+
+#define TC_STATS_BUCKETS 32 // bucket n counts calls that took [2^(n-1), 2^n) ticks
+
+
+struct tc_stats_probe
+{
+	uint64_t   calls;
+
+	uint64_t   ticks;
+
+	uint64_t   histogram[TC_STATS_BUCKETS];
+
+};
+
+
+struct tc_stats
+{
+	struct tc_stats_probe probe[TC_STATS_PROBE_LEN];
+
+};
+
+
+
+#ifdef TC_STATS
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TC_USDT_ENTRY( probe )           DTRACE_PROBE1( libtc, entry, probe )
+#define TC_USDT_RETURN( probe, ticks )   DTRACE_PROBE2( libtc, return, probe, ticks )
+#endif
+#endif
+
+#ifndef TC_USDT_ENTRY
+#define TC_USDT_ENTRY( probe )
+#define TC_USDT_RETURN( probe, ticks )
+#endif
+
+
+extern __thread struct tc_stats tc_stats_tls;
+
+
+uint64_t tc_stats_ticks( void );
+
+
+static inline void tc_stats_record( enum TC_STATS_PROBE probe, uint64_t ticks )
+{
+	struct tc_stats_probe *p = &tc_stats_tls.probe[probe];
+
+	unsigned int bucket = ( ticks == 0 ) ? 0 : ( 64 - __builtin_clzll( ticks ) );
+
+	if ( bucket >= TC_STATS_BUCKETS )
+	{
+		bucket = TC_STATS_BUCKETS - 1;
+	}
+
+	p->calls++;
+	p->ticks += ticks;
+	p->histogram[bucket]++;
+
+	TC_USDT_RETURN( probe, ticks );
+}
+
+
+#define TC_STATS_BEGIN( probe ) \
+	uint64_t __tc_stats_t0 = tc_stats_ticks(); \
+	TC_USDT_ENTRY( probe )
+
+#define TC_STATS_END( probe ) \
+	tc_stats_record( probe, tc_stats_ticks() - __tc_stats_t0 )
+
+#else
+
+#define TC_STATS_BEGIN( probe )
+#define TC_STATS_END( probe )
+
+#endif // TC_STATS
+
+
+
+/**
+ *	Returns the counters of the calling thread, or NULL if LibTC was built
+ *	without TC_STATS.
+ */
+
+const struct tc_stats * tc_stats_get( void );
+
+void tc_stats_reset( void );
+
+/**
+ *	Adds the counters of src to dst, typically to fold the figures of worker
+ *	threads into the ones of the thread that spawned them.
+ */
+
+void tc_stats_merge( struct tc_stats *dst, const struct tc_stats *src );
+
+const char * tc_stats_probe_name( enum TC_STATS_PROBE probe );
+
+void tc_stats_dump( FILE *fp, const struct tc_stats *stats );
+
+
+#endif // ! __tcStats_h__
@@ -0,0 +1,146 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <signal.h>
+#include <time.h>
+
+#include "tcBroadcast.h"
+#include "lib/tcShm.h"
+#include "lib/tcRational.h"
+
+
+
+
+static volatile sig_atomic_t stopping = 0;
+
+
+static void onStop( int sig )
+{
+	(void)sig;
+
+	stopping = 1;
+}
+
+
+static void sleepUntil( uint64_t deadline )
+{
+	uint64_t now = tc_shm_now();
+
+	if ( deadline > now )
+	{
+		struct timespec ts;
+
+		ts.tv_sec  = ( deadline - now ) / 1000000000;
+		ts.tv_nsec = ( deadline - now ) % 1000000000;
+
+		while ( nanosleep( &ts, &ts ) != 0 && !stopping )
+		{
+			/* interrupted, sleep the rest */
+		}
+	}
+}
+
+
+
+
+int broadcast_publish( const char *name, struct timecode *tc )
+{
+	struct tc_shm shm;
+
+	if ( tc_shm_publisher_open( &shm, name ) < 0 )
+	{
+		return -1;
+	}
+
+	/* the segment outlives the process : a stop request removes it */
+
+	stopping = 0;
+
+	signal( SIGINT,  onStop );
+	signal( SIGTERM, onStop );
+
+	rational_t rate = tc_format_rate( tc->format );
+
+	uint64_t start = tc_shm_now();
+	uint64_t frame = 0;
+
+	for ( ; !stopping; frame++ )
+	{
+		/* frame n starts at n / rate, rounded down to the ns */
+
+		uint64_t deadline = start + tc_muldiv( frame, (uint64_t)rate.denominator * 1000000000, rate.numerator, 0 );
+
+		sleepUntil( deadline );
+
+		if ( stopping )
+		{
+			break;
+		}
+
+		tc_shm_publish( &shm, tc->frameNumber, tc->format, 0, deadline );
+
+		tc_next( tc );
+	}
+
+	signal( SIGINT,  SIG_DFL );
+	signal( SIGTERM, SIG_DFL );
+
+	tc_shm_close( &shm );
+	tc_shm_unlink( name );
+
+	return 0;
+}
+
+
+
+
+int broadcast_get( const char *name, struct timecode *tc )
+{
+	struct tc_shm shm;
+
+	struct tc_shm_snapshot snap;
+
+	if ( tc_shm_subscriber_open( &shm, name ) < 0 )
+	{
+		return -1;
+	}
+
+	int rc = tc_shm_read( &shm, &snap );
+
+	tc_shm_close( &shm );
+
+	if ( rc < 0 )
+	{
+		return -1;
+	}
+
+	uint64_t now = tc_shm_now();
+
+	if ( tc_shm_stale( &snap, now, TC_SHM_STALE ) )
+	{
+		tc_shm_get( &snap, tc );
+		return 1;
+	}
+
+	tc_set_by_frames( tc, tc_shm_extrapolate( &snap, now, NULL ), snap.format );
+
+	return 0;
+}
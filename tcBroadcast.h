@@ -0,0 +1,51 @@
+#ifndef __tcBroadcast_h__
+#define __tcBroadcast_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tcCoca.h"
+
+
+
+/**
+ *	House clock : publishes tc to the shared-memory segment name (see
+ *	lib/tcShm.h) and steps it at the real rate of its format, every frame on
+ *	an absolute deadline of CLOCK_MONOTONIC so that no error accumulates.
+ *	Runs until SIGINT or SIGTERM, then removes the segment and returns 0.
+ *	Returns -1 if the segment can't be opened.
+ */
+
+int broadcast_publish( const char *name, struct timecode *tc );
+
+
+/**
+ *	Sets tc to the timecode published in name, as of now, keeping its
+ *	noRollover. Returns 0 on success, -1 if there is no segment or nothing
+ *	was published, 1 if the publisher stopped (no frame for TC_SHM_STALE
+ *	frames) : tc is then its last published frame.
+ */
+
+int broadcast_get( const char *name, struct timecode *tc );
+
+
+#endif // ! __tcBroadcast_h__
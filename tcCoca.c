@@ -25,11 +25,27 @@
 #include <ctype.h>
 #include <errno.h>
 
-#include "lib/libTC.h"
-
+#include <unistd.h>
 
-
-static char *TC_FORMAT_STR[] = {
+#include "lib/libTC.h"
+#include "lib/tcStats.h"
+#include "lib/tcBurn.h"
+#include "lib/tcPull.h"
+#include "tcCoca.h"
+#include "tcCsv.h"
+#include "tcPcap.h"
+#include "tcTimeline.h"
+#include "tcExpr.h"
+#include "tcGaps.h"
+#include "tcSort.h"
+#include "tcBroadcast.h"
+#include "tcLogs.h"
+#include "tcScan.h"
+#include "tcDrifts.h"
+
+
+
+char *TC_FORMAT_STR[] = {
 	"unknown",
 	"23.976",
 	"24",
@@ -60,6 +76,19 @@ void show_help()
     \n\
     Usage :\n\
         tcCoca -F <format> <tc_value> [options]\n\
+        tcCoca -F <format> <tc_value> -e <expression> [options]\n\
+        tcCoca -F <format> --csv <file> --columns <list> [options]\n\
+        tcCoca -F <format> --pcap <file> [options]\n\
+        tcCoca -F <format> --fcpxml <file> [options]\n\
+        tcCoca -F <format> --gaps <file> [options]\n\
+        tcCoca -F <format> --sort <file> [options]\n\
+        tcCoca -F <format> --drift <file> -R <rate> [options]\n\
+        tcCoca -F <format> --media <path> [options]\n\
+        tcCoca -F <format> --log <file> --log-pack <file>\n\
+        tcCoca -F <format> --log <file> [<tc_value>]\n\
+        tcCoca -F <format> <start_tc> --publish <name>\n\
+        tcCoca -F <format> --subscribe <name> [options]\n\
+        tcCoca -F <format> <start_tc> --burn <file> --burn-size <WxH> [options]\n\
     \n\
         tc value can be either hh:mm:ss:ff timecode, frame number or any value\n\
         associated with an edit rate.\n\
@@ -71,22 +100,130 @@ void show_help()
         -F, --format            <format>  set the TC value format to <format>\n\
         -R, --rate              <rate>    specify the edit rate of the input TC\n\
                                           value - default is frame rate\n\
+            --pull              <speed>   the edit rate clock is pulled : up,\n\
+                                          down, 24to25, 25to24 or a ratio\n\
 		\n\
         -c, --convert-to        <format>  convert TC value to the given <format>\n\
             --convert-frames-to <format>  convert TC frame number to the given <format>\n\
         -a, --add               <value>   add <value> to input TC value\n\
         -s, --sub               <value>   subtract <value> from input TC value\n\
+        -e, --expr              <expr>    apply a whole expression instead, eg.\n\
+                                          \"(TC + 00:59:58:00) to 25 - 120\"\n\
+                                          + / - timecode, frames (120 or 120f),\n\
+                                          unit value (48000@48000) or (sums)\n\
+                                          to <format> : convert as -c\n\
+                                          as <format> : convert as --convert-frames-to\n\
+    \n\
+    Delimited files :\n\
+            --csv               <file>    rewrite TC columns of <file> (- for stdin)\n\
+                                          to stdout, applying the above operation\n\
+            --tsv               <file>    same as --csv with tab delimiter\n\
+            --columns           <list>    comma separated TC columns, 1-based\n\
+            --delimiter         <char>    field delimiter - default is ','\n\
+            --header                      pass the first line through untouched\n\
+            --threads           <n>       number of worker threads - default is\n\
+                                          one per cpu\n\
+    \n\
+    Editorial timelines :\n\
+            --fcpxml            <file>    rewrite the rational times of an FCPXML\n\
+                                          document to stdout, applying the above\n\
+                                          operation (add / sub move positions only)\n\
+            --otio              <file>    same with the RationalTime of an OTIO file\n\
+            --report                      list the times and their TC instead\n\
+    \n\
+    Timecode streams :\n\
+            --gaps              <file>    report the jumps, repeats, rollovers and\n\
+                                          drop frame violations of a list of TC\n\
+                                          (one hh:mm:ss:ff or frame number per\n\
+                                          line, - for stdin)\n\
+            --gaps-step         <n>       expected frames between lines - default\n\
+                                          is 1\n\
+            --runs                        also list the continuous runs\n\
+            --sort              <file>    sort the lines of <file> (- for stdin)\n\
+                                          on their TC, in frame order across\n\
+                                          midnight (lines in recording order,\n\
+                                          -n otherwise) - --columns (one),\n\
+                                          --delimiter, --header and --threads\n\
+                                          apply\n\
+            --unique                      keep the first line of each TC only\n\
+            --ranges                      list runs of consecutive TC instead, as\n\
+                                          first, last and count\n\
+            --drift             <file>    estimate the drift of a unit clock (-R)\n\
+                                          against TC from lines of unit value and\n\
+                                          TC (- for stdin), eg. the sample of each\n\
+                                          decoded LTC frame\n\
+            --drift-ppm         <n>       drift flagged above <n> ppm - default\n\
+                                          is 1\n\
+    \n\
+    Media files :\n\
+            --media             <path>    print the start TC of the MXF, QuickTime\n\
+                                          and BWF files of <path> (a file or a\n\
+                                          directory tree), applying the above\n\
+                                          operation - <format> is the BWF rate,\n\
+                                          --threads default is 4 per cpu\n\
+    \n\
+    Timecode logs :\n\
+            --log               <file>    print the indexes of tc value in the\n\
+                                          binary TC log <file>, or the whole log\n\
+                                          without a tc value\n\
+            --log-pack          <file>    append the TC list of <file> to the log\n\
+                                          instead (one hh:mm:ss:ff or frame number\n\
+                                          per line, - for stdin)\n\
+    \n\
+    House clock :\n\
+            --publish           <name>    run a clock from tc value at the real\n\
+                                          frame rate, publishing each frame to the\n\
+                                          shared-memory segment <name>\n\
+            --subscribe         <name>    print the current TC of <name>, applying\n\
+                                          the above operation\n\
+    \n\
+    ST 2110 captures :\n\
+            --pcap              <file>    map the RTP timestamps of a pcap / pcapng\n\
+                                          capture to timecode, and check ANC\n\
+                                          ATC_LTC / ATC_VITC against them\n\
+            --audio-pt          <list>    payload types of 48 kHz audio streams\n\
+                                          (others are 90 kHz)\n\
+            --anc-pt            <list>    payload types of ST 2110-40 ANC streams\n\
+            --tai-offset        <sec>     TAI - UTC offset - default is 37\n\
+    \n\
+    Burn-in :\n\
+            --burn              <file>    burn TC into each raw frame of <file>\n\
+                                          (- for stdin), counting from tc value\n\
+            --burn-out          <file>    output frames - default is stdout\n\
+            --burn-size         <WxH>     frame size in pixels\n\
+            --burn-pixfmt       <fmt>     uyvy, v210, yuv420p or rgba - default\n\
+                                          is uyvy\n\
+            --burn-pos          <x,y>     label position - default is 1/32 of\n\
+                                          the frame size\n\
+            --burn-scale        <n>       font pixel size - default is height / 270\n\
     \n\
     Output :\n\
         -h, --hmsf                        output TC as a time value hh:mm:ss:ff only\n\
         -f, --frames                      output TC as a frame number only\n\
+            --unit-value        <rate>    output the position of TC in <rate> units\n\
+                                          only (eg. 48000), rounded to nearest\n\
         -n, --no-rollover                 don't rollover if TC is bigger than day limit\n\
+            --stats                       print libTC call counters and latencies\n\
+                                          to stderr (needs a make STATS=1 build)\n\
     \n\n\
     Examples :\n\
         tcCoca -F 29.97DF 01:02:03:04 -a 02:10:01:07\n\
         tcCoca -F 29.97DF 4147194251 -R 48000/1\n\
         tcCoca -F 29.97DF 2589407\n\
+        tcCoca -F 23.976 4147194251 -R 48000 --pull down\n\
         tcCoca -F 29.97DF 01:00:00:00 -c 60\n\
+        tcCoca -F 29.97DF 01:00:00:00 -e \"(TC + 00:59:58:00) to 25 - 120\"\n\
+        tcCoca -F 25 --csv log.csv --columns 2,3 --header -c 29.97DF\n\
+        tcCoca -F 25 --fcpxml cut.fcpxml -c 24 > cut24.fcpxml\n\
+        tcCoca -F 29.97DF --gaps ltc.txt\n\
+        tcCoca -F 29.97DF --sort events.csv --columns 3 --header\n\
+        tcCoca -F 23.976 --drift ltc_samples.txt -R 48000\n\
+        tcCoca -F 25 --media /archive/2024 --threads 32\n\
+        tcCoca -F 29.97DF --log ltc.tclog --log-pack ltc.txt\n\
+        tcCoca -F 29.97DF --log ltc.tclog \"14:22:05;12\"\n\
+        tcCoca -F 25 10:00:00:00 --publish house &\n\
+        tcCoca -F 25 --subscribe house -h\n\
+        tcCoca -F 25 10:00:00:00 --burn in.yuv --burn-size 1920x1080 --burn-pixfmt yuv420p --burn-out out.yuv\n\
     \n");
 }
 
@@ -140,7 +277,7 @@ static int isNumber( const char *str )
 
 
 
-static rational_t string_to_rational( const char *str )
+rational_t string_to_rational( const char *str )
 {
     int numerator = 0;
     int denominator = 0;
@@ -165,7 +302,20 @@ static rational_t string_to_rational( const char *str )
 
 
 
-static enum TC_FORMAT string_to_format( const char *str )
+static rational_t string_to_speed( const char *str )
+{
+    if ( strcmp( str, "up"     ) == 0 )  return tc_speed_ratio( TC_SPEED_PULL_UP   );
+    if ( strcmp( str, "down"   ) == 0 )  return tc_speed_ratio( TC_SPEED_PULL_DOWN );
+    if ( strcmp( str, "24to25" ) == 0 )  return tc_speed_ratio( TC_SPEED_24_TO_25  );
+    if ( strcmp( str, "25to24" ) == 0 )  return tc_speed_ratio( TC_SPEED_25_TO_24  );
+
+    return string_to_rational( str );
+}
+
+
+
+
+enum TC_FORMAT string_to_format( const char *str )
 {
 	unsigned int i = 1;
 
@@ -183,8 +333,12 @@ static enum TC_FORMAT string_to_format( const char *str )
 
 
 
-static struct timecode * build_timecode_from_value( const char *tc_value, enum TC_FORMAT tc_format, const char *edit_rate, int noRollover )
+static int build_timecode_from_value( struct timecode *tc, const char *tc_value, enum TC_FORMAT tc_format, const char *edit_rate, int noRollover )
 {
+    memset( tc, 0, sizeof(struct timecode) );
+
+    tc->noRollover = noRollover;
+
     if ( strlen(tc_value) == 11 &&
          isdigit(tc_value[0])   &&
          isdigit(tc_value[1])   &&
@@ -196,13 +350,9 @@ static struct timecode * build_timecode_from_value( const char *tc_value, enum T
          isdigit(tc_value[10])
        )
     {
-        struct timecode *tc = calloc( 1, sizeof(struct timecode) );
-
-		tc->noRollover = noRollover;
-
 		tc_set_by_string( tc, tc_value, tc_format );
 
-        return tc;
+        return 0;
     }
     else if ( edit_rate != NULL && isNumber( tc_value ) )
     {
@@ -211,28 +361,20 @@ static struct timecode * build_timecode_from_value( const char *tc_value, enum T
 
         if ( rate.denominator == 0 )
         {
-            return NULL;
+            return -1;
         }
 
-        struct timecode *tc = calloc( 1, sizeof(struct timecode) );
-
-		tc->noRollover = noRollover;
-
         tc_set_by_unitValue( tc, unitValue, &rate, tc_format );
 
-        return tc;
+        return 0;
     }
     else if ( isNumber( tc_value ) )
     {
-        struct timecode *tc = calloc( 1, sizeof(struct timecode) );
-
-		tc->noRollover = noRollover;
-
         uint64_t frames = strtol( tc_value, NULL, 10 );
 
         tc_set_by_frames( tc, frames, tc_format );
 
-        return tc;
+        return 0;
     }
     else
     {
@@ -240,7 +382,148 @@ static struct timecode * build_timecode_from_value( const char *tc_value, enum T
     }
 
 
-    return NULL;
+    return -1;
+}
+
+
+
+
+static unsigned int cpu_count( void )
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+    return ( n > 0 ) ? n : 1;
+#else
+    return 1;
+#endif
+}
+
+
+
+
+static int burn_frames( FILE *in, FILE *out, struct tc_burn *burn, struct timecode *tc )
+{
+    size_t   size  = tc_pixfmt_frame_size( burn->pixfmt, burn->width, burn->height );
+    uint8_t *frame = malloc( size );
+
+    if ( frame == NULL )
+    {
+        return -1;
+    }
+
+    int rc = 0;
+
+    while ( fread( frame, 1, size, in ) == size )
+    {
+        tc_burn_render( burn, frame, tc );
+
+        if ( fwrite( frame, 1, size, out ) != size )
+        {
+            rc = -1;
+            break;
+        }
+
+        tc_next( tc );
+    }
+
+    if ( rc == 0 && ferror( in ) )
+    {
+        rc = -1;
+    }
+
+    free( frame );
+
+    return rc;
+}
+
+
+
+
+int apply_operation( const struct operation *op, struct timecode *tc )
+{
+	struct timecode value;
+
+	switch ( op->type )
+	{
+		case OPERATION_CONVERT:         tc_convert( tc, op->format );              break;
+		case OPERATION_CONVERT_FRAMES:  tc_convert_frames( tc, op->format );       break;
+
+		case OPERATION_ADD:
+		case OPERATION_SUB:
+
+			/*
+			 *	The operand is hh:mm:ss:ff of whatever format tc is in (media
+			 *	files and published clocks have their own), as long as its
+			 *	frames fit that format.
+			 */
+
+			value = op->value;
+
+			if ( value.format != tc->format )
+			{
+				if ( value.frames >= tc_format_fps( tc->format ) )
+				{
+					return -1;
+				}
+
+				tc_convert_frames( &value, tc->format );
+			}
+
+			return ( op->type == OPERATION_ADD ) ? tc_add( tc, &value ) : tc_sub( tc, &value );
+
+		case OPERATION_STEP:
+
+			/* the same goes for the frames of a step, as hh:mm:ss:ff */
+
+			if ( op->format != TC_FORMAT_UNK && op->format != tc->format )
+			{
+				uint32_t count = ( op->frames < 0 ) ? 0u - (uint32_t)op->frames : (uint32_t)op->frames;
+
+				memset( &value, 0x00, sizeof(struct timecode) );
+
+				value.noRollover = 1;
+
+				tc_set_by_frames( &value, count, op->format );
+
+				if ( value.frames >= tc_format_fps( tc->format ) )
+				{
+					return -1;
+				}
+
+				tc_convert_frames( &value, tc->format );
+
+				tc_step( tc, ( op->frames < 0 ) ? -value.frameNumber : value.frameNumber );
+			}
+			else
+			{
+				tc_step( tc, op->frames );
+			}
+
+			break;
+
+		default:                                                                   break;
+	}
+
+	return 0;
+}
+
+
+
+
+int apply_program( const struct program *prog, struct timecode *tc )
+{
+	unsigned int i = 0;
+
+	for ( ; i < prog->count; i++ )
+	{
+		if ( apply_operation( &prog->ops[i], tc ) < 0 )
+		{
+			return -1;
+		}
+	}
+
+	return 0;
 }
 
 
@@ -251,14 +534,48 @@ int main( int argc, char *argv[] )
 
     char  *c_tc_format         = NULL;
     char  *c_edit_rate         = NULL;
+    char  *c_pull              = NULL;
+    char  *c_unit_rate         = NULL;
     char  *c_convert_to        = NULL;
 	char  *c_convert_frames_to = NULL;
     char  *c_add_value         = NULL;
     char  *c_sub_value         = NULL;
+    char  *c_expr              = NULL;
+    char  *c_csv_file          = NULL;
+    char  *c_csv_columns       = NULL;
+    char  *c_csv_delimiter     = ",";
+    char  *c_threads           = NULL;
+    char  *c_pcap_file         = NULL;
+    char  *c_timeline_file     = NULL;
+    char  *c_gaps_file         = NULL;
+    char  *c_gaps_step         = NULL;
+    char  *c_sort_file         = NULL;
+    char  *c_publish           = NULL;
+    char  *c_subscribe         = NULL;
+    char  *c_log_file          = NULL;
+    char  *c_log_pack          = NULL;
+    char  *c_media_path        = NULL;
+    char  *c_drift_file        = NULL;
+    char  *c_drift_ppm         = NULL;
+    char  *c_audio_pt          = NULL;
+    char  *c_anc_pt            = NULL;
+    char  *c_tai_offset        = "37";
+    char  *c_burn_file         = NULL;
+    char  *c_burn_out          = NULL;
+    char  *c_burn_size         = NULL;
+    char  *c_burn_pixfmt       = "uyvy";
+    char  *c_burn_pos          = NULL;
+    char  *c_burn_scale        = NULL;
 
     int outputHMSF   = 0;
     int outputFrames = 0;
     int noRollover   = 0;
+    int showStats    = 0;
+    int csvHeader    = 0;
+    int timelineType = TIMELINE_FCPXML;
+    int report       = 0;
+    int gapsRuns     = 0;
+    int sortOutput   = SORT_LINES;
 
 
 
@@ -269,14 +586,60 @@ int main( int argc, char *argv[] )
 		{ "list",               no_argument,        0,   'l'  },
 		{ "format",             required_argument,  0,   'F'  },
 		{ "rate",               required_argument,  0,   'R'  },
+		{ "pull",               required_argument,  0,  0x93  },
 		{ "convert-to",         required_argument,  0,   'c'  },
 		{ "convert-frames-to",  required_argument,  0,  0x81  },
 		{ "add",                required_argument,  0,   'a'  },
 		{ "sub",                required_argument,  0,   's'  },
+		{ "expr",               required_argument,  0,   'e'  },
+
+		{ "csv",                required_argument,  0,  0x83  },
+		{ "tsv",                required_argument,  0,  0x84  },
+		{ "columns",            required_argument,  0,  0x85  },
+		{ "delimiter",          required_argument,  0,  0x86  },
+		{ "header",             no_argument,        0,  0x87  },
+		{ "threads",            required_argument,  0,  0x88  },
+
+		{ "fcpxml",             required_argument,  0,  0x95  },
+		{ "otio",               required_argument,  0,  0x96  },
+		{ "report",             no_argument,        0,  0x97  },
+
+		{ "gaps",               required_argument,  0,  0x98  },
+		{ "gaps-step",          required_argument,  0,  0x99  },
+		{ "runs",               no_argument,        0,  0x9a  },
+
+		{ "sort",               required_argument,  0,  0x9b  },
+		{ "unique",             no_argument,        0,  0x9c  },
+		{ "ranges",             no_argument,        0,  0x9d  },
+
+		{ "publish",            required_argument,  0,  0x9e  },
+		{ "subscribe",          required_argument,  0,  0x9f  },
+
+		{ "log",                required_argument,  0,  0xa0  },
+		{ "log-pack",           required_argument,  0,  0xa1  },
+
+		{ "media",              required_argument,  0,  0xa2  },
+
+		{ "drift",              required_argument,  0,  0xa3  },
+		{ "drift-ppm",          required_argument,  0,  0xa4  },
+
+		{ "pcap",               required_argument,  0,  0x89  },
+		{ "audio-pt",           required_argument,  0,  0x8a  },
+		{ "anc-pt",             required_argument,  0,  0x8b  },
+		{ "tai-offset",         required_argument,  0,  0x8c  },
+
+		{ "burn",               required_argument,  0,  0x8d  },
+		{ "burn-out",           required_argument,  0,  0x8e  },
+		{ "burn-size",          required_argument,  0,  0x8f  },
+		{ "burn-pixfmt",        required_argument,  0,  0x90  },
+		{ "burn-pos",           required_argument,  0,  0x91  },
+		{ "burn-scale",         required_argument,  0,  0x92  },
 
 		{ "hmsf",               no_argument,        0,   'h'  },
 		{ "frames",             no_argument,        0,   'f'  },
+		{ "unit-value",         required_argument,  0,  0x94  },
 		{ "rollover",           no_argument,        0,   'r'  },
+		{ "stats",              no_argument,        0,  0x82  },
 
 		{ 0,                    0,                  0,    0   }
 	};
@@ -288,7 +651,7 @@ int main( int argc, char *argv[] )
 	{
 		int option_index = 0;
 
-		c = getopt_long( argc, argv, "lF:R:c:a:s:hfn", long_options, &option_index );
+		c = getopt_long( argc, argv, "lF:R:c:a:s:e:hfn", long_options, &option_index );
 
 		if ( c == -1 )
 			break;
@@ -298,15 +661,64 @@ int main( int argc, char *argv[] )
 			case  'l':   show_formats();                      return 0;
 			case  'F':   c_tc_format         = optarg;           break;
 			case  'R':   c_edit_rate         = optarg;           break;
+			case 0x93:   c_pull              = optarg;           break;
 
 			case  'c':   c_convert_to        = optarg;           break;
 			case 0x81:   c_convert_frames_to = optarg;           break;
 			case  'a':   c_add_value         = optarg;           break;
 			case  's':   c_sub_value         = optarg;           break;
+			case  'e':   c_expr              = optarg;           break;
+
+			case 0x83:   c_csv_file          = optarg;           break;
+			case 0x84:   c_csv_file          = optarg;
+			             c_csv_delimiter     = "\t";             break;
+			case 0x85:   c_csv_columns       = optarg;           break;
+			case 0x86:   c_csv_delimiter     = optarg;           break;
+			case 0x87:   csvHeader           = 1;                break;
+			case 0x88:   c_threads           = optarg;           break;
+
+			case 0x95:   c_timeline_file     = optarg;
+			             timelineType        = TIMELINE_FCPXML;  break;
+			case 0x96:   c_timeline_file     = optarg;
+			             timelineType        = TIMELINE_OTIO;    break;
+			case 0x97:   report              = 1;                break;
+
+			case 0x98:   c_gaps_file         = optarg;           break;
+			case 0x99:   c_gaps_step         = optarg;           break;
+			case 0x9a:   gapsRuns            = 1;                break;
+
+			case 0x9b:   c_sort_file         = optarg;           break;
+			case 0x9c:   sortOutput          = SORT_UNIQUE;      break;
+			case 0x9d:   sortOutput          = SORT_RANGES;      break;
+
+			case 0x9e:   c_publish           = optarg;           break;
+			case 0x9f:   c_subscribe         = optarg;           break;
+
+			case 0xa0:   c_log_file          = optarg;           break;
+			case 0xa1:   c_log_pack          = optarg;           break;
+
+			case 0xa2:   c_media_path        = optarg;           break;
+
+			case 0xa3:   c_drift_file        = optarg;           break;
+			case 0xa4:   c_drift_ppm         = optarg;           break;
+
+			case 0x89:   c_pcap_file         = optarg;           break;
+			case 0x8a:   c_audio_pt          = optarg;           break;
+			case 0x8b:   c_anc_pt            = optarg;           break;
+			case 0x8c:   c_tai_offset        = optarg;           break;
+
+			case 0x8d:   c_burn_file         = optarg;           break;
+			case 0x8e:   c_burn_out          = optarg;           break;
+			case 0x8f:   c_burn_size         = optarg;           break;
+			case 0x90:   c_burn_pixfmt       = optarg;           break;
+			case 0x91:   c_burn_pos          = optarg;           break;
+			case 0x92:   c_burn_scale        = optarg;           break;
 
 			case  'h':   outputHMSF          = 1;                break;
 			case  'f':   outputFrames        = 1;                break;
+			case 0x94:   c_unit_rate         = optarg;           break;
 			case  'n':   noRollover          = 1;                break;
+			case 0x82:   showStats           = 1;                break;
 
 			case 0x80:	show_help();                          return 0;
 
@@ -316,15 +728,13 @@ int main( int argc, char *argv[] )
 
 
 
-	if ( optind == argc )
+	if ( optind == argc && c_csv_file == NULL && c_pcap_file == NULL && c_timeline_file == NULL && c_gaps_file == NULL && c_sort_file == NULL && c_subscribe == NULL && c_log_file == NULL && c_media_path == NULL && c_drift_file == NULL )
 	{
 		fprintf( stderr, "Missing timecode value.\n" );
 		show_usage();
 		return 1;
 	}
 
-	char *c_tc_value = argv[argc-1];
-
 
 
     if ( c_tc_format == NULL )
@@ -345,63 +755,584 @@ int main( int argc, char *argv[] )
 
 
 
-	struct timecode *tc = NULL;
-    struct timecode *sub_value = NULL;
-    struct timecode *add_value = NULL;
+    unsigned int threads = 0;  // each mode has its own default
 
+    if ( c_threads != NULL )
+    {
+        char *end = NULL;
+        long  n   = strtol( c_threads, &end, 10 );
 
-	tc = build_timecode_from_value( c_tc_value, tc_format, c_edit_rate, noRollover );
+        if ( end == c_threads || *end != '\0' || n <= 0 || n > 1024 )
+        {
+            fprintf( stderr, "Wrong --threads, it must be a number from 1 to 1024.\n" );
+            return 1;
+        }
+
+        threads = (unsigned int)n;
+    }
 
-    if ( tc == NULL )
+
+
+    char pulledRate[32];
+
+    if ( c_pull != NULL )
     {
-        return 1;
+        struct tc_pull pull;
+
+        if ( c_edit_rate == NULL || tc_pull_init( &pull, string_to_rational( c_edit_rate ), string_to_speed( c_pull ) ) < 0 )
+        {
+            fprintf( stderr, "--pull needs a valid edit rate and speed.\n" );
+            return 1;
+        }
+
+        snprintf( pulledRate, sizeof(pulledRate), "%i/%i", pull.pulled.numerator, pull.pulled.denominator );
+
+        c_edit_rate = pulledRate;
     }
 
 
 
+    struct operation op;
+
+    memset( &op, 0x00, sizeof(struct operation) );
+
+
     if ( c_convert_to != NULL )
     {
-        enum TC_FORMAT convert_to = string_to_format( c_convert_to );
+        op.type   = OPERATION_CONVERT;
+        op.format = string_to_format( c_convert_to );
 
-        if ( convert_to == TC_FORMAT_UNK )
+        if ( op.format == TC_FORMAT_UNK )
         {
             return 1;
         }
-
-        tc_convert( tc, convert_to );
     }
 	else if ( c_convert_frames_to != NULL )
     {
-        enum TC_FORMAT convert_frames_to = string_to_format( c_convert_frames_to );
+        op.type   = OPERATION_CONVERT_FRAMES;
+        op.format = string_to_format( c_convert_frames_to );
 
-        if ( convert_frames_to == TC_FORMAT_UNK )
+        if ( op.format == TC_FORMAT_UNK )
         {
             return 1;
         }
+    }
+    else if ( c_add_value != NULL || c_sub_value != NULL )
+    {
+        op.type = ( c_add_value != NULL ) ? OPERATION_ADD : OPERATION_SUB;
 
-        tc_convert_frames( tc, convert_frames_to );
+        if ( build_timecode_from_value( &op.value, ( c_add_value != NULL ) ? c_add_value : c_sub_value, tc_format, NULL, noRollover ) < 0 )
+        {
+            return 1;
+        }
     }
-    else if ( c_add_value != NULL )
+
+
+    struct program prog;
+
+    memset( &prog, 0x00, sizeof(struct program) );
+
+    if ( c_expr != NULL )
     {
-        add_value = build_timecode_from_value( c_add_value, tc_format, NULL, noRollover );
+        char error[128];
 
-        if ( add_value == NULL )
+        if ( op.type != OPERATION_NONE )
         {
+            fprintf( stderr, "--expr can't be used with -c, --convert-frames-to, -a or -s.\n" );
             return 1;
         }
 
-        tc_add( tc, add_value );
+        if ( expr_compile( &prog, c_expr, tc_format, error, sizeof(error) ) < 0 )
+        {
+            fprintf( stderr, "Wrong expression, %s.\n", error );
+            return 1;
+        }
     }
-    else if ( c_sub_value != NULL )
+    else if ( op.type != OPERATION_NONE )
     {
-        sub_value = build_timecode_from_value( c_sub_value, tc_format, NULL, noRollover );
+        prog.ops[prog.count++] = op;
+    }
+
+
+
+    if ( c_drift_file != NULL )
+    {
+        struct drift_options opts;
+
+        memset( &opts, 0x00, sizeof(struct drift_options) );
 
-        if ( sub_value == NULL )
+        opts.format       = tc_format;
+        opts.unitRate     = ( c_edit_rate != NULL ) ? string_to_rational( c_edit_rate ) : opts.unitRate;
+        opts.thresholdPpm = 1;
+
+        if ( c_drift_ppm != NULL )
+        {
+            char *end = NULL;
+
+            opts.thresholdPpm = strtod( c_drift_ppm, &end );
+
+            if ( end == c_drift_ppm || *end != '\0' || !( opts.thresholdPpm >= 0 && opts.thresholdPpm <= 1000000 ) )
+            {
+                fprintf( stderr, "Wrong --drift-ppm, it must be a number from 0 to 1000000.\n" );
+                return 1;
+            }
+        }
+
+        if ( opts.unitRate.denominator == 0 )
+        {
+            fprintf( stderr, "--drift needs the rate of the unit values, -R.\n" );
+            return 1;
+        }
+
+        FILE *fp = ( strcmp( c_drift_file, "-" ) == 0 ) ? stdin : fopen( c_drift_file, "rb" );
+
+        if ( fp == NULL )
         {
+            fprintf( stderr, "Could not open \"%s\".\n", c_drift_file );
             return 1;
         }
 
-        tc_sub( tc, sub_value );
+        int rc = drift_estimate( fp, &opts, stdout );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not estimate a drift from \"%s\".\n", c_drift_file );
+        }
+
+        if ( fp != stdin )
+        {
+            fclose( fp );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_media_path != NULL )
+    {
+        struct scan_options opts;
+
+        memset( &opts, 0x00, sizeof(struct scan_options) );
+
+        opts.format     = tc_format;
+        opts.threads    = ( threads > 0 ) ? threads : cpu_count() * 4;
+        opts.noRollover = noRollover;
+        opts.program    = &prog;
+
+        int rc = scan_media( c_media_path, &opts, stdout );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not open \"%s\".\n", c_media_path );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_log_file != NULL && ( c_log_pack != NULL || optind == argc ) )
+    {
+        int rc = 0;
+
+        if ( c_log_pack != NULL )
+        {
+            FILE *fp = ( strcmp( c_log_pack, "-" ) == 0 ) ? stdin : fopen( c_log_pack, "rb" );
+
+            if ( fp == NULL )
+            {
+                fprintf( stderr, "Could not open \"%s\".\n", c_log_pack );
+                return 1;
+            }
+
+            rc = logs_pack( fp, c_log_file, tc_format, stdout );
+
+            if ( fp != stdin )
+            {
+                fclose( fp );
+            }
+        }
+        else
+        {
+            rc = logs_dump( c_log_file, noRollover, stdout );
+        }
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not %s \"%s\".\n", ( c_log_pack != NULL ) ? "write" : "read", c_log_file );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_sort_file != NULL )
+    {
+        struct sort_options opts;
+
+        memset( &opts, 0x00, sizeof(struct sort_options) );
+
+        opts.format     = tc_format;
+        opts.output     = sortOutput;
+        opts.column     = 1;
+        opts.delimiter  = c_csv_delimiter[0];
+        opts.header     = csvHeader;
+        opts.noRollover = noRollover;
+        opts.threads    = ( threads > 0 ) ? threads : cpu_count();
+
+        if ( c_csv_columns != NULL )
+        {
+            char *end = NULL;
+            long  n   = strtol( c_csv_columns, &end, 10 );
+
+            if ( end == c_csv_columns || *end != '\0' || n < 1 || n > CSV_MAX_COLUMNS )
+            {
+                fprintf( stderr, "Wrong --columns, --sort takes one column, from 1 to %i.\n", CSV_MAX_COLUMNS );
+                return 1;
+            }
+
+            opts.column = (unsigned int)n;
+        }
+
+        if ( strlen( c_csv_delimiter ) != 1 )
+        {
+            fprintf( stderr, "Wrong --delimiter.\n" );
+            return 1;
+        }
+
+        int rc = sort_lines( c_sort_file, &opts, stdout );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not sort \"%s\".\n", c_sort_file );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_gaps_file != NULL )
+    {
+        struct gaps_options opts;
+
+        memset( &opts, 0x00, sizeof(struct gaps_options) );
+
+        opts.format     = tc_format;
+        opts.increment  = 1;
+        opts.noRollover = noRollover;
+        opts.runs       = gapsRuns;
+
+        if ( c_gaps_step != NULL )
+        {
+            char *end = NULL;
+            long  n   = strtol( c_gaps_step, &end, 10 );
+            long  day = (long)tc_frames_per_day( tc_format );
+
+            if ( end == c_gaps_step || *end != '\0' || n == 0 || n <= -day || n >= day )
+            {
+                fprintf( stderr, "Wrong --gaps-step, it must be a non-zero number of frames, less than a day.\n" );
+                return 1;
+            }
+
+            opts.increment = (int32_t)n;
+        }
+
+        FILE *fp = ( strcmp( c_gaps_file, "-" ) == 0 ) ? stdin : fopen( c_gaps_file, "rb" );
+
+        if ( fp == NULL )
+        {
+            fprintf( stderr, "Could not open \"%s\".\n", c_gaps_file );
+            return 1;
+        }
+
+        int rc = gaps_scan( fp, &opts, stdout );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not read \"%s\".\n", c_gaps_file );
+        }
+
+        if ( fp != stdin )
+        {
+            fclose( fp );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_timeline_file != NULL )
+    {
+        struct timeline_options opts;
+
+        memset( &opts, 0x00, sizeof(struct timeline_options) );
+
+        opts.type       = timelineType;
+        opts.format     = tc_format;
+        opts.noRollover = noRollover;
+        opts.report     = report;
+        opts.program    = &prog;
+
+        int rc = timeline_convert( c_timeline_file, &opts, stdout );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Could not convert \"%s\".\n", c_timeline_file );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_pcap_file != NULL )
+    {
+        struct pcap_options opts;
+
+        memset( &opts, 0x00, sizeof(struct pcap_options) );
+
+        if ( ( c_audio_pt != NULL && pcap_set_payload_types( opts.audioPT, c_audio_pt ) < 0 ) ||
+             ( c_anc_pt   != NULL && pcap_set_payload_types( opts.ancPT,   c_anc_pt   ) < 0 ) )
+        {
+            fprintf( stderr, "Wrong payload type list.\n" );
+            return 1;
+        }
+
+        opts.format    = tc_format;
+        opts.taiOffset = atoi( c_tai_offset );
+
+        int rc = pcap_analyze( c_pcap_file, &opts, stdout );
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+    if ( c_csv_file != NULL )
+    {
+        struct csv_options opts;
+
+        memset( &opts, 0x00, sizeof(struct csv_options) );
+
+        if ( c_csv_columns == NULL || csv_set_columns( &opts, c_csv_columns ) < 0 )
+        {
+            fprintf( stderr, "Missing or wrong --columns list.\n" );
+            return 1;
+        }
+
+        if ( strlen( c_csv_delimiter ) != 1 )
+        {
+            fprintf( stderr, "Delimiter must be a single character.\n" );
+            return 1;
+        }
+
+        rational_t rate;
+
+        if ( c_edit_rate != NULL )
+        {
+            rate = string_to_rational( c_edit_rate );
+
+            if ( rate.denominator == 0 )
+            {
+                return 1;
+            }
+
+            opts.editRate = &rate;
+        }
+
+        opts.delimiter    = c_csv_delimiter[0];
+        opts.header       = csvHeader;
+        opts.format       = tc_format;
+        opts.noRollover   = noRollover;
+        opts.outputFrames = outputFrames;
+        opts.program      = &prog;
+        opts.threads      = ( threads > 0 ) ? threads : cpu_count();
+
+        FILE *fp = ( strcmp( c_csv_file, "-" ) == 0 ) ? stdin : fopen( c_csv_file, "rb" );
+
+        if ( fp == NULL )
+        {
+            fprintf( stderr, "Could not open \"%s\".\n", c_csv_file );
+            return 1;
+        }
+
+        int rc = csv_convert( fp, stdout, &opts );
+
+        if ( fp != stdin )
+        {
+            fclose( fp );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        return ( rc < 0 ) ? 1 : 0;
+    }
+
+
+
+	char *c_tc_value = argv[argc-1];
+
+	struct timecode value;
+	struct timecode *tc = &value;
+
+    if ( c_subscribe != NULL )
+    {
+        memset( tc, 0, sizeof(struct timecode) );
+
+        tc->noRollover = noRollover;
+
+        int rc = broadcast_get( c_subscribe, tc );
+
+        if ( rc < 0 )
+        {
+            fprintf( stderr, "Nothing published in \"%s\".\n", c_subscribe );
+            return 1;
+        }
+
+        if ( rc > 0 )
+        {
+            fprintf( stderr, "\"%s\" stopped at %s.\n", c_subscribe, tc->string );
+            return 1;
+        }
+    }
+    else if ( build_timecode_from_value( tc, c_tc_value, tc_format, c_edit_rate, noRollover ) < 0 )
+    {
+        return 1;
+    }
+
+    if ( apply_program( &prog, tc ) < 0 )
+    {
+        fprintf( stderr, "Could not apply the operation to %s, a %s timecode.\n", tc->string, TC_FORMAT_STR[tc->format] );
+        return 1;
+    }
+
+
+
+    if ( c_log_file != NULL )
+    {
+        if ( logs_find( c_log_file, tc, stdout ) < 0 )
+        {
+            fprintf( stderr, "Could not read \"%s\".\n", c_log_file );
+            return 1;
+        }
+
+        return 0;
+    }
+
+
+
+    if ( c_publish != NULL )
+    {
+        if ( broadcast_publish( c_publish, tc ) < 0 )
+        {
+            fprintf( stderr, "Could not open \"%s\" : %s.\n", c_publish, strerror( errno ) );
+            return 1;
+        }
+
+        return 0;
+    }
+
+
+
+    if ( c_burn_file != NULL )
+    {
+        unsigned int width = 0, height = 0, x = 0, y = 0;
+
+        if ( c_burn_size == NULL || sscanf( c_burn_size, "%ux%u", &width, &height ) != 2 )
+        {
+            fprintf( stderr, "Missing or wrong --burn-size.\n" );
+            return 1;
+        }
+
+        x = width  / 32;
+        y = height / 32;
+
+        if ( c_burn_pos != NULL && sscanf( c_burn_pos, "%u,%u", &x, &y ) != 2 )
+        {
+            fprintf( stderr, "Wrong --burn-pos.\n" );
+            return 1;
+        }
+
+        unsigned int scale = ( c_burn_scale != NULL ) ? (unsigned int)atoi( c_burn_scale ) : height / 270;
+
+        struct tc_burn burn;
+
+        if ( tc_burn_init( &burn, tc_pixfmt_from_string( c_burn_pixfmt ), width, height, x, y, ( scale > 0 ) ? scale : 1 ) < 0 )
+        {
+            fprintf( stderr, "Wrong burn-in parameters.\n" );
+            return 1;
+        }
+
+        FILE *in  = ( strcmp( c_burn_file, "-" ) == 0 ) ? stdin : fopen( c_burn_file, "rb" );
+        FILE *out = ( c_burn_out == NULL || strcmp( c_burn_out, "-" ) == 0 ) ? stdout : fopen( c_burn_out, "wb" );
+
+        int rc = ( in == NULL || out == NULL ) ? -1 : burn_frames( in, out, &burn, tc );
+
+        if ( in == NULL || out == NULL )
+        {
+            fprintf( stderr, "Could not open \"%s\".\n", ( in == NULL ) ? c_burn_file : c_burn_out );
+        }
+
+        if ( in != NULL && in != stdin )
+        {
+            fclose( in );
+        }
+
+        if ( out != NULL && out != stdout )
+        {
+            fclose( out );
+        }
+
+        if ( showStats )
+        {
+            tc_stats_dump( stderr, tc_stats_get() );
+        }
+
+        tc_burn_free( &burn );
+
+        return ( rc < 0 ) ? 1 : 0;
     }
 
 
@@ -414,6 +1345,17 @@ int main( int argc, char *argv[] )
     {
         printf( "%u\n", tc->frameNumber );
     }
+    else if ( c_unit_rate != NULL )
+    {
+        rational_t rate = string_to_rational( c_unit_rate );
+
+        if ( rate.denominator == 0 )
+        {
+            return 1;
+        }
+
+        printf( "%llu\n", (unsigned long long)tc_get_unitValue( tc, &rate, TC_ROUND_NEAREST ) );
+    }
     else
     {
 		printf( "format   : %s\n", TC_FORMAT_STR[tc->format] );
@@ -423,20 +1365,13 @@ int main( int argc, char *argv[] )
 
 
 
-    if ( tc != NULL )
+    if ( showStats )
     {
-        free( tc );
+        tc_stats_dump( stderr, tc_stats_get() );
     }
 
-    if ( add_value != NULL )
-    {
-        free( add_value );
-    }
 
-    if ( sub_value != NULL )
-    {
-        free( sub_value );
-    }
+
 
 
 	return 0;
@@ -0,0 +1,89 @@
+#ifndef __tcCoca_h__
+#define __tcCoca_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lib/libTC.h"
+
+
+
+/*
+ *	The operations requested on the command line (-c, --convert-frames-to,
+ *	-a, -s or an --expr program), resolved once so they can be applied to
+ *	any number of values.
+ */
+
+enum OPERATION_TYPE {
+
+	OPERATION_NONE = 0,
+
+	OPERATION_CONVERT,
+	OPERATION_CONVERT_FRAMES,
+	OPERATION_ADD,
+	OPERATION_SUB,
+	OPERATION_STEP
+};
+
+
+struct operation
+{
+	enum OPERATION_TYPE type;
+
+	enum TC_FORMAT      format;   // destination format of a conversion, format of the frames of a step
+
+	struct timecode     value;    // operand of an addition / subtraction
+
+	int32_t             frames;   // frame count of a step, constants resolved beforehand
+
+};
+
+
+#define PROGRAM_MAX_OPERATIONS 64
+
+struct program
+{
+	unsigned int        count;
+
+	struct operation    ops[PROGRAM_MAX_OPERATIONS];
+
+};
+
+
+/**
+ *	Return 0, or -1 if an addition / subtraction operand, or the frames of a
+ *	step, can't be expressed in the format of tc (eg. 00:00:00:29 for a 25
+ *	fps value).
+ */
+
+int apply_operation( const struct operation *op, struct timecode *tc );
+
+int apply_program( const struct program *prog, struct timecode *tc );
+
+
+
+extern char *TC_FORMAT_STR[];
+
+
+rational_t string_to_rational( const char *str );
+
+enum TC_FORMAT string_to_format( const char *str );
+
+
+#endif // ! __tcCoca_h__
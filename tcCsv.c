@@ -0,0 +1,790 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "tcCsv.h"
+#include "lib/tcStats.h"
+
+
+
+/*
+ *	The input is read in chunks cut on the last line feed. Each chunk is a
+ *	job converted by one of the workers, and the main thread writes the jobs
+ *	back in the order they were read. CSV_SLOTS_PER_THREAD jobs per worker
+ *	are kept in flight so reading, converting and writing overlap.
+ */
+
+#define CSV_CHUNK_SIZE        (4 * 1024 * 1024)
+#define CSV_SLOTS_PER_THREAD  2
+
+
+enum CSV_SLOT_STATE {
+
+	CSV_SLOT_FREE = 0,
+	CSV_SLOT_PENDING,
+	CSV_SLOT_BUSY,
+	CSV_SLOT_DONE
+};
+
+
+struct csv_slot
+{
+	enum CSV_SLOT_STATE state;
+
+	uint8_t  firstChunk;
+
+	char    *in;
+	size_t   inLen;
+	size_t   inSize;
+
+	char    *out;
+	size_t   outLen;
+	size_t   outSize;
+
+	int      error;
+
+};
+
+
+struct csv_pool
+{
+	const struct csv_options *opts;
+
+	struct csv_slot *slots;
+	unsigned int     slotsLen;
+
+	unsigned int     nextJob;   // next slot a worker should pick up
+	unsigned int     queued;    // number of pending jobs
+	int              closing;
+
+	pthread_mutex_t  lock;
+	pthread_cond_t   jobReady;
+	pthread_cond_t   jobDone;
+
+	struct tc_stats *stats;     // calling thread counters, workers fold theirs in
+
+};
+
+
+
+
+static int out_reserve( struct csv_slot *slot, size_t len )
+{
+	if ( slot->outLen + len <= slot->outSize )
+	{
+		return 0;
+	}
+
+	size_t size = ( slot->outSize ) ? slot->outSize : CSV_CHUNK_SIZE;
+
+	while ( size < slot->outLen + len )
+	{
+		size *= 2;
+	}
+
+	char *out = realloc( slot->out, size );
+
+	if ( out == NULL )
+	{
+		return -1;
+	}
+
+	slot->out     = out;
+	slot->outSize = size;
+
+	return 0;
+}
+
+
+
+
+static inline int out_append( struct csv_slot *slot, const char *data, size_t len )
+{
+	if ( out_reserve( slot, len ) < 0 )
+	{
+		return -1;
+	}
+
+	memcpy( slot->out + slot->outLen, data, len );
+
+	slot->outLen += len;
+
+	return 0;
+}
+
+
+
+
+static inline int is_digit( char c )
+{
+	return ( c >= '0' && c <= '9' );
+}
+
+
+
+
+/*
+ *	1 and the frame number if the value is a valid hh:mm:ss:ff or a frame
+ *	count, i.e. parse_value() would give the timecode of that frame number.
+ *	Rows are mostly close to each other, so the previous converted field is
+ *	just stepped to these ones (as tc_array_render() does) : no parsing, no
+ *	snprintf(). Labels that libTC keeps as given (out of range, dropped, or
+ *	any 59.94DF one) return 0 and go the full way.
+ */
+
+static int plain_frames( const char *str, size_t len, const struct csv_options *opts, int32_t *frames )
+{
+	if ( len == 11 &&
+	     is_digit(str[0]) && is_digit(str[1]) &&
+	     is_digit(str[3]) && is_digit(str[4]) &&
+	     is_digit(str[6]) && is_digit(str[7]) &&
+	     is_digit(str[9]) && is_digit(str[10]) )
+	{
+		unsigned int h = (str[0]-'0')*10 + (str[1]-'0');
+		unsigned int m = (str[3]-'0')*10 + (str[4]-'0');
+		unsigned int s = (str[6]-'0')*10 + (str[7]-'0');
+		unsigned int f = (str[9]-'0')*10 + (str[10]-'0');
+
+		if ( h >= 24 || m >= 60 || s >= 60 || f >= tc_format_fps( opts->format ) || opts->format == TC_59_94_DF ||
+		     ( opts->format == TC_29_97_DF && s == 0 && f < 2 && ( m % 10 ) != 0 ) )
+		{
+			return 0;
+		}
+
+		*frames = tc_hmsf_to_frames( h, m, s, f, opts->format );
+		return 1;
+	}
+
+	if ( opts->editRate != NULL || len == 0 || len > 9 )
+	{
+		return 0;
+	}
+
+	int32_t value = 0;
+
+	size_t i = 0;
+
+	for ( ; i < len; i++ )
+	{
+		if ( is_digit( str[i] ) == 0 )
+		{
+			return 0;
+		}
+
+		value = value * 10 + (str[i] - '0');
+	}
+
+	*frames = value;
+
+	return 1;
+}
+
+
+/*
+ *	The result of the operation only moves with the input as long as it
+ *	keeps frame numbers : --convert-frames-to keeps hh:mm:ss:ff instead.
+ */
+
+static int steppable( const struct program *prog )
+{
+	unsigned int i = 0;
+
+	for ( ; prog != NULL && i < prog->count; i++ )
+	{
+		if ( prog->ops[i].type == OPERATION_CONVERT_FRAMES )
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+static size_t put_int( char *out, int32_t v )
+{
+	char     digits[12];
+	size_t   len = 0, n = 0;
+	uint32_t u   = ( v < 0 ) ? 0u - (uint32_t)v : (uint32_t)v;
+
+	do
+	{
+		digits[n++] = '0' + u % 10;
+		u /= 10;
+	}
+	while ( u != 0 );
+
+	if ( v < 0 )
+	{
+		out[len++] = '-';
+	}
+
+	while ( n > 0 )
+	{
+		out[len++] = digits[--n];
+	}
+
+	return len;
+}
+
+
+
+
+/*
+ *	Same rules as build_timecode_from_value(), without building any string :
+ *	hh:mm:ss:ff (any separator), then a unit value if an edit rate was given,
+ *	then a frame number. Anything else is left untouched by the caller.
+ */
+
+static int parse_value( const char *str, size_t len, const struct csv_options *opts, struct timecode *tc )
+{
+	tc->noRollover = opts->noRollover;
+
+	if ( len == 11 &&
+	     is_digit(str[0]) && is_digit(str[1]) &&
+	     is_digit(str[3]) && is_digit(str[4]) &&
+	     is_digit(str[6]) && is_digit(str[7]) &&
+	     is_digit(str[9]) && is_digit(str[10]) )
+	{
+		tc_set_by_hmsf( tc, (str[0]-'0')*10 + (str[1]-'0'),
+		                    (str[3]-'0')*10 + (str[4]-'0'),
+		                    (str[6]-'0')*10 + (str[7]-'0'),
+		                    (str[9]-'0')*10 + (str[10]-'0'),
+		                    opts->format );
+		return 0;
+	}
+
+	if ( len == 0 || len > 19 )
+	{
+		return -1;
+	}
+
+	uint64_t value = 0;
+
+	size_t i = 0;
+
+	for ( ; i < len; i++ )
+	{
+		if ( is_digit( str[i] ) == 0 )
+		{
+			return -1;
+		}
+
+		value = value * 10 + (str[i] - '0');
+	}
+
+	if ( opts->editRate != NULL )
+	{
+		tc_set_by_unitValue( tc, value, (rational_t*)opts->editRate, opts->format );
+	}
+	else
+	{
+		tc_set_by_frames( tc, value, opts->format );
+	}
+
+	return 0;
+}
+
+
+
+
+static int convert_chunk( struct csv_slot *slot, const struct csv_options *opts )
+{
+	const char *p       = slot->in;
+	const char *end     = slot->in + slot->inLen;
+	const char *flushed = p;   // input up to here is already in the output
+
+	const char  delim   = opts->delimiter;
+
+	struct timecode tc;
+
+	char value[32];
+
+	memset( &tc, 0x00, sizeof(struct timecode) );
+
+	const int step = steppable( opts->program );
+
+	int      stepped = 0;   // tc is the converted field of input frame number last
+	int32_t  last    = 0;
+
+	slot->outLen = 0;
+
+
+	if ( slot->firstChunk && opts->header )
+	{
+		p = memchr( p, '\n', end - p );
+		p = ( p == NULL ) ? end : p + 1;
+	}
+
+
+	while ( p < end )
+	{
+		const char *field = p;
+
+		uint32_t    col   = 1;
+
+		while ( 1 )
+		{
+			const char *vs = field;
+			const char *ve = NULL;
+			const char *fe = field;
+
+			if ( *field == '"' )
+			{
+				vs = ++fe;
+
+				while ( fe < end )
+				{
+					if ( *fe == '"' )
+					{
+						if ( fe + 1 < end && fe[1] == '"' )
+						{
+							fe += 2;
+							continue;
+						}
+
+						break;
+					}
+
+					fe++;
+				}
+
+				ve = fe;
+
+				while ( fe < end && *fe != delim && *fe != '\n' )
+				{
+					fe++;
+				}
+			}
+			else
+			{
+				while ( fe < end && *fe != delim && *fe != '\n' )
+				{
+					fe++;
+				}
+
+				ve = ( fe > vs && fe[-1] == '\r' ) ? fe - 1 : fe;
+			}
+
+
+			int32_t frames = 0;
+			int     plain  = 0;
+			int     parsed = 0;
+
+			if ( col < CSV_MAX_COLUMNS && opts->columns[col] )
+			{
+				plain = step && plain_frames( vs, ve - vs, opts, &frames );
+
+				if ( plain && stepped )
+				{
+					tc_step( &tc, frames - last );
+					parsed = 1;
+				}
+				else if ( parse_value( vs, ve - vs, opts, &tc ) == 0 )
+				{
+					apply_program( opts->program, &tc );
+					parsed = 1;
+				}
+			}
+
+			if ( parsed )
+			{
+				stepped = plain;
+				last    = frames;
+
+				size_t len = 0;
+
+				if ( opts->outputFrames )
+				{
+					len = put_int( value, tc.frameNumber );
+				}
+				else
+				{
+					len = strlen( tc.string );
+					memcpy( value, tc.string, len );
+				}
+
+				if ( out_append( slot, flushed, vs - flushed ) < 0 ||
+				     out_append( slot, value, len ) < 0 )
+				{
+					return -1;
+				}
+
+				flushed = ve;
+			}
+
+
+			if ( fe >= end )
+			{
+				p = end;
+				break;
+			}
+
+			if ( *fe == '\n' )
+			{
+				p = fe + 1;
+				break;
+			}
+
+			if ( col >= opts->lastColumn )
+			{
+				/* no selected column left on this line */
+
+				p = memchr( fe, '\n', end - fe );
+				p = ( p == NULL ) ? end : p + 1;
+				break;
+			}
+
+			field = fe + 1;
+			col++;
+		}
+	}
+
+	return out_append( slot, flushed, end - flushed );
+}
+
+
+
+
+static void * csv_worker( void *arg )
+{
+	struct csv_pool *pool = arg;
+
+	pthread_mutex_lock( &pool->lock );
+
+	while ( 1 )
+	{
+		while ( pool->queued == 0 && pool->closing == 0 )
+		{
+			pthread_cond_wait( &pool->jobReady, &pool->lock );
+		}
+
+		if ( pool->queued == 0 )
+		{
+			break;
+		}
+
+		struct csv_slot *slot = &pool->slots[pool->nextJob];
+
+		pool->nextJob = (pool->nextJob + 1) % pool->slotsLen;
+		pool->queued--;
+
+		slot->state = CSV_SLOT_BUSY;
+
+		pthread_mutex_unlock( &pool->lock );
+
+		slot->error = convert_chunk( slot, pool->opts );
+
+		pthread_mutex_lock( &pool->lock );
+
+		slot->state = CSV_SLOT_DONE;
+
+		pthread_cond_broadcast( &pool->jobDone );
+	}
+
+	if ( pool->stats != NULL )
+	{
+		tc_stats_merge( pool->stats, tc_stats_get() );
+	}
+
+	pthread_mutex_unlock( &pool->lock );
+
+	return NULL;
+}
+
+
+
+
+static int flush_slot( struct csv_pool *pool, struct csv_slot *slot, FILE *out )
+{
+	pthread_mutex_lock( &pool->lock );
+
+	while ( slot->state != CSV_SLOT_DONE )
+	{
+		pthread_cond_wait( &pool->jobDone, &pool->lock );
+	}
+
+	pthread_mutex_unlock( &pool->lock );
+
+	slot->state = CSV_SLOT_FREE;
+
+	if ( slot->error < 0 )
+	{
+		fprintf( stderr, "Out of memory while converting.\n" );
+		return -1;
+	}
+
+	if ( fwrite( slot->out, 1, slot->outLen, out ) != slot->outLen )
+	{
+		fprintf( stderr, "Could not write output.\n" );
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+int csv_set_columns( struct csv_options *opts, const char *list )
+{
+	memset( opts->columns, 0x00, sizeof(opts->columns) );
+
+	opts->lastColumn = 0;
+
+	while ( *list != '\0' )
+	{
+		char *end = NULL;
+
+		long col = strtol( list, &end, 10 );
+
+		if ( end == list || col < 1 || col >= CSV_MAX_COLUMNS || ( *end != ',' && *end != '\0' ) )
+		{
+			return -1;
+		}
+
+		opts->columns[col] = 1;
+
+		if ( (uint32_t)col > opts->lastColumn )
+		{
+			opts->lastColumn = col;
+		}
+
+		list = ( *end == ',' ) ? end + 1 : end;
+	}
+
+	return ( opts->lastColumn == 0 ) ? -1 : 0;
+}
+
+
+
+
+int csv_convert( FILE *in, FILE *out, const struct csv_options *opts )
+{
+	struct csv_pool pool;
+
+	memset( &pool, 0x00, sizeof(struct csv_pool) );
+
+	unsigned int threads = ( opts->threads > 0 ) ? opts->threads : 1;
+
+	pool.opts     = opts;
+	pool.slotsLen = threads * CSV_SLOTS_PER_THREAD;
+	pool.slots    = calloc( pool.slotsLen, sizeof(struct csv_slot) );
+	pool.stats    = (struct tc_stats*)tc_stats_get();
+
+	pthread_t *workers = calloc( threads, sizeof(pthread_t) );
+
+	if ( pool.slots == NULL || workers == NULL )
+	{
+		free( pool.slots );
+		free( workers );
+		return -1;
+	}
+
+	pthread_mutex_init( &pool.lock, NULL );
+	pthread_cond_init( &pool.jobReady, NULL );
+	pthread_cond_init( &pool.jobDone, NULL );
+
+	unsigned int started = 0;
+
+	while ( started < threads && pthread_create( &workers[started], NULL, csv_worker, &pool ) == 0 )
+	{
+		started++;
+	}
+
+	unsigned int i = 0;
+
+
+	int rc = 0;
+
+	char   *carry     = NULL;   // incomplete last line of the previous read
+	size_t  carryLen  = 0;
+	size_t  carrySize = 0;
+
+	unsigned int next  = 0;     // slot receiving the next chunk
+	unsigned int first = 1;
+	int          eof   = 0;
+
+	while ( rc == 0 && ( eof == 0 || carryLen > 0 ) )
+	{
+		struct csv_slot *slot = &pool.slots[next];
+
+		if ( slot->state != CSV_SLOT_FREE && flush_slot( &pool, slot, out ) < 0 )
+		{
+			rc = -1;
+			break;
+		}
+
+		if ( slot->inSize < carryLen + CSV_CHUNK_SIZE )
+		{
+			char *buf = realloc( slot->in, carryLen + CSV_CHUNK_SIZE );
+
+			if ( buf == NULL )
+			{
+				rc = -1;
+				break;
+			}
+
+			slot->in     = buf;
+			slot->inSize = carryLen + CSV_CHUNK_SIZE;
+		}
+
+		memcpy( slot->in, carry, carryLen );
+
+		size_t rd = ( eof ) ? 0 : fread( slot->in + carryLen, 1, CSV_CHUNK_SIZE, in );
+
+		if ( rd < CSV_CHUNK_SIZE )
+		{
+			if ( ferror( in ) )
+			{
+				fprintf( stderr, "Could not read input.\n" );
+				rc = -1;
+				break;
+			}
+
+			eof = 1;
+		}
+
+		size_t len  = carryLen + rd;
+		size_t keep = len;
+
+		if ( eof == 0 )
+		{
+			while ( keep > 0 && slot->in[keep-1] != '\n' )
+			{
+				keep--;
+			}
+		}
+
+		if ( keep == 0 && eof == 0 )
+		{
+			/* no line end yet, keep accumulating */
+
+			if ( carrySize < len )
+			{
+				char *buf = realloc( carry, len * 2 );
+
+				if ( buf == NULL )
+				{
+					rc = -1;
+					break;
+				}
+
+				carry     = buf;
+				carrySize = len * 2;
+			}
+
+			memcpy( carry, slot->in, len );
+
+			carryLen = len;
+
+			continue;
+		}
+
+		carryLen = len - keep;
+
+		if ( carryLen > carrySize )
+		{
+			char *buf = realloc( carry, carryLen * 2 );
+
+			if ( buf == NULL )
+			{
+				rc = -1;
+				break;
+			}
+
+			carry     = buf;
+			carrySize = carryLen * 2;
+		}
+
+		memcpy( carry, slot->in + keep, carryLen );
+
+		slot->inLen      = keep;
+		slot->firstChunk = first;
+
+		first = 0;
+
+		if ( started == 0 )
+		{
+			/* no worker could start : the chunk is converted here */
+
+			slot->error = convert_chunk( slot, opts );
+			slot->state = CSV_SLOT_DONE;
+		}
+		else
+		{
+			pthread_mutex_lock( &pool.lock );
+
+			slot->state = CSV_SLOT_PENDING;
+			pool.queued++;
+
+			pthread_cond_signal( &pool.jobReady );
+			pthread_mutex_unlock( &pool.lock );
+		}
+
+		next = (next + 1) % pool.slotsLen;
+	}
+
+
+	/* write back what is still in flight, oldest first */
+
+	for ( i = 0; i < pool.slotsLen; i++ )
+	{
+		struct csv_slot *slot = &pool.slots[(next + i) % pool.slotsLen];
+
+		if ( slot->state != CSV_SLOT_FREE && flush_slot( &pool, slot, out ) < 0 )
+		{
+			rc = -1;
+		}
+	}
+
+
+	pthread_mutex_lock( &pool.lock );
+
+	pool.closing = 1;
+
+	pthread_cond_broadcast( &pool.jobReady );
+	pthread_mutex_unlock( &pool.lock );
+
+	for ( i = 0; i < started; i++ )
+	{
+		pthread_join( workers[i], NULL );
+	}
+
+	pthread_cond_destroy( &pool.jobDone );
+	pthread_cond_destroy( &pool.jobReady );
+	pthread_mutex_destroy( &pool.lock );
+
+	for ( i = 0; i < pool.slotsLen; i++ )
+	{
+		free( pool.slots[i].in );
+		free( pool.slots[i].out );
+	}
+
+	free( pool.slots );
+	free( workers );
+	free( carry );
+
+	return rc;
+}
@@ -0,0 +1,82 @@
+#ifndef __tcCsv_h__
+#define __tcCsv_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tcCoca.h"
+
+
+
+#define CSV_MAX_COLUMNS 256
+
+
+struct csv_options
+{
+	char                     delimiter;
+
+	uint8_t                  header;        // pass the first line through untouched
+
+	uint8_t                  columns[CSV_MAX_COLUMNS]; // 1 if column n (1-based) holds a TC value
+
+	uint32_t                 lastColumn;    // highest selected column
+
+
+	enum TC_FORMAT           format;
+
+	const rational_t        *editRate;      // NULL if values are frame numbers
+
+	uint8_t                  noRollover;
+
+	uint8_t                  outputFrames;  // rewrite fields as frame numbers instead of hh:mm:ss:ff
+
+	const struct program    *program;
+
+
+	unsigned int             threads;
+
+};
+
+
+/**
+ *	Parses a column list such as "2,5,7" into opts->columns.
+ *	Returns 0 on success, -1 if the list is invalid.
+ */
+
+int csv_set_columns( struct csv_options *opts, const char *list );
+
+
+/**
+ *	Streams a delimited file from in to out, rewriting the selected TC columns
+ *	through opts->program. Every other byte is copied through unchanged, and the
+ *	output keeps the input order whatever the number of threads.
+ *
+ *	Records are lines : quoted fields are supported, but not quoted fields
+ *	spanning several lines.
+ *
+ *	Returns 0 on success, -1 on read / write / allocation error.
+ */
+
+int csv_convert( FILE *in, FILE *out, const struct csv_options *opts );
+
+
+#endif // ! __tcCsv_h__
@@ -0,0 +1,161 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tcCoca.h"
+#include "tcDrifts.h"
+#include "lib/tcDrift.h"
+
+
+
+
+/*
+ *	Returns 0 with the pair of the line, -1 if it holds none.
+ */
+
+static int parseLine( const char *p, enum TC_FORMAT format, uint64_t *unitValue, int32_t *frame )
+{
+	while ( *p == ' ' || *p == '\t' )  p++;
+
+	if ( *p < '0' || *p > '9' )
+	{
+		return -1;
+	}
+
+	uint64_t v = 0;
+
+	while ( *p >= '0' && *p <= '9' )
+	{
+		if ( v > UINT64_MAX / 10 - 9 )
+		{
+			return -1;
+		}
+
+		v = v * 10 + ( *p++ - '0' );
+	}
+
+	if ( *p != ' ' && *p != '\t' && *p != ',' )
+	{
+		return -1;
+	}
+
+	while ( *p == ' ' || *p == '\t' || *p == ',' )  p++;
+
+	uint32_t fields[4];
+
+	unsigned int count = 0;
+
+	while ( *p >= '0' && *p <= '9' )
+	{
+		if ( count == 4 )
+		{
+			return -1;
+		}
+
+		uint32_t f = 0;
+
+		while ( *p >= '0' && *p <= '9' )
+		{
+			f = ( f > 100000000 ) ? UINT32_MAX : f * 10 + ( *p++ - '0' );
+		}
+
+		fields[count++] = f;
+
+		if ( *p == ':' || *p == ';' || *p == '.' )
+		{
+			if ( *++p < '0' || *p > '9' )
+			{
+				return -1;
+			}
+		}
+	}
+
+	while ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' )  p++;
+
+	if ( *p != '\0' )
+	{
+		return -1;
+	}
+
+	*unitValue = v;
+
+	if ( count == 1 && fields[0] <= INT32_MAX )
+	{
+		*frame = (int32_t)fields[0];
+		return 0;
+	}
+
+	if ( count == 4 && fields[0] <= 0xffff && fields[1] <= 0xffff && fields[2] <= 0xffff && fields[3] <= 0xffff )
+	{
+		*frame = tc_hmsf_to_frames( fields[0], fields[1], fields[2], fields[3], format );
+		return 0;
+	}
+
+	return -1;
+}
+
+
+
+
+int drift_estimate( FILE *in, const struct drift_options *opts, FILE *out )
+{
+	struct tc_drift drift;
+
+	if ( tc_drift_init( &drift, opts->format, &opts->unitRate, opts->thresholdPpm ) < 0 )
+	{
+		return -1;
+	}
+
+	char line[256];
+
+	uint64_t skipped = 0;
+
+	while ( fgets( line, sizeof(line), in ) != NULL )
+	{
+		uint64_t unitValue;
+		int32_t  frame;
+
+		if ( parseLine( line, opts->format, &unitValue, &frame ) < 0 )
+		{
+			skipped++;
+			continue;
+		}
+
+		tc_drift_add( &drift, unitValue, frame );
+	}
+
+	struct tc_drift_result r;
+
+	if ( ferror( in ) || tc_drift_get( &drift, &r ) < 0 )
+	{
+		return -1;
+	}
+
+	fprintf( out, "pairs      : %llu (%llu rejected, %llu lines skipped)\n", (unsigned long long)r.count, (unsigned long long)r.rejected, (unsigned long long)skipped );
+	fprintf( out, "frame      : %.6f units (nominal %.6f)\n", r.unitsPerFrame, drift.nominal );
+	fprintf( out, "drift      : %+.3f ppm, %+.2f frames per day%s\n", r.ppm, r.framesPerDay, ( r.drifting ) ? "  DRIFTING" : "" );
+	fprintf( out, "offset     : %.1f units at frame 0\n", r.offset );
+	fprintf( out, "residual   : %.2f units rms\n", r.residual );
+	fprintf( out, "unit rate  : %i/%i\n", r.unitRate.numerator, r.unitRate.denominator );
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef __tcDrifts_h__
+#define __tcDrifts_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lib/libTC.h"
+
+
+
+struct drift_options
+{
+	enum TC_FORMAT  format;
+
+	rational_t      unitRate;      // nominal rate of the unit values, eg. 48000
+
+	double          thresholdPpm;
+
+};
+
+
+/**
+ *	Reads (unit value, timecode) pairs from in, one per line : the unit
+ *	value, then hh:mm:ss:ff or a frame number, separated by blanks or a
+ *	comma. Prints the drift estimate of lib/tcDrift.h to out. Other lines
+ *	are skipped.
+ *
+ *	Returns 0 on success, -1 on read error or with fewer than two frames.
+ */
+
+int drift_estimate( FILE *in, const struct drift_options *opts, FILE *out );
+
+
+#endif // ! __tcDrifts_h__
@@ -0,0 +1,435 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+#include "tcExpr.h"
+
+
+
+struct parser
+{
+	const char       *src;
+	const char       *p;
+
+	enum TC_FORMAT    format;   // format of the running value at this point
+
+	struct program   *prog;
+
+	char             *error;
+	size_t            errorSize;
+
+	int               failed;
+};
+
+
+
+
+static int fail( struct parser *ps, const char *fmt, ... )
+{
+	if ( ps->failed )
+	{
+		return -1;
+	}
+
+	ps->failed = 1;
+
+	if ( ps->error != NULL && ps->errorSize > 0 )
+	{
+		int len = snprintf( ps->error, ps->errorSize, "column %u : ", (unsigned int)( ps->p - ps->src ) + 1 );
+
+		if ( len >= 0 && (size_t)len < ps->errorSize )
+		{
+			va_list args;
+
+			va_start( args, fmt );
+			vsnprintf( ps->error + len, ps->errorSize - len, fmt, args );
+			va_end( args );
+		}
+	}
+
+	return -1;
+}
+
+
+
+
+static void skipSpaces( struct parser *ps )
+{
+	while ( isspace( (unsigned char)*ps->p ) )
+	{
+		ps->p++;
+	}
+}
+
+
+/*
+ *	Keywords (TC, to, as) must not run into the next word.
+ */
+
+static int acceptWord( struct parser *ps, const char *word )
+{
+	size_t len = strlen( word );
+	size_t i   = 0;
+
+	for ( ; i < len; i++ )
+	{
+		if ( tolower( (unsigned char)ps->p[i] ) != tolower( (unsigned char)word[i] ) )
+		{
+			return 0;
+		}
+	}
+
+	if ( isalnum( (unsigned char)ps->p[len] ) )
+	{
+		return 0;
+	}
+
+	ps->p += len;
+
+	return 1;
+}
+
+
+static size_t tokenLength( const char *p )
+{
+	size_t len = 0;
+
+	while ( p[len] != '\0' && !isspace( (unsigned char)p[len] ) && p[len] != '(' && p[len] != ')' && p[len] != '+' )
+	{
+		len++;
+	}
+
+	return len;
+}
+
+
+
+
+static int emit( struct parser *ps, enum OPERATION_TYPE type, enum TC_FORMAT format, int32_t frames )
+{
+	struct program *prog = ps->prog;
+
+	if ( type == OPERATION_STEP )
+	{
+		if ( prog->count > 0 && prog->ops[prog->count-1].type == OPERATION_STEP )
+		{
+			int64_t sum = (int64_t)prog->ops[prog->count-1].frames + frames;
+
+			if ( sum > INT32_MAX || sum < INT32_MIN )
+			{
+				return fail( ps, "frame count out of range" );
+			}
+
+			prog->ops[prog->count-1].frames = (int32_t)sum;
+
+			if ( sum == 0 )
+			{
+				prog->count--;
+			}
+
+			return 0;
+		}
+
+		if ( frames == 0 )
+		{
+			return 0;
+		}
+	}
+
+	if ( prog->count >= PROGRAM_MAX_OPERATIONS )
+	{
+		return fail( ps, "expression too long" );
+	}
+
+	struct operation *op = &prog->ops[prog->count++];
+
+	memset( op, 0x00, sizeof(struct operation) );
+
+	op->type   = type;
+	op->format = format;
+	op->frames = frames;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	value := timecode | frames [f] | unitValue@rate | '(' value { +|- value } ')'
+ */
+
+static int parseValue( struct parser *ps, int64_t *frames )
+{
+	skipSpaces( ps );
+
+	if ( *ps->p == '(' )
+	{
+		ps->p++;
+
+		if ( parseValue( ps, frames ) < 0 )
+			return -1;
+
+		while ( 1 )
+		{
+			skipSpaces( ps );
+
+			if ( *ps->p == ')' )
+			{
+				ps->p++;
+				return 0;
+			}
+
+			int sign = 0;
+
+			if ( *ps->p == '+' )  sign =  1;
+			if ( *ps->p == '-' )  sign = -1;
+
+			if ( sign == 0 )
+				return fail( ps, "expected '+', '-' or ')'" );
+
+			ps->p++;
+
+			int64_t value = 0;
+
+			if ( parseValue( ps, &value ) < 0 )
+				return -1;
+
+			*frames += sign * value;
+
+			if ( *frames > INT32_MAX || *frames < INT32_MIN )
+				return fail( ps, "frame count out of range" );
+		}
+	}
+
+	if ( !isdigit( (unsigned char)*ps->p ) )
+	{
+		return fail( ps, "expected a value" );
+	}
+
+	size_t len = tokenLength( ps->p );
+
+	/* '-' ends a frame count, but is part of nothing else */
+
+	const char *minus = memchr( ps->p, '-', len );
+
+	if ( minus != NULL )
+	{
+		len = minus - ps->p;
+	}
+
+	char token[64];
+
+	if ( len >= sizeof(token) )
+	{
+		return fail( ps, "value too long" );
+	}
+
+	memcpy( token, ps->p, len );
+	token[len] = '\0';
+
+	struct timecode tc;
+
+	memset( &tc, 0x00, sizeof(struct timecode) );
+
+	tc.noRollover = 1;
+
+	char *at = strchr( token, '@' );
+
+	if ( strchr( token, ':' ) != NULL || strchr( token, ';' ) != NULL )
+	{
+		unsigned int h, m, s, f;
+		char         end;
+
+		if ( sscanf( token, "%u%*[:;]%u%*[:;]%u%*[:;.]%u%c", &h, &m, &s, &f, &end ) != 4 )
+			return fail( ps, "wrong timecode \"%s\"", token );
+
+		tc_set_by_string( &tc, token, ps->format );
+	}
+	else if ( at != NULL )
+	{
+		*at = '\0';
+
+		char      *end  = NULL;
+		uint64_t   unit = strtoull( token, &end, 10 );
+		rational_t rate = string_to_rational( at + 1 );
+
+		if ( *end != '\0' || rate.numerator <= 0 || rate.denominator <= 0 )
+			return fail( ps, "wrong unit value \"%s@%s\"", token, at + 1 );
+
+		tc_set_by_unitValue( &tc, unit, &rate, ps->format );
+	}
+	else
+	{
+		char *end = NULL;
+
+		unsigned long long count = strtoull( token, &end, 10 );
+
+		if ( ( *end != '\0' && strcmp( end, "f" ) != 0 ) || count > INT32_MAX )
+			return fail( ps, "wrong frame count \"%s\"", token );
+
+		tc.frameNumber = (int32_t)count;
+	}
+
+	ps->p += len;
+
+	*frames = tc.frameNumber;
+
+	return 0;
+}
+
+
+
+
+static int parseFormat( struct parser *ps, enum TC_FORMAT *format )
+{
+	skipSpaces( ps );
+
+	size_t len = tokenLength( ps->p );
+
+	char token[32];
+
+	if ( len == 0 || len >= sizeof(token) )
+	{
+		return fail( ps, "expected a format" );
+	}
+
+	memcpy( token, ps->p, len );
+	token[len] = '\0';
+
+	*format = string_to_format( token );
+
+	if ( *format == TC_FORMAT_UNK )
+	{
+		return fail( ps, "unsupported format \"%s\"", token );
+	}
+
+	ps->p += len;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	chain := [ TC | '(' chain ')' ] { +|- value | to format | as format }
+ */
+
+static int parseChain( struct parser *ps, int nested )
+{
+	skipSpaces( ps );
+
+	if ( *ps->p == '(' )
+	{
+		ps->p++;
+
+		if ( parseChain( ps, 1 ) < 0 )
+			return -1;
+
+		skipSpaces( ps );
+
+		if ( *ps->p != ')' )
+			return fail( ps, "expected ')'" );
+
+		ps->p++;
+	}
+	else
+	{
+		acceptWord( ps, "TC" );
+	}
+
+	while ( 1 )
+	{
+		skipSpaces( ps );
+
+		if ( *ps->p == '\0' || ( nested && *ps->p == ')' ) )
+		{
+			return 0;
+		}
+
+		enum OPERATION_TYPE type = OPERATION_NONE;
+
+		if ( strncmp( ps->p, "->", 2 ) == 0 )
+		{
+			ps->p += 2;
+			type   = OPERATION_CONVERT;
+		}
+		else if ( acceptWord( ps, "to" ) )
+		{
+			type = OPERATION_CONVERT;
+		}
+		else if ( acceptWord( ps, "as" ) )
+		{
+			type = OPERATION_CONVERT_FRAMES;
+		}
+		else if ( *ps->p == '+' || *ps->p == '-' )
+		{
+			int sign = ( *ps->p++ == '+' ) ? 1 : -1;
+
+			int64_t frames = 0;
+
+			if ( parseValue( ps, &frames ) < 0 || emit( ps, OPERATION_STEP, ps->format, (int32_t)( sign * frames ) ) < 0 )
+				return -1;
+
+			continue;
+		}
+		else
+		{
+			return fail( ps, "expected '+', '-', 'to' or 'as'" );
+		}
+
+		enum TC_FORMAT format = TC_FORMAT_UNK;
+
+		if ( parseFormat( ps, &format ) < 0 || emit( ps, type, format, 0 ) < 0 )
+			return -1;
+
+		ps->format = format;
+	}
+}
+
+
+
+
+int expr_compile( struct program *prog, const char *src, enum TC_FORMAT format, char *error, size_t errorSize )
+{
+	struct parser ps;
+
+	memset( &ps, 0x00, sizeof(struct parser) );
+	memset( prog, 0x00, sizeof(struct program) );
+
+	ps.src       = src;
+	ps.p         = src;
+	ps.format    = format;
+	ps.prog      = prog;
+	ps.error     = error;
+	ps.errorSize = errorSize;
+
+	if ( parseChain( &ps, 0 ) < 0 )
+	{
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef __tcExpr_h__
+#define __tcExpr_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+
+#include "tcCoca.h"
+
+
+
+/*
+ *	Timecode expressions, such as
+ *
+ *	    ( TC + 00:59:58:00 ) to 25 - 120
+ *
+ *	are evaluated left to right from the input value TC (which can be left
+ *	out at the start) :
+ *
+ *	    + <value>, - <value>   add / subtract
+ *	    to <format>            convert, keeping the frame number (-c)
+ *	    as <format>            convert, keeping hh:mm:ss:ff (--convert-frames-to)
+ *
+ *	A value is a timecode hh:mm:ss:ff, a frame count 120 (or 120f), a unit
+ *	value 48000@48000 (value@rate), or a parenthesized sum of those. Values
+ *	are resolved to frames of the format the expression is in at that point.
+ */
+
+
+/**
+ *	Compiles src into prog : a flat list of operations where every constant
+ *	is already a frame count, and consecutive additions are folded into one.
+ *	Returns 0 on success, -1 with a message in error otherwise.
+ */
+
+int expr_compile( struct program *prog, const char *src, enum TC_FORMAT format, char *error, size_t errorSize );
+
+
+#endif // ! __tcExpr_h__
@@ -0,0 +1,310 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcGaps.h"
+#include "lib/tcGap.h"
+
+
+
+/*
+ *	Lines are parsed byte by byte as they come, so nothing is carried between
+ *	two reads, and frame numbers are handed to the detector GAPS_BATCH at a
+ *	time.
+ */
+
+#define GAPS_READ_SIZE  (1024 * 1024)
+#define GAPS_BATCH      (64 * 1024)
+
+
+struct gaps_line
+{
+	uint32_t    fields[4];
+	unsigned    count;       // fields seen
+
+	uint8_t     inField;     // last byte was a digit
+	uint8_t     afterSep;    // last byte was a separator
+	uint8_t     trailing;    // blanks after the value
+	uint8_t     invalid;
+
+};
+
+
+struct gaps_context
+{
+	const struct gaps_options *opts;
+
+	FILE       *out;
+
+	uint64_t    skipped;     // lines which aren't a timecode
+
+};
+
+
+
+
+static void printTC( FILE *out, const struct gaps_options *opts, int32_t frameNumber )
+{
+	struct timecode tc;
+
+	memset( &tc, 0, sizeof(struct timecode) );
+
+	tc.noRollover = opts->noRollover;
+
+	tc_set_by_frames( &tc, (uint32_t)frameNumber, opts->format );
+
+	fprintf( out, "%s", tc.string );
+}
+
+
+static void onEvent( void *user, const struct tc_gap_event *e )
+{
+	struct gaps_context *ctx = user;
+
+	if ( e->kind == TC_GAP_RUN && !ctx->opts->runs )
+	{
+		return;
+	}
+
+	fprintf( ctx->out, "%-14s  #%-10llu  ", tc_gap_kind_string( e->kind ), (unsigned long long)e->index );
+
+	if ( e->kind == TC_GAP_DROP_VIOLATION )
+	{
+		fprintf( ctx->out, "%02u%c%02u%c%02u%c%02u  x %llu\n", e->label[0], TC_SEP, e->label[1], TC_SEP, e->label[2], TC_SEP_DROP, e->label[3], (unsigned long long)e->count );
+		return;
+	}
+
+	printTC( ctx->out, ctx->opts, e->from );
+
+	if ( e->kind == TC_GAP_REPEAT )
+	{
+		fprintf( ctx->out, "  x %llu\n", (unsigned long long)e->count );
+		return;
+	}
+
+	fprintf( ctx->out, " -> " );
+
+	printTC( ctx->out, ctx->opts, e->to );
+
+	if ( e->kind == TC_GAP_RUN )
+	{
+		fprintf( ctx->out, "  %llu frames\n", (unsigned long long)e->count );
+	}
+	else
+	{
+		fprintf( ctx->out, "  %+lli\n", (long long)e->to - e->from );
+	}
+}
+
+
+
+
+/*
+ *	Ends a line : returns 1 with its frame number, 2 for a label drop frame
+ *	skips (in l->fields), 0 for a blank or a wrong one (counted).
+ */
+
+static int endLine( struct gaps_context *ctx, struct gaps_line *l, int32_t *frame )
+{
+	int ok = 0;
+
+	if ( l->count == 0 && !l->invalid )
+	{
+		/* blank */
+	}
+	else if ( l->invalid || l->afterSep )
+	{
+		ctx->skipped++;
+	}
+	else if ( l->count == 1 && l->fields[0] <= INT32_MAX )
+	{
+		*frame = (int32_t)l->fields[0];
+		ok = 1;
+	}
+	else if ( l->count == 4 && l->fields[0] <= 0xffff && l->fields[1] <= 0xffff && l->fields[2] <= 0xffff && l->fields[3] <= 0xffff )
+	{
+		if ( tc_gap_is_dropped( ctx->opts->format, l->fields[1], l->fields[2], l->fields[3] ) )
+		{
+			return 2;  // the caller clears the line
+		}
+
+		*frame = tc_hmsf_to_frames( l->fields[0], l->fields[1], l->fields[2], l->fields[3], ctx->opts->format );
+		ok = 1;
+	}
+	else
+	{
+		ctx->skipped++;
+	}
+
+	memset( l, 0, sizeof(struct gaps_line) );
+
+	return ok;
+}
+
+
+/*
+ *	The frames before a skipped label go first, for the events to keep the
+ *	order of the lines.
+ */
+
+static void feedDropped( struct tc_gap *gap, struct gaps_line *l, int32_t *frames, size_t *n )
+{
+	tc_gap_feed( gap, frames, *n );
+	*n = 0;
+
+	tc_gap_feed_dropped( gap, l->fields[0], l->fields[1], l->fields[2], l->fields[3] );
+
+	memset( l, 0, sizeof(struct gaps_line) );
+}
+
+
+
+
+int gaps_scan( FILE *in, const struct gaps_options *opts, FILE *out )
+{
+	struct gaps_context ctx;
+	struct gaps_line    line;
+	struct tc_gap       gap;
+
+	memset( &ctx,  0, sizeof(struct gaps_context) );
+	memset( &line, 0, sizeof(struct gaps_line) );
+
+	ctx.opts = opts;
+	ctx.out  = out;
+
+	if ( tc_gap_init( &gap, opts->format, ( opts->increment != 0 ) ? opts->increment : 1, onEvent, &ctx ) < 0 )
+	{
+		return -1;
+	}
+
+	char    *buf    = malloc( GAPS_READ_SIZE );
+	int32_t *frames = malloc( GAPS_BATCH * sizeof(int32_t) );
+
+	if ( buf == NULL || frames == NULL )
+	{
+		free( buf );
+		free( frames );
+		return -1;
+	}
+
+	size_t n = 0, len = 0;
+
+	while ( ( len = fread( buf, 1, GAPS_READ_SIZE, in ) ) > 0 )
+	{
+		size_t i = 0;
+
+		for ( ; i < len; i++ )
+		{
+			char c = buf[i];
+
+			if ( c >= '0' && c <= '9' )
+			{
+				if ( !line.inField )
+				{
+					if ( line.count == 4 || line.trailing )
+					{
+						line.invalid = 1;
+						continue;
+					}
+
+					line.fields[line.count++] = 0;
+					line.inField  = 1;
+					line.afterSep = 0;
+				}
+
+				uint32_t *f = &line.fields[line.count-1];
+
+				*f = ( *f > 100000000 ) ? UINT32_MAX : *f * 10 + ( c - '0' );
+			}
+			else if ( c == '\n' )
+			{
+				int r = endLine( &ctx, &line, &frames[n] );
+
+				if ( r == 2 )
+				{
+					feedDropped( &gap, &line, frames, &n );
+				}
+				else if ( r == 1 && ++n == GAPS_BATCH )
+				{
+					tc_gap_feed( &gap, frames, n );
+					n = 0;
+				}
+			}
+			else if ( c == ' ' || c == '\t' || c == '\r' )
+			{
+				if ( line.count > 0 )
+				{
+					line.trailing = 1;
+				}
+
+				line.inField = 0;
+			}
+			else if ( ( c == ':' || c == ';' || c == '.' || c == ',' ) && line.inField && !line.trailing )
+			{
+				line.inField  = 0;
+				line.afterSep = 1;
+			}
+			else
+			{
+				line.invalid = 1;
+			}
+		}
+	}
+
+	int rc = ferror( in ) ? -1 : 0;
+
+	int r = endLine( &ctx, &line, &frames[n] );
+
+	if ( r == 2 )
+	{
+		feedDropped( &gap, &line, frames, &n );
+	}
+	else if ( r == 1 )
+	{
+		n++;
+	}
+
+	tc_gap_feed( &gap, frames, n );
+	tc_gap_finish( &gap );
+
+	fprintf( out, "\n%llu frames : %llu runs, %llu repeats, %llu jumps, %llu backward, %llu rollovers, %llu drop violations",
+	         (unsigned long long)gap.index,
+	         (unsigned long long)gap.counts[TC_GAP_RUN],
+	         (unsigned long long)gap.counts[TC_GAP_REPEAT],
+	         (unsigned long long)gap.counts[TC_GAP_JUMP],
+	         (unsigned long long)gap.counts[TC_GAP_BACKWARD],
+	         (unsigned long long)gap.counts[TC_GAP_ROLLOVER],
+	         (unsigned long long)gap.counts[TC_GAP_DROP_VIOLATION] );
+
+	if ( ctx.skipped > 0 )
+	{
+		fprintf( out, ", %llu lines skipped", (unsigned long long)ctx.skipped );
+	}
+
+	fprintf( out, "\n" );
+
+	free( buf );
+	free( frames );
+
+	return rc;
+}
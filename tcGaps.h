@@ -0,0 +1,56 @@
+#ifndef __tcGaps_h__
+#define __tcGaps_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lib/libTC.h"
+
+
+
+struct gaps_options
+{
+	enum TC_FORMAT  format;
+
+	int32_t         increment;     // expected frames between two lines, usually 1
+
+	uint8_t         noRollover;    // for the timecodes printed
+
+	uint8_t         runs;          // also print the runs, not only what breaks them
+
+};
+
+
+/**
+ *	Reads one timecode per line from in, either hh:mm:ss:ff (any separators)
+ *	or a frame number, and prints the discontinuities of the sequence to out
+ *	(see lib/tcGap.h), then a summary. Lines that are neither are counted and
+ *	skipped, and events are located by their index in the sequence of valid
+ *	lines. Memory use is constant whatever the length of the input.
+ *
+ *	Returns 0 on success, -1 on read error.
+ */
+
+int gaps_scan( FILE *in, const struct gaps_options *opts, FILE *out );
+
+
+#endif // ! __tcGaps_h__
@@ -0,0 +1,226 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcLogs.h"
+#include "lib/tcLog.h"
+
+
+
+#define LOGS_BATCH  4096
+
+
+
+
+/*
+ *	hh:mm:ss:ff or frame number, surrounded by blanks. Returns 0 with its
+ *	frame number, -1 if the line holds neither.
+ */
+
+static int parseLine( const char *p, enum TC_FORMAT format, int32_t *frame )
+{
+	uint32_t fields[4];
+
+	unsigned int count = 0;
+
+	while ( *p == ' ' || *p == '\t' )  p++;
+
+	while ( *p >= '0' && *p <= '9' )
+	{
+		if ( count == 4 )
+		{
+			return -1;
+		}
+
+		uint32_t v = 0;
+
+		while ( *p >= '0' && *p <= '9' )
+		{
+			v = ( v > 100000000 ) ? UINT32_MAX : v * 10 + ( *p++ - '0' );
+		}
+
+		fields[count++] = v;
+
+		if ( *p == ':' || *p == ';' || *p == '.' || *p == ',' )
+		{
+			if ( *++p < '0' || *p > '9' )
+			{
+				return -1;
+			}
+		}
+	}
+
+	while ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' )  p++;
+
+	if ( *p != '\0' )
+	{
+		return -1;
+	}
+
+	if ( count == 1 && fields[0] <= INT32_MAX )
+	{
+		*frame = (int32_t)fields[0];
+		return 0;
+	}
+
+	if ( count == 4 && fields[0] <= 0xffff && fields[1] <= 0xffff && fields[2] <= 0xffff && fields[3] <= 0xffff )
+	{
+		*frame = tc_hmsf_to_frames( fields[0], fields[1], fields[2], fields[3], format );
+		return 0;
+	}
+
+	return -1;
+}
+
+
+
+
+int logs_pack( FILE *in, const char *path, enum TC_FORMAT format, FILE *out )
+{
+	struct tc_log_writer w;
+
+	if ( tc_log_writer_append( &w, path, format, 0 ) < 0 )
+	{
+		return -1;
+	}
+
+	int32_t frames[LOGS_BATCH];
+
+	char line[256];
+
+	size_t n = 0, added = 0, skipped = 0;
+
+	int rc = 0;
+
+	while ( rc == 0 && fgets( line, sizeof(line), in ) != NULL )
+	{
+		if ( parseLine( line, format, &frames[n] ) < 0 )
+		{
+			skipped++;
+			continue;
+		}
+
+		if ( ++n == LOGS_BATCH )
+		{
+			rc = tc_log_write( &w, frames, n );
+
+			added += n;
+			n = 0;
+		}
+	}
+
+	if ( rc == 0 && n > 0 )
+	{
+		rc = tc_log_write( &w, frames, n );
+
+		added += n;
+	}
+
+	if ( tc_log_writer_close( &w ) < 0 || ferror( in ) )
+	{
+		rc = -1;
+	}
+
+	fprintf( out, "%llu frames added, %llu lines skipped\n", (unsigned long long)added, (unsigned long long)skipped );
+
+	return rc;
+}
+
+
+
+
+int logs_find( const char *path, const struct timecode *tc, FILE *out )
+{
+	struct tc_log log;
+
+	if ( tc_log_open( &log, path ) < 0 )
+	{
+		return -1;
+	}
+
+	int64_t index = tc_log_find_tc( &log, tc, 0 );
+
+	while ( index >= 0 )
+	{
+		fprintf( out, "%lld\n", (long long)index );
+
+		index = tc_log_find_tc( &log, tc, index + 1 );
+	}
+
+	tc_log_close( &log );
+
+	return 0;
+}
+
+
+
+
+int logs_dump( const char *path, uint8_t noRollover, FILE *out )
+{
+	struct tc_log log;
+
+	if ( tc_log_open( &log, path ) < 0 )
+	{
+		return -1;
+	}
+
+	int32_t frames[LOGS_BATCH];
+
+	struct timecode tc;
+
+	memset( &tc, 0x00, sizeof(struct timecode) );
+
+	tc.noRollover = noRollover;
+
+	uint64_t index = 0;
+
+	size_t n = 0;
+
+	while ( ( n = tc_log_read( &log, index, frames, LOGS_BATCH ) ) > 0 )
+	{
+		size_t i = 0;
+
+		for ( ; i < n; i++ )
+		{
+			/* the next frame is mostly one step away */
+
+			if ( index + i == 0 )
+			{
+				tc_set_by_frames( &tc, frames[i], log.format );
+			}
+			else
+			{
+				tc_step( &tc, frames[i] - tc.frameNumber );
+			}
+
+			fputs( tc.string, out );
+			fputc( '\n', out );
+		}
+
+		index += n;
+	}
+
+	tc_log_close( &log );
+
+	return ( ferror( out ) ) ? -1 : 0;
+}
@@ -0,0 +1,58 @@
+#ifndef __tcLogs_h__
+#define __tcLogs_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lib/libTC.h"
+
+
+
+/**
+ *	Appends the timecodes of in, one per line as hh:mm:ss:ff (any
+ *	separators) or a frame number, to the log path (see lib/tcLog.h), which
+ *	is created if needed. Other lines are skipped. Prints the number of
+ *	frames added and of lines skipped to out.
+ *
+ *	Returns 0 on success, -1 if the log can't be opened or written.
+ */
+
+int logs_pack( FILE *in, const char *path, enum TC_FORMAT format, FILE *out );
+
+
+/**
+ *	Prints the index of every frame of the log path labeled tc, one per
+ *	line. Returns 0 on success, -1 if the log can't be read.
+ */
+
+int logs_find( const char *path, const struct timecode *tc, FILE *out );
+
+
+/**
+ *	Prints the whole log path, one timecode per line. Returns 0 on success,
+ *	-1 if the log can't be read, or on write error.
+ */
+
+int logs_dump( const char *path, uint8_t noRollover, FILE *out );
+
+
+#endif // ! __tcLogs_h__
@@ -0,0 +1,768 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcPcap.h"
+#include "tcCoca.h"
+#include "lib/tcMap.h"
+#include "lib/tcRational.h"
+
+
+
+#define PCAP_MAX_STREAMS     64
+#define PCAP_MAX_INTERFACES  16
+
+#define LINKTYPE_ETHERNET    1
+#define LINKTYPE_RAW         101
+#define LINKTYPE_LINUX_SLL   113
+#define LINKTYPE_LINUX_SLL2  276
+
+
+/*
+ *	SMPTE ST 12-2, DBB1 payload types of an ATC packet (DID 0x60, SDID 0x60)
+ */
+
+#define ATC_LTC    0x00
+#define ATC_VITC1  0x01
+#define ATC_VITC2  0x02
+
+
+struct pcap_stream
+{
+	uint32_t    ssrc;
+	uint32_t    dstAddr;
+	uint16_t    dstPort;
+	uint8_t     pt;
+
+	rational_t  clock;
+
+	uint64_t    packets;
+
+	uint64_t    firstTicks;     // unwrapped RTP timestamps, TAI
+	uint64_t    lastTicks;
+
+	uint64_t    atcPackets;
+	uint64_t    mismatches;
+	int32_t     offset;         // last ATC - RTP offset, in frames
+
+};
+
+
+struct pcap_iface
+{
+	uint16_t    linktype;
+
+	uint8_t     tsresol;        // if_tsresol option, default 6 (microseconds)
+
+	uint8_t     invalid;        // resolution pcapng_ns() can't scale : packets are ignored
+
+};
+
+
+struct pcap_context
+{
+	const struct pcap_options *opts;
+
+	FILE               *out;
+
+	struct pcap_stream  streams[PCAP_MAX_STREAMS];
+	unsigned int        streamsLen;
+	unsigned int        lastStream;
+
+	uint64_t            packets;
+	uint64_t            rtpPackets;
+
+};
+
+
+
+
+static inline uint16_t rd16be( const uint8_t *p ) { return ( p[0] << 8 ) | p[1]; }
+static inline uint32_t rd32be( const uint8_t *p ) { return ( (uint32_t)p[0] << 24 ) | ( p[1] << 16 ) | ( p[2] << 8 ) | p[3]; }
+
+static inline uint16_t rd16( const uint8_t *p, int swap ) { return ( swap ) ? rd16be( p ) : (uint16_t)( p[0] | ( p[1] << 8 ) ); }
+static inline uint32_t rd32( const uint8_t *p, int swap ) { return ( swap ) ? rd32be( p ) : ( p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t)p[3] << 24 ) ); }
+
+
+
+
+static uint32_t get_bits( const uint8_t *data, size_t bitpos, unsigned int n )
+{
+	uint32_t v = 0;
+
+	while ( n-- > 0 )
+	{
+		v = ( v << 1 ) | ( ( data[bitpos >> 3] >> ( 7 - ( bitpos & 7 ) ) ) & 1 );
+		bitpos++;
+	}
+
+	return v;
+}
+
+
+
+
+static void format_ns( char *buf, size_t size, uint64_t ns )
+{
+	snprintf( buf, size, "%llu.%09llu", (unsigned long long)( ns / 1000000000 ), (unsigned long long)( ns % 1000000000 ) );
+}
+
+
+
+
+/*
+ *	Returns the UDP payload of a captured frame, or NULL if it isn't one.
+ */
+
+static const uint8_t * udp_payload( uint16_t linktype, const uint8_t *data, size_t len, size_t *payloadLen, uint32_t *dstAddr, uint16_t *dstPort )
+{
+	uint16_t ethertype = 0;
+
+	switch ( linktype )
+	{
+		case LINKTYPE_ETHERNET:
+
+			if ( len < 14 )
+				return NULL;
+
+			ethertype = rd16be( data + 12 );
+			data += 14;
+			len  -= 14;
+
+			while ( ( ethertype == 0x8100 || ethertype == 0x88a8 ) && len >= 4 )
+			{
+				ethertype = rd16be( data + 2 );
+				data += 4;
+				len  -= 4;
+			}
+
+			break;
+
+		case LINKTYPE_LINUX_SLL:
+
+			if ( len < 16 )
+				return NULL;
+
+			ethertype = rd16be( data + 14 );
+			data += 16;
+			len  -= 16;
+			break;
+
+		case LINKTYPE_LINUX_SLL2:
+
+			if ( len < 20 )
+				return NULL;
+
+			ethertype = rd16be( data );
+			data += 20;
+			len  -= 20;
+			break;
+
+		case LINKTYPE_RAW:
+
+			if ( len < 1 )
+				return NULL;
+
+			ethertype = ( ( data[0] >> 4 ) == 6 ) ? 0x86dd : 0x0800;
+			break;
+
+		default:
+			return NULL;
+	}
+
+
+	*dstAddr = 0;
+
+	if ( ethertype == 0x0800 )
+	{
+		if ( len < 20 || ( data[0] >> 4 ) != 4 || data[9] != 17 )
+			return NULL;
+
+		if ( rd16be( data + 6 ) & 0x3fff )
+			return NULL;   // fragment
+
+		size_t ihl = ( data[0] & 0x0f ) * 4;
+
+		if ( ihl < 20 || len < ihl + 8 )
+			return NULL;
+
+		*dstAddr = rd32be( data + 16 );
+
+		data += ihl;
+		len  -= ihl;
+	}
+	else if ( ethertype == 0x86dd )
+	{
+		if ( len < 48 || data[6] != 17 )
+			return NULL;
+
+		data += 40;
+		len  -= 40;
+	}
+	else
+	{
+		return NULL;
+	}
+
+	size_t udpLen = rd16be( data + 4 );
+
+	if ( udpLen < 8 || udpLen > len )
+		udpLen = len;   // truncated capture, keep what we have
+
+	*dstPort    = rd16be( data + 2 );
+	*payloadLen = udpLen - 8;
+
+	return data + 8;
+}
+
+
+
+
+static struct pcap_stream * get_stream( struct pcap_context *ctx, uint32_t ssrc, uint8_t pt, uint32_t dstAddr, uint16_t dstPort )
+{
+	struct pcap_stream *s = &ctx->streams[ctx->lastStream];
+
+	if ( ctx->streamsLen > 0 && s->ssrc == ssrc && s->pt == pt && s->dstPort == dstPort && s->dstAddr == dstAddr )
+	{
+		return s;
+	}
+
+	unsigned int i = 0;
+
+	for ( ; i < ctx->streamsLen; i++ )
+	{
+		s = &ctx->streams[i];
+
+		if ( s->ssrc == ssrc && s->pt == pt && s->dstPort == dstPort && s->dstAddr == dstAddr )
+		{
+			ctx->lastStream = i;
+			return s;
+		}
+	}
+
+	if ( ctx->streamsLen == PCAP_MAX_STREAMS )
+	{
+		return NULL;
+	}
+
+	s = &ctx->streams[ctx->streamsLen];
+
+	memset( s, 0x00, sizeof(struct pcap_stream) );
+
+	s->ssrc    = ssrc;
+	s->pt      = pt;
+	s->dstAddr = dstAddr;
+	s->dstPort = dstPort;
+
+	s->clock.numerator   = ( ctx->opts->audioPT[pt] ) ? 48000 : 90000;
+	s->clock.denominator = 1;
+
+	ctx->lastStream = ctx->streamsLen++;
+
+	return s;
+}
+
+
+
+
+/*
+ *	Maps unwrapped TAI ticks to a time of day timecode.
+ */
+
+static void ticks_to_tc( const struct pcap_context *ctx, const struct pcap_stream *s, uint64_t ticks, struct timecode *tc )
+{
+	uint64_t rate = s->clock.numerator;
+	uint64_t utc  = ticks - (int64_t)ctx->opts->taiOffset * rate;
+
+	tc->noRollover = 0;
+
+	tc_set_by_unitValue( tc, utc % ( 86400 * rate ), (rational_t*)&s->clock, ctx->opts->format );
+}
+
+
+
+
+/*
+ *	RFC 8331 payload : walks the ANC packets and checks every ATC timecode
+ *	(SMPTE ST 12-2) against the one derived from the RTP timestamp.
+ */
+
+static void parse_anc( struct pcap_context *ctx, struct pcap_stream *s, uint64_t ticks, uint64_t captureNs, const uint8_t *data, size_t len )
+{
+	if ( len < 8 )
+	{
+		return;
+	}
+
+	unsigned int ancCount = data[4];
+
+	size_t bitpos = 64;
+	size_t bitlen = len * 8;
+
+	struct timecode rtp;
+	int             rtpSet = 0;
+
+	while ( ancCount-- > 0 && bitpos + 32 + 30 <= bitlen )
+	{
+		bitpos += 32;   // C, Line_Number, Horizontal_Offset, S, StreamNum
+
+		uint32_t did       = get_bits( data, bitpos,      10 ) & 0xff;
+		uint32_t sdid      = get_bits( data, bitpos + 10, 10 ) & 0xff;
+		uint32_t dataCount = get_bits( data, bitpos + 20, 10 ) & 0xff;
+
+		bitpos += 30;
+
+		if ( bitpos + ( dataCount + 1 ) * 10 > bitlen )
+		{
+			return;
+		}
+
+		if ( did == 0x60 && sdid == 0x60 && dataCount == 16 )
+		{
+			uint8_t  udw[16];
+			uint64_t word = 0;
+			uint8_t  dbb1 = 0;
+
+			unsigned int i = 0;
+
+			for ( ; i < 16; i++ )
+			{
+				udw[i] = get_bits( data, bitpos + i * 10, 10 ) & 0xff;
+
+				word |= (uint64_t)( udw[i] >> 4 ) << ( i * 4 );
+			}
+
+			for ( i = 0; i < 8; i++ )
+			{
+				dbb1 |= ( ( udw[i] >> 3 ) & 1 ) << i;
+			}
+
+			if ( dbb1 == ATC_LTC || dbb1 == ATC_VITC1 || dbb1 == ATC_VITC2 )
+			{
+				uint16_t frames  = ( ( word >> 8  ) & 0x3 ) * 10 + ( ( word       ) & 0xf );
+				uint16_t seconds = ( ( word >> 24 ) & 0x7 ) * 10 + ( ( word >> 16 ) & 0xf );
+				uint16_t minutes = ( ( word >> 40 ) & 0x7 ) * 10 + ( ( word >> 32 ) & 0xf );
+				uint16_t hours   = ( ( word >> 56 ) & 0x3 ) * 10 + ( ( word >> 48 ) & 0xf );
+
+				/*
+				 *	Above 30 fps the frame counter holds frame pairs, VITC2
+				 *	marking the second frame of the pair.
+				 */
+
+				if ( tc_format_fps( ctx->opts->format ) > 30 )
+				{
+					frames = frames * 2 + ( dbb1 == ATC_VITC2 );
+				}
+
+				struct timecode atc;
+
+				memset( &atc, 0x00, sizeof(struct timecode) );
+
+				tc_set_by_hmsf( &atc, hours, minutes, seconds, frames, ctx->opts->format );
+
+				if ( rtpSet == 0 )
+				{
+					memset( &rtp, 0x00, sizeof(struct timecode) );
+
+					ticks_to_tc( ctx, s, ticks, &rtp );
+
+					rtpSet = 1;
+				}
+
+				int32_t offset = atc.frameNumber - rtp.frameNumber;
+
+				s->atcPackets++;
+
+				if ( offset != 0 )
+				{
+					s->mismatches++;
+				}
+
+				if ( offset != s->offset || s->atcPackets == 1 )
+				{
+					char when[32];
+
+					format_ns( when, sizeof(when), captureNs );
+
+					fprintf( ctx->out, "%s  ssrc 0x%08x  %-9s %s  rtp %s  offset %+i frame(s)\n",
+					         when, s->ssrc,
+					         ( dbb1 == ATC_LTC ) ? "ATC_LTC" : ( dbb1 == ATC_VITC1 ) ? "ATC_VITC1" : "ATC_VITC2",
+					         atc.string, rtp.string, offset );
+
+					s->offset = offset;
+				}
+			}
+		}
+
+		bitpos += ( dataCount + 1 ) * 10;   // user data words and checksum
+		bitpos  = ( bitpos + 31 ) & ~(size_t)31;
+	}
+}
+
+
+
+
+static void parse_packet( struct pcap_context *ctx, uint16_t linktype, uint64_t captureNs, const uint8_t *data, size_t len )
+{
+	size_t   rtpLen  = 0;
+	uint32_t dstAddr = 0;
+	uint16_t dstPort = 0;
+
+	ctx->packets++;
+
+	const uint8_t *rtpData = udp_payload( linktype, data, len, &rtpLen, &dstAddr, &dstPort );
+
+	if ( rtpData == NULL || rtpLen < 12 || ( rtpData[0] >> 6 ) != 2 )
+	{
+		return;
+	}
+
+	size_t hdrLen = 12 + ( rtpData[0] & 0x0f ) * 4;
+
+	if ( ( rtpData[0] & 0x10 ) && rtpLen >= hdrLen + 4 )
+	{
+		hdrLen += 4 + rd16be( rtpData + hdrLen + 2 ) * 4;
+	}
+
+	if ( rtpLen < hdrLen )
+	{
+		return;
+	}
+
+	if ( rtpData[0] & 0x20 )
+	{
+		/* padding : its last byte counts it, and it can't eat the header */
+
+		uint8_t pad = rtpData[rtpLen-1];
+
+		if ( pad == 0 || pad > rtpLen - hdrLen )
+		{
+			return;
+		}
+
+		rtpLen -= pad;
+	}
+
+	uint8_t  pt   = rtpData[1] & 0x7f;
+	uint32_t ts   = rd32be( rtpData + 4 );
+	uint32_t ssrc = rd32be( rtpData + 8 );
+
+	struct pcap_stream *s = get_stream( ctx, ssrc, pt, dstAddr, dstPort );
+
+	if ( s == NULL )
+	{
+		return;
+	}
+
+	ctx->rtpPackets++;
+
+
+	/*
+	 *	SMPTE ST 2110-10 : the RTP timestamp is the PTP time (TAI, SMPTE epoch)
+	 *	at the media clock rate, modulo 2^32. The capture time gives the upper
+	 *	bits back : keep the value congruent to ts nearest to it.
+	 */
+
+	uint64_t taiNs    = captureNs + (int64_t)ctx->opts->taiOffset * 1000000000;
+	uint64_t expected = tc_muldiv( taiNs, s->clock.numerator, (uint64_t)s->clock.denominator * 1000000000, 0 );
+	uint64_t ticks    = expected + (int32_t)( ts - (uint32_t)expected );
+
+	if ( s->packets == 0 )
+	{
+		s->firstTicks = ticks;
+	}
+
+	s->lastTicks = ticks;
+	s->packets++;
+
+	if ( ctx->opts->ancPT[pt] )
+	{
+		parse_anc( ctx, s, ticks, captureNs, rtpData + hdrLen, rtpLen - hdrLen );
+	}
+}
+
+
+
+
+static int walk_pcap( struct pcap_context *ctx, const uint8_t *data, size_t size )
+{
+	uint32_t magic = rd32( data, 0 );
+
+	int swap = 0;
+	int nano = 0;
+
+	switch ( magic )
+	{
+		case 0xa1b2c3d4:  swap = 0;  nano = 0;  break;
+		case 0xd4c3b2a1:  swap = 1;  nano = 0;  break;
+		case 0xa1b23c4d:  swap = 0;  nano = 1;  break;
+		case 0x4d3cb2a1:  swap = 1;  nano = 1;  break;
+		default:          return -1;
+	}
+
+	if ( size < 24 )
+	{
+		return -1;
+	}
+
+	uint16_t linktype = rd32( data + 20, swap ) & 0xffff;
+
+	size_t pos = 24;
+
+	while ( pos + 16 <= size )
+	{
+		uint64_t sec  = rd32( data + pos,      swap );
+		uint64_t frac = rd32( data + pos + 4,  swap );
+		size_t   len  = rd32( data + pos + 8,  swap );
+
+		pos += 16;
+
+		if ( len > size - pos )
+		{
+			break;
+		}
+
+		parse_packet( ctx, linktype, sec * 1000000000 + ( ( nano ) ? frac : frac * 1000 ), data + pos, len );
+
+		pos += len;
+	}
+
+	return 0;
+}
+
+
+
+
+static uint64_t pcapng_ns( const struct pcap_iface *iface, uint64_t ts )
+{
+	uint8_t res = iface->tsresol;
+
+	if ( res & 0x80 )
+	{
+		return tc_muldiv( ts, 1000000000, 1ULL << ( res & 0x7f ), 0 );
+	}
+
+	uint64_t scale = 1;
+
+	if ( res <= 9 )
+	{
+		while ( res++ < 9 )
+			scale *= 10;
+
+		return ts * scale;
+	}
+
+	while ( res-- > 9 )
+		scale *= 10;
+
+	return ts / scale;
+}
+
+
+
+
+static int walk_pcapng( struct pcap_context *ctx, const uint8_t *data, size_t size )
+{
+	struct pcap_iface ifaces[PCAP_MAX_INTERFACES];
+	unsigned int      ifacesLen = 0;
+
+	int swap = 0;
+
+	size_t pos = 0;
+
+	while ( pos + 12 <= size )
+	{
+		uint32_t type = rd32( data + pos, swap );
+
+		if ( type == 0x0a0d0d0a )
+		{
+			/* section header : byte order may change, interfaces restart */
+
+			uint32_t bom = rd32( data + pos + 8, 0 );
+
+			if ( bom == 0x1a2b3c4d )
+				swap = 0;
+			else if ( bom == 0x4d3c2b1a )
+				swap = 1;
+			else
+				return -1;
+
+			ifacesLen = 0;
+		}
+
+		uint32_t len = rd32( data + pos + 4, swap );
+
+		if ( len < 12 || len > size - pos )
+		{
+			break;
+		}
+
+		const uint8_t *body    = data + pos + 8;
+		size_t         bodyLen = len - 12;
+
+		if ( type == 0x00000001 && bodyLen >= 8 && ifacesLen < PCAP_MAX_INTERFACES )
+		{
+			struct pcap_iface *iface = &ifaces[ifacesLen++];
+
+			iface->linktype = rd16( body, swap );
+			iface->tsresol  = 6;
+
+			size_t opt = 8;
+
+			while ( opt + 4 <= bodyLen )
+			{
+				uint16_t code   = rd16( body + opt,     swap );
+				uint16_t optLen = rd16( body + opt + 2, swap );
+
+				if ( code == 0 )
+					break;
+
+				if ( code == 9 && optLen >= 1 && opt + 5 <= bodyLen )
+					iface->tsresol = body[opt + 4];
+
+				opt += 4 + ( ( optLen + 3 ) & ~3 );
+			}
+
+			/* 2^-64 s and finer don't shift, 10^-20 s and finer overflow the scale */
+
+			iface->invalid = ( iface->tsresol & 0x80 ) ? ( ( iface->tsresol & 0x7f ) >= 64 ) : ( iface->tsresol > 19 );
+		}
+		else if ( type == 0x00000006 && bodyLen >= 20 )
+		{
+			uint32_t id     = rd32( body,      swap );
+			uint64_t ts     = ( (uint64_t)rd32( body + 4, swap ) << 32 ) | rd32( body + 8, swap );
+			size_t   capLen = rd32( body + 12, swap );
+
+			if ( id < ifacesLen && !ifaces[id].invalid && capLen <= bodyLen - 20 )
+			{
+				parse_packet( ctx, ifaces[id].linktype, pcapng_ns( &ifaces[id], ts ), body + 20, capLen );
+			}
+		}
+
+		pos += len;
+	}
+
+	return 0;
+}
+
+
+
+
+int pcap_set_payload_types( uint8_t pt[128], const char *list )
+{
+	while ( *list != '\0' )
+	{
+		char *end = NULL;
+
+		long v = strtol( list, &end, 10 );
+
+		if ( end == list || v < 0 || v > 127 || ( *end != ',' && *end != '\0' ) )
+		{
+			return -1;
+		}
+
+		pt[v] = 1;
+
+		list = ( *end == ',' ) ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+
+
+
+int pcap_analyze( const char *path, const struct pcap_options *opts, FILE *out )
+{
+	struct tc_map map;
+
+	if ( tc_map_open( &map, path ) < 0 )
+	{
+		fprintf( stderr, "Could not open \"%s\".\n", path );
+		return -1;
+	}
+
+	struct pcap_context *ctx = calloc( 1, sizeof(struct pcap_context) );
+
+	if ( ctx == NULL )
+	{
+		tc_map_close( &map );
+		return -1;
+	}
+
+	ctx->opts = opts;
+	ctx->out  = out;
+
+	int rc = -1;
+
+	if ( map.size >= 4 )
+	{
+		rc = ( rd32( map.data, 0 ) == 0x0a0d0d0a ) ? walk_pcapng( ctx, map.data, map.size )
+		                                           : walk_pcap( ctx, map.data, map.size );
+	}
+
+	if ( rc < 0 )
+	{
+		fprintf( stderr, "\"%s\" is not a pcap / pcapng capture.\n", path );
+	}
+	else
+	{
+		fprintf( out, "\n%llu packets, %llu RTP\n\n", (unsigned long long)ctx->packets, (unsigned long long)ctx->rtpPackets );
+
+		unsigned int i = 0;
+
+		for ( ; i < ctx->streamsLen; i++ )
+		{
+			struct pcap_stream *s = &ctx->streams[i];
+
+			struct timecode first;
+			struct timecode last;
+
+			memset( &first, 0x00, sizeof(struct timecode) );
+			memset( &last,  0x00, sizeof(struct timecode) );
+
+			ticks_to_tc( ctx, s, s->firstTicks, &first );
+			ticks_to_tc( ctx, s, s->lastTicks,  &last );
+
+			fprintf( out, "ssrc 0x%08x  pt %3u  %u.%u.%u.%u:%u  %5i Hz  %10llu packets  %s -> %s",
+			         s->ssrc, s->pt,
+			         s->dstAddr >> 24, ( s->dstAddr >> 16 ) & 0xff, ( s->dstAddr >> 8 ) & 0xff, s->dstAddr & 0xff, s->dstPort,
+			         s->clock.numerator,
+			         (unsigned long long)s->packets,
+			         first.string, last.string );
+
+			if ( opts->ancPT[s->pt] )
+			{
+				fprintf( out, "  ATC %llu, mismatches %llu", (unsigned long long)s->atcPackets, (unsigned long long)s->mismatches );
+			}
+
+			fprintf( out, "\n" );
+		}
+	}
+
+	free( ctx );
+
+	tc_map_close( &map );
+
+	return rc;
+}
@@ -0,0 +1,67 @@
+#ifndef __tcPcap_h__
+#define __tcPcap_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lib/libTC.h"
+
+
+
+struct pcap_options
+{
+	enum TC_FORMAT  format;
+
+	uint8_t         audioPT[128];  // 1 if the RTP payload type is ST 2110-30 audio (48 kHz clock)
+
+	uint8_t         ancPT[128];    // 1 if the RTP payload type is ST 2110-40 ANC
+
+	int32_t         taiOffset;     // TAI - UTC, in seconds
+
+};
+
+
+/**
+ *	Parses a payload type list such as "97,98" into pt[].
+ *	Returns 0 on success, -1 if the list is invalid.
+ */
+
+int pcap_set_payload_types( uint8_t pt[128], const char *list );
+
+
+/**
+ *	Walks a pcap or pcapng capture of ST 2110 streams.
+ *
+ *	Every RTP timestamp is unwrapped against the capture time, converted from
+ *	PTP (TAI) to time of day and mapped to a timecode of opts->format with
+ *	tc_set_by_unitValue(). Streams carrying ST 291 ANC packets (RFC 8331) also
+ *	get their ATC_LTC / ATC_VITC timecodes (SMPTE ST 12-2) decoded and checked
+ *	against the RTP derived value : every change of offset between the two
+ *	is printed to out, then a summary per stream.
+ *
+ *	Returns 0 on success, -1 if the file can't be read or isn't a capture.
+ */
+
+int pcap_analyze( const char *path, const struct pcap_options *opts, FILE *out );
+
+
+#endif // ! __tcPcap_h__
@@ -0,0 +1,78 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tcScan.h"
+#include "lib/tcMedia.h"
+
+
+
+static const char *MEDIA_TYPE_STR[] = { "unknown", "mxf", "mov", "bwf" };
+
+
+struct scan_context
+{
+	const struct scan_options *opts;
+
+	FILE                      *out;
+
+};
+
+
+/* called one file at a time */
+
+static void onFile( void *user, const char *path, int rc, const struct tc_media_info *info )
+{
+	struct scan_context *ctx = user;
+
+	struct timecode tc;
+
+	memset( &tc, 0x00, sizeof(struct timecode) );
+
+	tc.noRollover = ctx->opts->noRollover;
+
+	if ( rc < 0 || tc_media_get( info, ctx->opts->format, &tc ) < 0 )
+	{
+		return;
+	}
+
+	if ( apply_program( ctx->opts->program, &tc ) < 0 )
+	{
+		fprintf( stderr, "Could not apply the operation to %s, a %s timecode (%s).\n", tc.string, TC_FORMAT_STR[tc.format], path );
+		return;
+	}
+
+	fprintf( ctx->out, "%s\t%s\t%s\t%s\n", tc.string, TC_FORMAT_STR[tc.format], MEDIA_TYPE_STR[info->type], path );
+}
+
+
+
+
+int scan_media( const char *path, const struct scan_options *opts, FILE *out )
+{
+	struct scan_context ctx;
+
+	ctx.opts = opts;
+	ctx.out  = out;
+
+	return tc_media_scan( path, opts->threads, onFile, &ctx );
+}
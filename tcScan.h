@@ -0,0 +1,55 @@
+#ifndef __tcScan_h__
+#define __tcScan_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tcCoca.h"
+
+
+
+struct scan_options
+{
+	enum TC_FORMAT           format;      // for files that don't tell their rate (BWF)
+
+	unsigned int             threads;
+
+	uint8_t                  noRollover;
+
+	const struct program    *program;
+
+};
+
+
+/**
+ *	Prints the start timecode of the MXF, QuickTime and BWF files under path
+ *	(see lib/tcMedia.h) through opts->program, one line per file : timecode,
+ *	format, media type and path, tab separated, in no particular order.
+ *	Other files are skipped.
+ *
+ *	Returns 0 on success, -1 if path can't be opened.
+ */
+
+int scan_media( const char *path, const struct scan_options *opts, FILE *out );
+
+
+#endif // ! __tcScan_h__
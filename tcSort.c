@@ -0,0 +1,431 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcSort.h"
+#include "lib/tcMap.h"
+#include "lib/tcArray.h"
+#include "lib/tcRadix.h"
+
+
+
+#define SORT_BUFFER_SIZE  (1024 * 1024)
+
+
+struct writer
+{
+	FILE       *out;
+
+	char       *buffer;
+	size_t      len;
+
+	int         error;
+
+};
+
+
+static void flush( struct writer *w )
+{
+	if ( w->len > 0 && fwrite( w->buffer, 1, w->len, w->out ) != w->len )
+	{
+		w->error = 1;
+	}
+
+	w->len = 0;
+}
+
+
+static void emit( struct writer *w, const char *data, size_t len )
+{
+	if ( w->len + len > SORT_BUFFER_SIZE )
+	{
+		flush( w );
+
+		if ( len > SORT_BUFFER_SIZE )
+		{
+			if ( fwrite( data, 1, len, w->out ) != len )
+			{
+				w->error = 1;
+			}
+
+			return;
+		}
+	}
+
+	memcpy( w->buffer + w->len, data, len );
+	w->len += len;
+}
+
+
+
+
+/*
+ *	stdin can't be mapped : it is read whole into a buffer the map then owns.
+ */
+
+static int readInput( struct tc_map *map, const char *path )
+{
+	if ( strcmp( path, "-" ) != 0 )
+	{
+		return tc_map_open( map, path );
+	}
+
+	memset( map, 0x00, sizeof(struct tc_map) );
+
+	size_t size = 0, len = 0;
+
+	uint8_t *data = NULL;
+
+	for ( ;; )
+	{
+		if ( len == size )
+		{
+			size = ( size > 0 ) ? size * 2 : SORT_BUFFER_SIZE;
+
+			uint8_t *grown = realloc( data, size );
+
+			if ( grown == NULL )
+			{
+				free( data );
+				return -1;
+			}
+
+			data = grown;
+		}
+
+		size_t n = fread( data + len, 1, size - len, stdin );
+
+		if ( n == 0 )
+		{
+			break;
+		}
+
+		len += n;
+	}
+
+	if ( ferror( stdin ) )
+	{
+		free( data );
+		return -1;
+	}
+
+	map->data = data;
+	map->size = len;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	Field column (1-based) of the line [p, end), as hh:mm:ss:ff or a frame
+ *	number. Returns 0 with its frame number, -1 if it holds neither.
+ */
+
+static int parseField( const char *p, const char *end, const struct sort_options *opts, int32_t *frame )
+{
+	unsigned int column = 1;
+
+	for ( ; column < opts->column; column++ )
+	{
+		p = memchr( p, opts->delimiter, end - p );
+
+		if ( p == NULL )
+		{
+			return -1;
+		}
+
+		p++;
+	}
+
+	const char *fieldEnd = memchr( p, opts->delimiter, end - p );
+
+	if ( fieldEnd == NULL )
+	{
+		fieldEnd = end;
+	}
+
+	while ( p < fieldEnd && ( *p == ' ' || *p == '\t' || *p == '"' ) )  p++;
+	while ( fieldEnd > p && ( fieldEnd[-1] == ' ' || fieldEnd[-1] == '\t' || fieldEnd[-1] == '\r' || fieldEnd[-1] == '"' ) )  fieldEnd--;
+
+	uint32_t fields[4];
+
+	unsigned int count = 0;
+
+	while ( p < fieldEnd )
+	{
+		if ( count == 4 || *p < '0' || *p > '9' )
+		{
+			return -1;
+		}
+
+		uint32_t v = 0;
+
+		while ( p < fieldEnd && *p >= '0' && *p <= '9' )
+		{
+			uint32_t digit = *p++ - '0';
+
+			v = ( v > 100000000 ) ? UINT32_MAX : v * 10 + digit;
+		}
+
+		fields[count++] = v;
+
+		if ( p < fieldEnd )
+		{
+			if ( *p != ':' && *p != ';' && *p != '.' && *p != ',' )
+			{
+				return -1;
+			}
+
+			if ( ++p == fieldEnd )
+			{
+				return -1;
+			}
+		}
+	}
+
+	if ( count == 1 && fields[0] <= INT32_MAX )
+	{
+		*frame = (int32_t)fields[0];
+		return 0;
+	}
+
+	if ( count == 4 && fields[0] <= 0xffff && fields[1] <= 0xffff && fields[2] <= 0xffff && fields[3] <= 0xffff )
+	{
+		*frame = tc_hmsf_to_frames( fields[0], fields[1], fields[2], fields[3], opts->format );
+		return 0;
+	}
+
+	return -1;
+}
+
+
+
+
+static void emitLine( struct writer *w, const char *data, const size_t *starts, size_t line )
+{
+	size_t len = starts[line+1] - starts[line];
+
+	emit( w, data + starts[line], len );
+
+	if ( len == 0 || data[ starts[line] + len - 1 ] != '\n' )
+	{
+		emit( w, "\n", 1 );
+	}
+}
+
+
+static void emitRange( struct writer *w, const struct tc_array *array, const struct tc_radix_range *range )
+{
+	struct timecode tc;
+
+	char   line[96];
+	size_t len = 0;
+
+	tc_array_get( array, range->firstRow, &tc );
+	len += snprintf( line + len, sizeof(line) - len, "%s\t", tc.string );
+
+	tc_array_get( array, range->lastRow, &tc );
+	len += snprintf( line + len, sizeof(line) - len, "%s\t%llu\n", tc.string, (unsigned long long)range->count );
+
+	emit( w, line, len );
+}
+
+
+
+
+int sort_lines( const char *path, const struct sort_options *opts, FILE *out )
+{
+	struct tc_map map;
+
+	if ( readInput( &map, path ) < 0 )
+	{
+		return -1;
+	}
+
+	const char *data = (const char *)map.data;
+
+
+	/* line starts, plus the end of the last line */
+
+	size_t lines = 0;
+
+	const char *p   = data;
+	const char *end = data + map.size;
+
+	while ( p < end && ( p = memchr( p, '\n', end - p ) ) != NULL )
+	{
+		lines++;
+		p++;
+	}
+
+	if ( map.size > 0 && data[map.size-1] != '\n' )
+	{
+		lines++;
+	}
+
+	if ( lines >= UINT32_MAX )
+	{
+		tc_map_close( &map );
+		return -1;
+	}
+
+
+	struct tc_arena arena;
+	struct tc_array array;
+
+	tc_arena_init( &arena, 0 );
+
+	size_t   *starts  = tc_arena_alloc( &arena, ( lines + 1 ) * sizeof(size_t) );
+	uint32_t *lineOf  = tc_arena_alloc( &arena, ( lines + 1 ) * sizeof(uint32_t) );   // line of value i
+	uint32_t *invalid = tc_arena_alloc( &arena, ( lines + 1 ) * sizeof(uint32_t) );
+	uint64_t *keys    = tc_arena_alloc( &arena, ( lines + 1 ) * sizeof(uint64_t) );
+	uint32_t *rows    = tc_arena_alloc( &arena, ( lines + 1 ) * sizeof(uint32_t) );
+
+	struct writer w;
+
+	memset( &w, 0x00, sizeof(struct writer) );
+
+	w.out    = out;
+	w.buffer = malloc( SORT_BUFFER_SIZE );
+
+	if ( starts == NULL || lineOf == NULL || invalid == NULL || keys == NULL || rows == NULL || w.buffer == NULL ||
+	     tc_array_init( &array, &arena, lines + 1 ) < 0 )
+	{
+		free( w.buffer );
+		tc_arena_release( &arena );
+		tc_map_close( &map );
+		return -1;
+	}
+
+	array.noRollover = opts->noRollover;
+
+
+	size_t line = 0, valid = 0, invalids = 0;
+
+	for ( p = data; line < lines; line++ )
+	{
+		const char *eol = memchr( p, '\n', end - p );
+
+		if ( eol == NULL )
+		{
+			eol = end;
+		}
+
+		starts[line] = p - data;
+
+		if ( line == 0 && opts->header )
+		{
+			/* passed through */
+		}
+		else if ( parseField( p, eol, opts, &array.frames[valid] ) == 0 )
+		{
+			lineOf[valid++] = line;
+		}
+		else
+		{
+			invalid[invalids++] = line;
+		}
+
+		p = ( eol < end ) ? eol + 1 : end;
+	}
+
+	starts[lines] = map.size;
+
+	memset( array.formats, opts->format, valid );
+
+	array.count = valid;
+
+
+	tc_radix_keys( &array, keys, !opts->noRollover );
+
+	size_t i = 0;
+
+	for ( ; i < valid; i++ )
+	{
+		rows[i] = i;
+	}
+
+	int rc = tc_radix_sort( keys, rows, valid, opts->threads );
+
+
+	if ( rc == 0 )
+	{
+		if ( opts->header && lines > 0 )
+		{
+			emitLine( &w, data, starts, 0 );
+		}
+
+		if ( opts->output == SORT_LINES )
+		{
+			for ( i = 0; i < valid; i++ )
+			{
+				emitLine( &w, data, starts, lineOf[ rows[i] ] );
+			}
+
+			for ( i = 0; i < invalids; i++ )
+			{
+				emitLine( &w, data, starts, invalid[i] );
+			}
+		}
+		else if ( opts->output == SORT_UNIQUE )
+		{
+			size_t n = tc_radix_unique( keys, rows, valid );
+
+			for ( i = 0; i < n; i++ )
+			{
+				emitLine( &w, data, starts, lineOf[ rows[i] ] );
+			}
+		}
+		else
+		{
+			size_t n = tc_radix_unique( keys, rows, valid );
+
+			struct tc_radix_range *ranges = tc_arena_alloc( &arena, ( n + 1 ) * sizeof(struct tc_radix_range) );
+
+			if ( ranges == NULL )
+			{
+				rc = -1;
+			}
+			else
+			{
+				n = tc_radix_ranges( keys, rows, n, tc_radix_frame_ticks( opts->format ), ranges );
+
+				for ( i = 0; i < n; i++ )
+				{
+					emitRange( &w, &array, &ranges[i] );
+				}
+			}
+		}
+
+		flush( &w );
+	}
+
+	free( w.buffer );
+
+	tc_arena_release( &arena );
+	tc_map_close( &map );
+
+	return ( rc < 0 || w.error || ferror( out ) ) ? -1 : 0;
+}
@@ -0,0 +1,71 @@
+#ifndef __tcSort_h__
+#define __tcSort_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lib/libTC.h"
+
+
+
+enum SORT_OUTPUT {
+
+	SORT_LINES = 0,    // every line, ordered by TC
+	SORT_UNIQUE,       // the first line of each TC
+	SORT_RANGES        // first TC, last TC and count of each run of consecutive TC
+};
+
+
+struct sort_options
+{
+	enum TC_FORMAT    format;
+
+	enum SORT_OUTPUT  output;
+
+	unsigned int      column;       // 1-based field holding the TC
+
+	char              delimiter;
+
+	uint8_t           header;       // pass the first line through untouched
+
+	uint8_t           noRollover;   // values are past the day limit rather than wrapped
+
+	unsigned int      threads;
+
+};
+
+
+/**
+ *	Sorts the lines of a file (- for stdin) on the TC of one field, either
+ *	hh:mm:ss:ff (any separators) or a frame number, with tc_radix_sort().
+ *	Keys are in real time, so lists of a drop frame format sort in frame
+ *	order, and lists running across midnight keep the next day after it
+ *	(unless opts->noRollover). Lines with no valid TC come last, in input
+ *	order, and are left out of the unique and range outputs.
+ *
+ *	Returns 0 on success, -1 on read / write / allocation error.
+ */
+
+int sort_lines( const char *path, const struct sort_options *opts, FILE *out );
+
+
+#endif // ! __tcSort_h__
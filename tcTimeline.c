@@ -0,0 +1,1054 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lib/libTC.h"
+#include "lib/tcMap.h"
+#include "lib/tcRational.h"
+#include "tcTimeline.h"
+
+
+
+/*
+ *	A rational time : num / den seconds, or num / den units of a rate.
+ */
+
+struct rtime
+{
+	int       neg;
+	uint64_t  num;
+	uint64_t  den;
+};
+
+
+/*
+ *	Walking state shared by both formats : what has been copied to out so far,
+ *	the line count up to a given position for the report, and the last
+ *	time to frames ratio.
+ */
+
+struct frame_ratio
+{
+	int       valid;
+
+	uint64_t  timeDen;   // key : time denominator and rate
+	uint64_t  rateNum;
+	uint64_t  rateDen;
+
+	uint64_t  num;       // frames = time numerator * num / den
+	uint64_t  den;
+};
+
+
+struct walker
+{
+	const struct timeline_options  *opts;
+
+	FILE                           *out;
+
+	char                           *buffer;
+	size_t                          used;
+
+	struct frame_ratio              ratio;
+
+	const char                     *data;
+	const char                     *written;
+
+	const char                     *counted;
+	size_t                          line;
+
+	int                             error;
+};
+
+
+
+
+static const char * findBytes( const char *p, const char *end, const char *str, size_t len )
+{
+	/* memmem() isn't everywhere (mingw) */
+
+	while ( ( p = memchr( p, str[0], end - p ) ) != NULL )
+	{
+		if ( (size_t)( end - p ) < len )
+			return NULL;
+
+		if ( memcmp( p, str, len ) == 0 )
+			return p;
+
+		p++;
+	}
+
+	return NULL;
+}
+
+
+
+
+static int isDigit( char c )
+{
+	return ( c >= '0' && c <= '9' );
+}
+
+
+
+
+/*
+ *	FCPXML time value : [-]N[/D]s, N and D integers.
+ */
+
+static int parseFcpxmlTime( const char *p, const char *end, struct rtime *t )
+{
+	t->neg = 0;
+	t->num = 0;
+	t->den = 1;
+
+	if ( end - p < 2 || end[-1] != 's' )
+		return -1;
+
+	end--;
+
+	if ( *p == '-' )
+	{
+		t->neg = 1;
+		p++;
+	}
+
+	if ( p == end || !isDigit( *p ) )
+		return -1;
+
+	for ( ; p < end && isDigit( *p ); p++ )
+	{
+		if ( t->num > ( UINT64_MAX - 9 ) / 10 )
+			return -1;
+
+		t->num = t->num * 10 + ( *p - '0' );
+	}
+
+	if ( p < end && *p == '/' )
+	{
+		p++;
+
+		if ( p == end )
+			return -1;
+
+		t->den = 0;
+
+		for ( ; p < end && isDigit( *p ); p++ )
+		{
+			if ( t->den > ( UINT64_MAX - 9 ) / 10 )
+				return -1;
+
+			t->den = t->den * 10 + ( *p - '0' );
+		}
+	}
+
+	return ( p == end && t->den != 0 ) ? 0 : -1;
+}
+
+
+
+
+/*
+ *	JSON number, kept as an exact decimal fraction. Returns the first byte
+ *	after the number, or NULL if it doesn't fit 64 bits.
+ */
+
+static const char * parseDecimal( const char *p, const char *end, struct rtime *t )
+{
+	int exponent = 0;
+	int expSign  = 1;
+	int scale    = 0;
+
+	t->neg = 0;
+	t->num = 0;
+	t->den = 1;
+
+	if ( p < end && *p == '-' )
+	{
+		t->neg = 1;
+		p++;
+	}
+
+	if ( p == end || !isDigit( *p ) )
+		return NULL;
+
+	for ( ; p < end && isDigit( *p ); p++ )
+	{
+		if ( t->num > ( UINT64_MAX - 9 ) / 10 )
+			return NULL;
+
+		t->num = t->num * 10 + ( *p - '0' );
+	}
+
+	if ( p < end && *p == '.' )
+	{
+		for ( p++; p < end && isDigit( *p ); p++ )
+		{
+			if ( *p == '0' )
+			{
+				/* trailing zeros of "86400.0" don't need to fit */
+
+				const char *z = p;
+
+				while ( z < end && *z == '0' )
+					z++;
+
+				if ( z == end || !isDigit( *z ) )
+				{
+					p = z - 1;
+					continue;
+				}
+			}
+
+			if ( t->num > ( UINT64_MAX - 9 ) / 10 )
+				return NULL;
+
+			t->num = t->num * 10 + ( *p - '0' );
+			scale++;
+		}
+	}
+
+	if ( p < end && ( *p == 'e' || *p == 'E' ) )
+	{
+		p++;
+
+		if ( p < end && ( *p == '-' || *p == '+' ) )
+		{
+			expSign = ( *p == '-' ) ? -1 : 1;
+			p++;
+		}
+
+		for ( ; p < end && isDigit( *p ); p++ )
+		{
+			if ( exponent > 100 )
+				return NULL;
+
+			exponent = exponent * 10 + ( *p - '0' );
+		}
+	}
+
+	scale -= expSign * exponent;
+
+	for ( ; scale > 0; scale-- )
+	{
+		if ( t->den > UINT64_MAX / 10 )
+			return NULL;
+
+		t->den *= 10;
+	}
+
+	for ( ; scale < 0; scale++ )
+	{
+		if ( t->num > UINT64_MAX / 10 )
+			return NULL;
+
+		t->num *= 10;
+	}
+
+	uint64_t g = tc_gcd( t->num, t->den );
+
+	if ( g > 1 )
+	{
+		t->num /= g;
+		t->den /= g;
+	}
+
+	return p;
+}
+
+
+
+
+/*
+ *	OTIO stores rates as doubles, so 24000/1001 is 23.976023976023978 :
+ *	use the exact rate of a timecode format when the decimal is that close.
+ */
+
+static void snapRate( struct rtime *rate )
+{
+	double r = (double)rate->num / rate->den;
+
+	int f = TC_FORMAT_UNK + 1;
+
+	for ( ; f < TC_FORMAT_LEN; f++ )
+	{
+		rational_t fps = tc_format_rate( f );
+
+		double v = (double)fps.numerator / fps.denominator;
+
+		if ( fabs( r - v ) < v * 1e-9 )
+		{
+			rate->num = fps.numerator;
+			rate->den = fps.denominator;
+			return;
+		}
+	}
+}
+
+
+
+
+/*
+ *	frames = t * fps, or t / rate * fps, rounded to nearest. The constant
+ *	part fps / ( den * rate ) is reduced once per distinct denominator and
+ *	rate (a timeline mostly uses one or two), so each time only costs a
+ *	tc_muldiv().
+ */
+
+static int frameRatio( struct walker *w, const struct rtime *t, const struct rtime *rate )
+{
+	struct frame_ratio *r = &w->ratio;
+
+	uint64_t rateNum = ( rate != NULL ) ? rate->num : 1;
+	uint64_t rateDen = ( rate != NULL ) ? rate->den : 1;
+
+	if ( r->valid && r->timeDen == t->den && r->rateNum == rateNum && r->rateDen == rateDen )
+	{
+		return 0;
+	}
+
+	rational_t fps = tc_format_rate( w->opts->format );
+
+	uint64_t n[2] = { fps.numerator,   rateDen };
+	uint64_t d[3] = { fps.denominator, rateNum, t->den };
+
+	int i, j;
+
+	for ( i = 0; i < 2; i++ )
+	{
+		for ( j = 0; j < 3; j++ )
+		{
+			uint64_t g = tc_gcd( n[i], d[j] );
+
+			n[i] /= g;
+			d[j] /= g;
+		}
+	}
+
+	r->valid = 0;
+
+	if ( __builtin_mul_overflow( n[0], n[1], &r->num ) ||
+	     __builtin_mul_overflow( d[0], d[1], &r->den ) ||
+	     __builtin_mul_overflow( r->den, d[2], &r->den ) )
+	{
+		return -1;
+	}
+
+	r->timeDen = t->den;
+	r->rateNum = rateNum;
+	r->rateDen = rateDen;
+	r->valid   = 1;
+
+	return 0;
+}
+
+
+static int timeToFrames( struct walker *w, const struct rtime *t, const struct rtime *rate, int32_t *frames )
+{
+	if ( t->den == 0 || ( rate != NULL && rate->num == 0 ) || frameRatio( w, t, rate ) < 0 )
+	{
+		return -1;
+	}
+
+	const struct frame_ratio *r = &w->ratio;
+
+	/* t * num / den must fit an int32 frame number, which also keeps tc_muldiv() in 64 bits */
+
+	if ( t->num / r->den > ( (uint64_t)INT32_MAX + 1 ) / r->num )
+	{
+		return -1;
+	}
+
+	uint64_t v = tc_muldiv( t->num, r->num, r->den, r->den / 2 );
+
+	if ( v > (uint64_t)INT32_MAX )
+	{
+		return -1;
+	}
+
+	*frames = ( t->neg ) ? -(int32_t)v : (int32_t)v;
+
+	return 0;
+}
+
+
+
+
+/*
+ *	Maps a time to a timecode of the timeline format, and through the
+ *	operation for a rewrite. before is its frame number ahead of the
+ *	operation. Times that aren't timeline positions (media in-points,
+ *	durations) are only converted.
+ */
+
+static int timeToTimecode( struct walker *w, const struct rtime *t, const struct rtime *rate, int isPosition, struct timecode *tc, int32_t *before )
+{
+	int32_t frames = 0;
+
+	if ( timeToFrames( w, t, rate, &frames ) < 0 )
+	{
+		return -1;
+	}
+
+	memset( tc, 0x00, sizeof(struct timecode) );
+
+	tc->noRollover = w->opts->noRollover;
+
+	tc_set_by_frames( tc, ( frames > 0 ) ? (uint32_t)frames : 0, w->opts->format );
+
+	if ( frames < 0 )
+	{
+		tc_step( tc, frames );
+	}
+
+	*before = tc->frameNumber;
+
+	if ( !w->opts->report && w->opts->program != NULL )
+	{
+		const struct program *prog = w->opts->program;
+
+		unsigned int i = 0;
+
+		for ( ; i < prog->count; i++ )
+		{
+			enum OPERATION_TYPE type = prog->ops[i].type;
+
+			if ( isPosition || !( type == OPERATION_ADD || type == OPERATION_SUB || type == OPERATION_STEP ) )
+			{
+				apply_operation( &prog->ops[i], tc );
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ *	The operation moved the time, or changed its format. Times it leaves
+ *	alone are copied byte for byte : they needn't fall on a frame.
+ */
+
+static int changed( const struct walker *w, const struct timecode *tc, int32_t before )
+{
+	return ( tc->format != w->opts->format || tc->frameNumber != before );
+}
+
+
+
+
+/*
+ *	Output goes through a local buffer : stdio locks and checks on every
+ *	fwrite(), and a rewrite is mostly short spans.
+ */
+
+#define TIMELINE_BUFFER_SIZE  ( 1 << 20 )
+
+
+static void flush( struct walker *w )
+{
+	if ( w->used > 0 && fwrite( w->buffer, 1, w->used, w->out ) != w->used )
+	{
+		w->error = 1;
+	}
+
+	w->used = 0;
+}
+
+
+static void emit( struct walker *w, const char *data, size_t len )
+{
+	if ( w->used + len > TIMELINE_BUFFER_SIZE )
+	{
+		flush( w );
+
+		if ( len > TIMELINE_BUFFER_SIZE / 2 )
+		{
+			if ( fwrite( data, 1, len, w->out ) != len )
+			{
+				w->error = 1;
+			}
+
+			return;
+		}
+	}
+
+	memcpy( w->buffer + w->used, data, len );
+
+	w->used += len;
+}
+
+
+static size_t putUnsigned( char *dst, uint64_t v )
+{
+	char   tmp[20];
+	size_t len = 0;
+
+	do
+	{
+		tmp[len++] = '0' + v % 10;
+		v /= 10;
+	}
+	while ( v != 0 );
+
+	size_t i = 0;
+
+	for ( ; i < len; i++ )
+	{
+		dst[i] = tmp[len - 1 - i];
+	}
+
+	return len;
+}
+
+
+
+
+static void countLines( struct walker *w, const char *pos )
+{
+	const char *p = w->counted;
+
+	while ( ( p = memchr( p, '\n', pos - p ) ) != NULL )
+	{
+		w->line++;
+		p++;
+	}
+
+	w->counted = pos;
+}
+
+
+
+
+/*
+ *	Copies the input up to from, then text in place of [from, to).
+ */
+
+static void replace( struct walker *w, const char *from, const char *to, const char *text, size_t len )
+{
+	emit( w, w->written, from - w->written );
+	emit( w, text, len );
+
+	w->written = to;
+}
+
+
+
+
+static void report( struct walker *w, const char *pos, const char *name, size_t nameLen, const char *value, size_t valueLen, const struct timecode *tc )
+{
+	char line[24];
+
+	countLines( w, pos );
+
+	size_t len = putUnsigned( line, w->line );
+
+	line[len++] = '\t';
+
+	emit( w, line, len );
+	emit( w, name, nameLen );
+	emit( w, "\t", 1 );
+	emit( w, value, valueLen );
+	emit( w, "\t", 1 );
+	emit( w, tc->string, strlen( tc->string ) );
+	emit( w, "\n", 1 );
+}
+
+
+
+
+/*
+ *	t += frames of fps, exactly. Returns -1 if that doesn't fit 64 bits.
+ */
+
+static int shiftTime( struct rtime *t, int64_t frames, rational_t fps )
+{
+	uint64_t fn = fps.numerator, fd = fps.denominator;
+
+	uint64_t g = tc_gcd( t->den, fn );
+
+	uint64_t den, a, b;
+
+	/* t->num * fn / g + frames * fd * t->den / g, over t->den * fn / g */
+
+	if ( __builtin_mul_overflow( t->den, fn / g, &den ) ||
+	     __builtin_mul_overflow( t->num, fn / g, &a ) ||
+	     __builtin_mul_overflow( (uint64_t)( ( frames < 0 ) ? -frames : frames ), fd * ( t->den / g ), &b ) ||
+	     a > INT64_MAX || b > INT64_MAX )
+	{
+		return -1;
+	}
+
+	int64_t v = ( ( t->neg ) ? -(int64_t)a : (int64_t)a ) + ( ( frames < 0 ) ? -(int64_t)b : (int64_t)b );
+
+	t->neg = ( v < 0 );
+	t->num = ( v < 0 ) ? -(uint64_t)v : (uint64_t)v;
+	t->den = den;
+
+	return 0;
+}
+
+
+/*
+ *	*v = value + frames of fps, in units of rate. Returns -1 unless value
+ *	and the shift are whole units (in 64 bits).
+ */
+
+static int shiftValue( const struct rtime *value, const struct rtime *rate, int64_t frames, rational_t fps, int64_t *v )
+{
+	uint64_t n, d;
+
+	if ( value->den != 1 || value->num > INT64_MAX ||
+	     __builtin_mul_overflow( (uint64_t)( ( frames < 0 ) ? -frames : frames ), rate->num, &n ) ||
+	     __builtin_mul_overflow( n, (uint64_t)fps.denominator, &n ) ||
+	     __builtin_mul_overflow( rate->den, (uint64_t)fps.numerator, &d ) ||
+	     n % d != 0 || n / d > INT64_MAX )
+	{
+		return -1;
+	}
+
+	int64_t units = ( frames < 0 ) ? -(int64_t)( n / d ) : (int64_t)( n / d );
+
+	return __builtin_add_overflow( ( value->neg ) ? -(int64_t)value->num : (int64_t)value->num, units, v ) ? -1 : 0;
+}
+
+
+/*
+ *	FCPXML time value, reduced : "1001/30000s", "3600s", "0s".
+ */
+
+static size_t putTime( char *text, const struct rtime *t )
+{
+	uint64_t g = tc_gcd( t->num, t->den );
+
+	size_t len = 0;
+
+	if ( t->neg && t->num != 0 )
+		text[len++] = '-';
+
+	len += putUnsigned( text + len, t->num / g );
+
+	if ( t->den / g != 1 && t->num != 0 )
+	{
+		text[len++] = '/';
+		len += putUnsigned( text + len, t->den / g );
+	}
+
+	text[len++] = 's';
+
+	return len;
+}
+
+
+
+
+/*
+ *	FCPXML : time attributes of the clip / sequence elements. The values
+ *	are found with a memchr() for '=', and checked for a trailing 's' before
+ *	anything is parsed.
+ *
+ *	start and audioStart are in-points on the local timeline of the media :
+ *	moves leave them alone. The audio times are rational seconds too, but
+ *	needn't fall on a frame, so a conversion rewrites them by the exact
+ *	shift of their frame rather than quantizing them.
+ */
+
+enum FCPXML_TIME {
+
+	FCPXML_POSITION = 0,
+	FCPXML_MEDIA,
+	FCPXML_DURATION,
+	FCPXML_AUDIO_MEDIA,
+	FCPXML_AUDIO_DURATION
+};
+
+
+static int fcpxmlAttribute( const char *name, size_t len )
+{
+	static const struct { const char *name; size_t len; int kind; } ATTRIBUTES[] = {
+		{ "offset",         6, FCPXML_POSITION       },
+		{ "start",          5, FCPXML_MEDIA          },
+		{ "tcStart",        7, FCPXML_POSITION       },
+		{ "audioStart",    10, FCPXML_AUDIO_MEDIA    },
+		{ "duration",       8, FCPXML_DURATION       },
+		{ "audioDuration", 13, FCPXML_AUDIO_DURATION },
+		{ "frameDuration", 13, FCPXML_DURATION       },
+		{ NULL,             0, 0                     }
+	};
+
+	unsigned int i = 0;
+
+	for ( ; ATTRIBUTES[i].name != NULL; i++ )
+	{
+		if ( ATTRIBUTES[i].len == len && memcmp( ATTRIBUTES[i].name, name, len ) == 0 )
+		{
+			return ATTRIBUTES[i].kind;
+		}
+	}
+
+	return -1;
+}
+
+
+static void walkFcpxml( struct walker *w, const char *data, const char *end )
+{
+	const char *p = data;
+
+	while ( ( p = memchr( p, '=', end - p ) ) != NULL )
+	{
+		const char *eq = p++;
+
+		while ( p < end && ( *p == ' ' || *p == '\t' ) )
+			p++;
+
+		if ( p >= end || ( *p != '"' && *p != '\'' ) )
+			continue;
+
+		const char *value = ++p;
+		const char *close = memchr( value, p[-1], end - value );
+
+		if ( close == NULL )
+			break;
+
+		p = close + 1;
+
+		if ( close - value < 2 || close[-1] != 's' )
+			continue;
+
+		const char *nameEnd = eq;
+
+		while ( nameEnd > data && ( nameEnd[-1] == ' ' || nameEnd[-1] == '\t' ) )
+			nameEnd--;
+
+		const char *name = nameEnd;
+
+		while ( name > data && ( ( name[-1] >= 'a' && name[-1] <= 'z' ) || ( name[-1] >= 'A' && name[-1] <= 'Z' ) ) )
+			name--;
+
+		int kind = fcpxmlAttribute( name, nameEnd - name );
+
+		if ( kind < 0 )
+			continue;
+
+		struct rtime    t;
+		struct timecode tc;
+
+		int32_t before;
+
+		if ( parseFcpxmlTime( value, close, &t ) < 0 ||
+		     timeToTimecode( w, &t, NULL, kind == FCPXML_POSITION, &tc, &before ) < 0 )
+		{
+			continue;
+		}
+
+		if ( w->opts->report )
+		{
+			report( w, name, name, nameEnd - name, value, close - value, &tc );
+			continue;
+		}
+
+		if ( !changed( w, &tc, before ) )
+			continue;
+
+		char   text[64];
+		size_t len;
+
+		int audio = ( kind == FCPXML_AUDIO_MEDIA || kind == FCPXML_AUDIO_DURATION );
+
+		if ( tc.format == w->opts->format && shiftTime( &t, (int64_t)tc.frameNumber - before, tc_format_rate( tc.format ) ) == 0 )
+		{
+			/* a move : the time shifted by whole frames, keeping its sub-frame part */
+
+			len = putTime( text, &t );
+		}
+		else if ( audio )
+		{
+			/* its frame goes from before in the timeline rate to tc in its rate, the rest follows */
+
+			if ( shiftTime( &t, -(int64_t)before, tc_format_rate( w->opts->format ) ) < 0 ||
+			     shiftTime( &t, tc.frameNumber, tc_format_rate( tc.format ) ) < 0 )
+			{
+				continue;
+			}
+
+			len = putTime( text, &t );
+		}
+		else
+		{
+			/* back to rational seconds, in the rate of the resulting format */
+
+			rational_t fps = tc_format_rate( tc.format );
+
+			t.neg = ( tc.frameNumber < 0 );
+			t.num = (uint64_t)( ( tc.frameNumber < 0 ) ? -(int64_t)tc.frameNumber : tc.frameNumber ) * fps.denominator;
+			t.den = fps.numerator;
+
+			len = putTime( text, &t );
+		}
+
+		replace( w, value, close, text, len );
+	}
+}
+
+
+
+
+/*
+ *	OTIO : RationalTime objects, found by their schema name. The object is
+ *	flat, so its braces are the nearest ones around the name, and the key it
+ *	is stored under ("duration", "start_time"...) is just before the '{'.
+ */
+
+static const char * skipSpaces( const char *p, const char *end )
+{
+	while ( p < end && ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' ) )
+		p++;
+
+	return p;
+}
+
+
+static const char * findNumber( const char *open, const char *close, const char *key, size_t keyLen )
+{
+	const char *k = findBytes( open, close, key, keyLen );
+
+	if ( k == NULL )
+		return NULL;
+
+	k = skipSpaces( k + keyLen, close );
+
+	if ( k == close || *k != ':' )
+		return NULL;
+
+	return skipSpaces( k + 1, close );
+}
+
+
+static void walkOtio( struct walker *w, const char *data, const char *end )
+{
+	static const char MARKER[] = "\"RationalTime.";
+
+	const char *p    = data;
+	const char *prev = data;  // end of the previous object
+
+	while ( ( p = findBytes( p, end, MARKER, sizeof(MARKER) - 1 ) ) != NULL )
+	{
+		const char *open = p;
+
+		while ( open > prev && *open != '{' )
+			open--;
+
+		const char *close = memchr( p, '}', end - p );
+
+		p += sizeof(MARKER) - 1;
+
+		if ( *open != '{' || close == NULL )
+			continue;
+
+		prev = close;
+
+
+		struct rtime rate, value;
+
+		const char *rateAt  = findNumber( open, close, "\"rate\"",  6 );
+		const char *valueAt = findNumber( open, close, "\"value\"", 7 );
+
+		const char *rateEnd  = ( rateAt  != NULL ) ? parseDecimal( rateAt,  close, &rate  ) : NULL;
+		const char *valueEnd = ( valueAt != NULL ) ? parseDecimal( valueAt, close, &value ) : NULL;
+
+		if ( rateEnd == NULL || valueEnd == NULL || rate.num == 0 || rate.neg )
+			continue;
+
+		snapRate( &rate );
+
+
+		/* key of the object */
+
+		const char *k = open;
+
+		while ( k > data && ( k[-1] == ' ' || k[-1] == '\t' || k[-1] == '\r' || k[-1] == '\n' ) )
+			k--;
+
+		const char *keyEnd = NULL;
+		const char *key    = NULL;
+
+		if ( k > data && k[-1] == ':' )
+		{
+			k--;
+
+			while ( k > data && ( k[-1] == ' ' || k[-1] == '\t' ) )
+				k--;
+
+			if ( k > data + 1 && k[-1] == '"' )
+			{
+				keyEnd = k - 1;
+				key    = keyEnd;
+
+				while ( key > data && key[-1] != '"' )
+					key--;
+			}
+		}
+
+		/* the start of the timeline is its only position, start_time and duration are media ranges */
+
+		int isPosition = ( key != NULL && keyEnd - key == 17 && memcmp( key, "global_start_time", 17 ) == 0 );
+
+		struct timecode tc;
+
+		int32_t before;
+
+		if ( timeToTimecode( w, &value, &rate, isPosition, &tc, &before ) < 0 )
+		{
+			continue;
+		}
+
+		if ( w->opts->report )
+		{
+			char original[64];
+
+			snprintf( original, sizeof(original), "%.*s@%.*s", (int)( valueEnd - valueAt ), valueAt, (int)( rateEnd - rateAt ), rateAt );
+
+			if ( key == NULL )
+			{
+				key    = "-";
+				keyEnd = key + 1;
+			}
+
+			report( w, open, key, keyEnd - key, original, strlen( original ), &tc );
+			continue;
+		}
+
+		if ( !changed( w, &tc, before ) )
+			continue;
+
+		rational_t fps = tc_format_rate( tc.format );
+
+		int64_t v;
+
+		if ( tc.format == w->opts->format && shiftValue( &value, &rate, (int64_t)tc.frameNumber - before, fps, &v ) == 0 )
+		{
+			/* a move by a whole number of units of the object rate : only the value changes */
+
+			char   valueText[32];
+			size_t valueLen = 0;
+
+			if ( v < 0 )
+				valueText[valueLen++] = '-';
+
+			valueLen += putUnsigned( valueText + valueLen, ( v < 0 ) ? -(uint64_t)v : (uint64_t)v );
+
+			valueText[valueLen++] = '.';
+			valueText[valueLen++] = '0';
+
+			replace( w, valueAt, valueEnd, valueText, valueLen );
+			continue;
+		}
+
+		/* the value becomes the frame number, at the rate of the resulting format */
+
+		char   rateText[32], valueText[32];
+		size_t rateLen, valueLen;
+
+		if ( fps.denominator == 1 )
+			rateLen = snprintf( rateText, sizeof(rateText), "%i.0", fps.numerator );
+		else
+			rateLen = snprintf( rateText, sizeof(rateText), "%.17g", (double)fps.numerator / fps.denominator );
+
+		valueLen = 0;
+
+		if ( tc.frameNumber < 0 )
+			valueText[valueLen++] = '-';
+
+		valueLen += putUnsigned( valueText + valueLen, ( tc.frameNumber < 0 ) ? -(int64_t)tc.frameNumber : tc.frameNumber );
+
+		valueText[valueLen++] = '.';
+		valueText[valueLen++] = '0';
+
+		if ( rateAt < valueAt )
+		{
+			replace( w, rateAt,  rateEnd,  rateText,  rateLen  );
+			replace( w, valueAt, valueEnd, valueText, valueLen );
+		}
+		else
+		{
+			replace( w, valueAt, valueEnd, valueText, valueLen );
+			replace( w, rateAt,  rateEnd,  rateText,  rateLen  );
+		}
+	}
+}
+
+
+
+
+int timeline_convert( const char *path, const struct timeline_options *opts, FILE *out )
+{
+	struct tc_map map;
+
+	if ( tc_map_open( &map, path ) < 0 )
+	{
+		return -1;
+	}
+
+	struct walker w;
+
+	memset( &w, 0x00, sizeof(struct walker) );
+
+	w.buffer = malloc( TIMELINE_BUFFER_SIZE );
+
+	if ( w.buffer == NULL )
+	{
+		tc_map_close( &map );
+		return -1;
+	}
+
+	w.opts    = opts;
+	w.out     = out;
+	w.data    = (const char*)map.data;
+	w.written = w.data;
+	w.counted = w.data;
+	w.line    = 1;
+
+	const char *end = w.data + map.size;
+
+	if ( opts->type == TIMELINE_OTIO )
+	{
+		walkOtio( &w, w.data, end );
+	}
+	else
+	{
+		walkFcpxml( &w, w.data, end );
+	}
+
+	if ( !opts->report )
+	{
+		emit( &w, w.written, end - w.written );
+	}
+
+	flush( &w );
+
+	free( w.buffer );
+
+	tc_map_close( &map );
+
+	return ( w.error || ferror( out ) ) ? -1 : 0;
+}
@@ -0,0 +1,72 @@
+#ifndef __tcTimeline_h__
+#define __tcTimeline_h__
+
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tcCoca.h"
+
+
+
+enum TIMELINE_TYPE {
+
+	TIMELINE_FCPXML = 0,   // time attributes such as offset="3003/30000s"
+	TIMELINE_OTIO          // RationalTime objects { "rate": 24.0, "value": 86400.0 }
+};
+
+
+struct timeline_options
+{
+	enum TIMELINE_TYPE       type;
+
+	enum TC_FORMAT           format;        // timeline frame rate
+
+	uint8_t                  noRollover;
+
+	uint8_t                  report;        // list the times instead of rewriting the file
+
+	const struct program    *program;
+
+};
+
+
+/**
+ *	Walks an FCPXML or OTIO document in place (memory-mapped, no DOM) and maps
+ *	every rational time to a frame of opts->format, with exact integer math
+ *	rounded to the nearest frame.
+ *
+ *	In report mode, each time is printed to out with its line number and
+ *	timecode. Otherwise the document is copied to out with the times
+ *	opts->program changes rewritten, and every other byte unchanged.
+ *	Additions, subtractions and steps only move timeline positions (FCPXML
+ *	offset and tcStart, OTIO global_start_time), by an exact number of
+ *	frames : media in-points and durations are only converted. A conversion
+ *	writes the time in the rate of the resulting format, but FCPXML audio
+ *	times (audioStart, audioDuration) keep their part off the frame.
+ *
+ *	Returns 0 on success, -1 if the file can't be read or on write error.
+ */
+
+int timeline_convert( const char *path, const struct timeline_options *opts, FILE *out );
+
+
+#endif // ! __tcTimeline_h__
@@ -0,0 +1,640 @@
+/*
+ *	This file is part of LibTC.
+ *
+ *	Copyright (c) 2017 Adrien Gesta-Fline
+ *
+ *	LibTC is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU Affero General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	any later version.
+ *
+ *	LibTC is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU Affero General Public License for more details.
+ *
+ *	You should have received a copy of the GNU Affero General Public License
+ *	along with LibTC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/tcCue.h"
+
+
+
+/*
+ *	Simulated clock driver for the cue scheduler (make check).
+ *
+ *	A random loop of plays, locates, inserts, cancels and posted changes is
+ *	run on the scheduler and on a plain model of tcCue.h, which keeps its
+ *	cues in an array and scans them all at every frame. After each call, the
+ *	events, return values and cue states of both must match :
+ *
+ *	- a play of 1 to chase frames fires every cue on the way, frame by frame.
+ *	- any other move skips the cues before the clock and fires those on it.
+ *	- going back re-arms the rearm cues after the clock.
+ *	- posted changes apply at the next update, the last request of a cue
+ *	  winning, in the order the cues were first posted.
+ *
+ *	Some cues insert themselves again from their callback. The clock starts
+ *	below a carry of every byte, and moves over up to 2^25 frames, so cues
+ *	are filed at, and re-filed from, every level of the wheel.
+ *
+ *	usage : tcCueCheck [seed [iterations]]
+ */
+
+#define CHECK_CUES         64
+#define CHECK_ITERATIONS   200000
+#define CHECK_EVENTS       4096
+
+#define CHECK_START        0x00fffe00
+
+
+/* the values of the scheduler's cue states */
+
+enum MODEL_STATE {
+
+	MODEL_IDLE    = 0,
+	MODEL_PENDING = 1,
+	MODEL_FIRED   = 3
+};
+
+
+enum MODEL_REQUEST {
+
+	MODEL_NONE = 0,
+	MODEL_INSERT,
+	MODEL_CANCEL
+};
+
+
+struct check_event
+{
+	uint32_t  now;
+	uint32_t  cue;
+	uint32_t  event;
+};
+
+
+struct check_log
+{
+	struct check_event  events[CHECK_EVENTS];
+	size_t              count;
+};
+
+
+struct model_cue
+{
+	int       state;
+	uint32_t  position;
+
+	int       request;      // last posted request
+	uint32_t  postedPosition;
+};
+
+
+struct model
+{
+	struct model_cue  cues[CHECK_CUES];
+
+	int               posted[CHECK_CUES];   // cues in first posting order
+	size_t            postedCount;
+
+	uint32_t          now;
+	uint8_t           started;
+};
+
+
+struct check
+{
+	struct tc_cue_sched  sched;
+	struct tc_cue        cues[CHECK_CUES];
+
+	struct model         model;
+
+	struct check_log     real;
+	struct check_log     expected;
+
+	uint64_t             rng;
+
+	unsigned long long   updates;
+	unsigned long long   fired;
+	unsigned long long   skipped;
+};
+
+
+
+
+static uint32_t nextRandom( struct check *c )
+{
+	/* xorshift64* */
+
+	c->rng ^= c->rng >> 12;
+	c->rng ^= c->rng << 25;
+	c->rng ^= c->rng >> 27;
+
+	return (uint32_t)( ( c->rng * 0x2545f4914f6cdd1dULL ) >> 32 );
+}
+
+
+/* a random distance, of 1 to 2^25 frames, most of them short */
+
+static uint32_t randomDistance( struct check *c )
+{
+	switch ( nextRandom( c ) % 8 )
+	{
+		case 0:   return 1 + nextRandom( c ) % ( 1 << 25 );
+		case 1:
+		case 2:   return 1 + nextRandom( c ) % 70000;
+		case 3:   return 1 + nextRandom( c ) % 600;
+		default:  return 1 + nextRandom( c ) % 40;
+	}
+}
+
+
+static int isChained( int cue )
+{
+	return ( cue % 8 ) == 7;
+}
+
+
+static int isRearm( int cue )
+{
+	return ( cue % 3 ) == 0 && !isChained( cue );
+}
+
+
+/* where a chained cue goes next, the same for the scheduler and the model */
+
+static uint32_t chainPosition( int cue, uint32_t now )
+{
+	return now + 1 + ( ( now * 2654435761u ) ^ (uint32_t)cue ) % 90;
+}
+
+
+static void logEvent( struct check_log *log, uint32_t now, int cue, enum TC_CUE_EVENT event )
+{
+	if ( log->count < CHECK_EVENTS )
+	{
+		log->events[log->count].now   = now;
+		log->events[log->count].cue   = (uint32_t)cue;
+		log->events[log->count].event = (uint32_t)event;
+	}
+
+	log->count++;
+}
+
+
+
+
+static int modelInsert( struct model *m, int cue, uint32_t position )
+{
+	if ( m->started && position <= m->now )
+	{
+		return -1;
+	}
+
+	m->cues[cue].state    = MODEL_PENDING;
+	m->cues[cue].position = position;
+
+	return 0;
+}
+
+
+static int modelCancel( struct model *m, int cue )
+{
+	if ( m->cues[cue].state == MODEL_IDLE )
+	{
+		return -1;
+	}
+
+	m->cues[cue].state = MODEL_IDLE;
+
+	return 0;
+}
+
+
+static void modelPost( struct model *m, int cue, int request, uint32_t position )
+{
+	if ( m->cues[cue].request == MODEL_NONE )
+	{
+		m->posted[m->postedCount++] = cue;
+	}
+
+	m->cues[cue].request        = request;
+	m->cues[cue].postedPosition = position;
+}
+
+
+static void modelDispatch( struct check *c, int cue, enum TC_CUE_EVENT event )
+{
+	struct model *m = &c->model;
+
+	m->cues[cue].state = ( isRearm( cue ) ) ? MODEL_FIRED : MODEL_IDLE;
+
+	logEvent( &c->expected, m->now, cue, event );
+
+	if ( event == TC_CUE_FIRED && isChained( cue ) )
+	{
+		modelInsert( m, cue, chainPosition( cue, m->now ) );
+	}
+}
+
+
+/* dispatches the cues collected before any callback runs */
+
+static void modelDispatchDue( struct check *c, const int *due, size_t count )
+{
+	size_t i = 0;
+
+	for ( ; i < count; i++ )
+	{
+		struct model_cue *cue = &c->model.cues[ due[i] ];
+
+		modelDispatch( c, due[i], ( cue->position == c->model.now ) ? TC_CUE_FIRED : TC_CUE_SKIPPED );
+	}
+}
+
+
+static void modelUpdate( struct check *c, uint32_t position )
+{
+	struct model *m = &c->model;
+
+	int    due[CHECK_CUES];
+	size_t count = 0;
+	size_t i;
+	int    cue;
+
+	for ( i = 0; i < m->postedCount; i++ )
+	{
+		struct model_cue *p = &m->cues[ m->posted[i] ];
+
+		if ( p->request == MODEL_INSERT )
+		{
+			modelInsert( m, m->posted[i], p->postedPosition );
+		}
+		else
+		{
+			modelCancel( m, m->posted[i] );
+		}
+
+		p->request = MODEL_NONE;
+	}
+
+	m->postedCount = 0;
+
+	if ( m->started && position > m->now && position - m->now <= c->sched.chase )
+	{
+		while ( m->now < position )
+		{
+			m->now++;
+
+			for ( count = 0, cue = 0; cue < CHECK_CUES; cue++ )
+			{
+				if ( m->cues[cue].state == MODEL_PENDING && m->cues[cue].position == m->now )
+				{
+					due[count++] = cue;
+				}
+			}
+
+			modelDispatchDue( c, due, count );
+		}
+	}
+	else if ( !m->started || position != m->now )
+	{
+		int back = ( m->started && position < m->now );
+
+		m->now     = position;
+		m->started = 1;
+
+		for ( cue = 0; cue < CHECK_CUES; cue++ )
+		{
+			struct model_cue *p = &m->cues[cue];
+
+			if ( back && p->state == MODEL_FIRED && p->position > position )
+			{
+				p->state = MODEL_PENDING;
+			}
+
+			if ( p->state == MODEL_PENDING && p->position <= position )
+			{
+				due[count++] = cue;
+			}
+		}
+
+		modelDispatchDue( c, due, count );
+	}
+}
+
+
+
+
+static void onCue( struct tc_cue *cue, enum TC_CUE_EVENT event, uint32_t now )
+{
+	struct check *c = cue->user;
+
+	int index = (int)( cue - c->cues );
+
+	logEvent( &c->real, now, index, event );
+
+	if ( event == TC_CUE_FIRED && isChained( index ) )
+	{
+		tc_cue_insert( &c->sched, cue, chainPosition( index, now ) );
+	}
+}
+
+
+static int compareEvents( const void *a, const void *b )
+{
+	const struct check_event *x = a;
+	const struct check_event *y = b;
+
+	if ( x->now != y->now )  return ( x->now < y->now ) ? -1 : 1;
+	if ( x->cue != y->cue )  return ( x->cue < y->cue ) ? -1 : 1;
+
+	return 0;
+}
+
+
+/*
+ *	Cues due on the same frame may fire in any order : the logs are compared
+ *	once sorted by cue within each frame, and must be in frame order before.
+ */
+
+static int checkLogs( struct check *c, const char *what, unsigned long iteration )
+{
+	struct check_log *r = &c->real;
+	struct check_log *e = &c->expected;
+
+	int    bad = ( r->count != e->count || r->count > CHECK_EVENTS );
+	size_t i;
+
+	for ( i = 1; !bad && i < r->count; i++ )
+	{
+		bad = ( r->events[i].now < r->events[i-1].now );
+	}
+
+	if ( !bad )
+	{
+		qsort( r->events, r->count, sizeof(struct check_event), compareEvents );
+		qsort( e->events, e->count, sizeof(struct check_event), compareEvents );
+
+		bad = ( memcmp( r->events, e->events, r->count * sizeof(struct check_event) ) != 0 );
+	}
+
+	if ( bad )
+	{
+		fprintf( stderr, "#%lu %s : %zu events, %zu expected\n", iteration, what, r->count, e->count );
+
+		for ( i = 0; i < r->count || i < e->count; i++ )
+		{
+			if ( i < CHECK_EVENTS && i < r->count )  fprintf( stderr, "  got      cue %2u %s at %u\n", r->events[i].cue, ( r->events[i].event == TC_CUE_FIRED ) ? "fired  " : "skipped", r->events[i].now );
+			if ( i < CHECK_EVENTS && i < e->count )  fprintf( stderr, "  expected cue %2u %s at %u\n", e->events[i].cue, ( e->events[i].event == TC_CUE_FIRED ) ? "fired  " : "skipped", e->events[i].now );
+		}
+
+		return -1;
+	}
+
+	for ( i = 0; i < r->count; i++ )
+	{
+		if ( r->events[i].event == TC_CUE_FIRED )  c->fired++;
+		else                                       c->skipped++;
+	}
+
+	r->count = 0;
+	e->count = 0;
+
+	return 0;
+}
+
+
+/* pending cues and their positions ; rearm cues behind the clock are FIRED */
+
+static int checkStates( struct check *c, const char *what, unsigned long iteration )
+{
+	size_t pending = 0;
+	int    cue;
+
+	for ( cue = 0; cue < CHECK_CUES; cue++ )
+	{
+		struct model_cue *m = &c->model.cues[cue];
+		struct tc_cue    *r = &c->cues[cue];
+
+		if ( r->state != m->state || ( m->state != MODEL_IDLE && r->position != m->position ) )
+		{
+			fprintf( stderr, "#%lu %s : cue %d is in state %d at %u, expected %d at %u\n", iteration, what, cue, r->state, r->position, m->state, m->position );
+			return -1;
+		}
+
+		pending += ( m->state == MODEL_PENDING );
+	}
+
+	if ( c->sched.now != c->model.now || c->sched.pending != pending )
+	{
+		fprintf( stderr, "#%lu %s : clock at %u with %zu pending, expected %u with %zu\n", iteration, what, c->sched.now, c->sched.pending, c->model.now, pending );
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+
+/* positions of timecodes : on the day within half a day of the clock */
+
+static int checkPositions( struct check *c )
+{
+	uint32_t day = c->sched.framesPerDay;
+	int      i;
+
+	for ( i = 0; i < 1000; i++ )
+	{
+		struct timecode tc;
+
+		tc_set_by_frames( &tc, nextRandom( c ) % day, c->sched.format );
+
+		uint32_t position = tc_cue_position( &c->sched, &tc );
+		int64_t  distance = (int64_t)position - (int64_t)c->sched.now;
+		int64_t  half     = day / 2;
+
+		/* only the first day can't go back one */
+
+		if ( position % day != (uint32_t)tc.frameNumber || distance < -half || ( distance > half && position >= day ) )
+		{
+			fprintf( stderr, "%s is at %u with the clock at %u\n", tc.string, position, c->sched.now );
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+
+/* a position around the clock, sometimes not after it */
+
+static uint32_t randomPosition( struct check *c )
+{
+	uint32_t now      = c->sched.now;
+	uint32_t distance = randomDistance( c );
+
+	if ( nextRandom( c ) % 16 == 0 )
+	{
+		return ( distance < now ) ? now - distance + 1 : 0;
+	}
+
+	return now + distance;
+}
+
+
+static int run( struct check *c, unsigned long iterations )
+{
+	unsigned long iteration = 0;
+
+	for ( ; iteration < iterations; iteration++ )
+	{
+		uint32_t     op   = nextRandom( c ) % 100;
+		int          cue  = (int)( nextRandom( c ) % CHECK_CUES );
+		uint32_t     now  = c->sched.now;
+		const char  *what = NULL;
+
+		if ( op < 40 )
+		{
+			/* play, one frame past the chase being a locate */
+
+			uint32_t position = now + 1 + nextRandom( c ) % ( c->sched.chase + 1 );
+
+			tc_cue_update( &c->sched, position );
+			modelUpdate( c, position );
+
+			what = "play";
+		}
+		else if ( op < 50 )
+		{
+			uint32_t distance = randomDistance( c );
+			uint32_t position = ( nextRandom( c ) % 2 ) ? now + distance : ( distance < now ) ? now - distance : 0;
+
+			tc_cue_update( &c->sched, position );
+			modelUpdate( c, position );
+
+			what = "locate";
+		}
+		else if ( op < 52 )
+		{
+			tc_cue_update( &c->sched, now );
+			modelUpdate( c, now );
+
+			what = "update in place";
+		}
+		else if ( op < 70 )
+		{
+			uint32_t position = randomPosition( c );
+
+			if ( tc_cue_insert( &c->sched, &c->cues[cue], position ) != modelInsert( &c->model, cue, position ) )
+			{
+				fprintf( stderr, "#%lu insert : cue %d at %u returned another value\n", iteration, cue, position );
+				return -1;
+			}
+
+			what = "insert";
+		}
+		else if ( op < 78 )
+		{
+			if ( tc_cue_cancel( &c->sched, &c->cues[cue] ) != modelCancel( &c->model, cue ) )
+			{
+				fprintf( stderr, "#%lu cancel : cue %d returned another value\n", iteration, cue );
+				return -1;
+			}
+
+			what = "cancel";
+		}
+		else if ( op < 92 )
+		{
+			uint32_t position = randomPosition( c );
+
+			tc_cue_post_insert( &c->sched, &c->cues[cue], position );
+			modelPost( &c->model, cue, MODEL_INSERT, position );
+
+			what = "post insert";
+		}
+		else
+		{
+			tc_cue_post_cancel( &c->sched, &c->cues[cue] );
+			modelPost( &c->model, cue, MODEL_CANCEL, 0 );
+
+			what = "post cancel";
+		}
+
+		c->updates += ( op < 52 );
+
+		if ( checkLogs( c, what, iteration ) < 0 || checkStates( c, what, iteration ) < 0 )
+		{
+			return -1;
+		}
+
+		if ( iteration % 1024 == 0 && checkPositions( c ) < 0 )
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+
+int main( int argc, char *argv[] )
+{
+	unsigned long seed       = ( argc > 1 ) ? strtoul( argv[1], NULL, 10 ) : 1;
+	unsigned long iterations = ( argc > 2 ) ? strtoul( argv[2], NULL, 10 ) : CHECK_ITERATIONS;
+
+	static struct check c;
+
+	memset( &c, 0x00, sizeof(struct check) );
+
+	c.rng = 0x9e3779b97f4a7c15ULL ^ seed;
+
+	if ( tc_cue_init( &c.sched, TC_29_97_DF ) < 0 )
+	{
+		fprintf( stderr, "Could not init the scheduler.\n" );
+		return 1;
+	}
+
+	int i = 0;
+
+	for ( ; i < CHECK_CUES; i++ )
+	{
+		c.cues[i].callback = onCue;
+		c.cues[i].user     = &c;
+		c.cues[i].rearm    = isRearm( i );
+	}
+
+	/* cues inserted before the first update, which is a locate */
+
+	for ( i = 0; i < CHECK_CUES; i += 2 )
+	{
+		uint32_t position = CHECK_START - 64 + nextRandom( &c ) % 256;
+
+		tc_cue_insert( &c.sched, &c.cues[i], position );
+		modelInsert( &c.model, i, position );
+	}
+
+	tc_cue_update( &c.sched, CHECK_START );
+	modelUpdate( &c, CHECK_START );
+
+	if ( checkLogs( &c, "start", 0 ) < 0 || checkStates( &c, "start", 0 ) < 0 || run( &c, iterations ) < 0 )
+	{
+		fprintf( stderr, "tcCue : failed with seed %lu.\n", seed );
+		return 1;
+	}
+
+	printf( "tcCue : %llu updates, %llu cues fired, %llu skipped, clock at %u : ok\n", c.updates, c.fired, c.skipped, c.sched.now );
+
+	return 0;
+}